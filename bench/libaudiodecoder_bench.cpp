@@ -0,0 +1,678 @@
+/*
+ * libaudiodecoder_bench - Measures open() time, decoding speed, and seek
+ *                         latency and accuracy, on a generated corpus.
+ *
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+
+/*
+ * Usage: libaudiodecoder_bench [--corpus dir] [--out results.json]
+ *                              [--seconds n] [--seeks n] [file ...]
+ *
+ * Writes a deterministic corpus into the corpus directory (WAV at several
+ * bit depths and sample rates, plus AAC where the platform can encode it),
+ * adds any files given on the command line, and benchmarks each one:
+ *
+ *   open_ms            median time to construct and open() a decoder
+ *   decode_xrt         read() speed in multiples of realtime
+ *   view_xrt           the same through readView()
+ *   seek_us            seek() plus the first read() after it, percentiles
+ *   seek_error_frames  how far from the target the audio after a seek
+ *                      really starts, against a linear decode of the file
+ *
+ * It also times the PCM-to-float converters (audiodecoderconvert.h) for
+ * each bit depth and channel count against a generic loop that looks at
+ * the format for every sample, in millions of samples per second.
+ *
+ * The results are written as JSON so runs can be compared.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#include <mfapi.h>
+#include <mfidl.h>
+#include <mfreadwrite.h>
+#else
+#include <sys/stat.h>
+#endif
+#ifdef __APPLE__
+#include <AudioToolbox/AudioToolbox.h>
+#endif
+#include "audiodecoder.h"
+#include "audiodecoderconvert.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+const int kOpenRuns = 5;
+const int kReadSize = 8192;        // samples per read() in the decode pass
+const int kSeekReadFrames = 1024;  // what's read after each seek
+const int kSeekSearchFrames = 4096; // how far off a seek can be and still be found
+const int kMatchSamples = 256;
+const int kConvertFrames = 4096;    // per converter call, about one decoded block
+
+struct CorpusFile
+{
+    std::string name;
+    std::string path;
+    std::string format;
+    int sampleRate;
+    int channels;
+    int bitsPerSample;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+static double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/** The test signal: two tones and some hashed noise, so that any stretch of
+    it is unique and a misplaced seek can't line up with the wrong place. */
+static float signalAt(long long frame, int channel, int sampleRate)
+{
+    unsigned int h = static_cast<unsigned int>(frame * 2654435761u) ^ (channel * 0x9E3779B9u);
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+    const float noise = (h & 0xFFFF) / 32768.0f - 1.0f;
+    const double t = static_cast<double>(frame) / sampleRate;
+    return static_cast<float>(0.3 * sin(2.0 * M_PI * 440.0 * t + channel)
+                              + 0.2 * sin(2.0 * M_PI * 3520.0 * t)
+                              + 0.2 * noise);
+}
+
+static void put16(std::vector<unsigned char>& out, int v)
+{
+    out.push_back(v & 0xFF);
+    out.push_back((v >> 8) & 0xFF);
+}
+
+static void put32(std::vector<unsigned char>& out, unsigned int v)
+{
+    put16(out, v & 0xFFFF);
+    put16(out, v >> 16);
+}
+
+static bool writeWav(const std::string& path, int sampleRate, int channels,
+                     int bitsPerSample, bool isFloat, int seconds)
+{
+    const long long frames = static_cast<long long>(sampleRate) * seconds;
+    const int bytesPerSample = bitsPerSample / 8;
+    const unsigned int dataSize = static_cast<unsigned int>(frames * channels * bytesPerSample);
+    std::vector<unsigned char> out;
+    out.reserve(44 + dataSize);
+    out.insert(out.end(), "RIFF", "RIFF" + 4);
+    put32(out, 36 + dataSize);
+    out.insert(out.end(), "WAVEfmt ", "WAVEfmt " + 8);
+    put32(out, 16);
+    put16(out, isFloat ? 3 : 1);
+    put16(out, channels);
+    put32(out, sampleRate);
+    put32(out, sampleRate * channels * bytesPerSample);
+    put16(out, channels * bytesPerSample);
+    put16(out, bitsPerSample);
+    out.insert(out.end(), "data", "data" + 4);
+    put32(out, dataSize);
+    for (long long f = 0; f < frames; f++) {
+        for (int c = 0; c < channels; c++) {
+            const float v = signalAt(f, c, sampleRate);
+            if (isFloat) {
+                unsigned int bits;
+                memcpy(&bits, &v, 4);
+                put32(out, bits);
+            } else {
+                const int full = static_cast<int>(floor(v * ((1 << (bitsPerSample - 1)) - 1) + 0.5));
+                for (int b = 0; b < bytesPerSample; b++) {
+                    out.push_back((full >> (8 * b)) & 0xFF);
+                }
+            }
+        }
+    }
+    FILE *file = fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    const bool ok = fwrite(&out[0], 1, out.size(), file) == out.size();
+    return fclose(file) == 0 && ok;
+}
+
+#if defined(__APPLE__)
+/** AAC in an .m4a through ExtAudioFile. */
+static bool writeAac(const std::string& path, int sampleRate, int channels, int seconds)
+{
+    CFURLRef url = CFURLCreateFromFileSystemRepresentation(NULL,
+        reinterpret_cast<const UInt8*>(path.c_str()), path.size(), false);
+    AudioStreamBasicDescription aac;
+    memset(&aac, 0, sizeof(aac));
+    aac.mFormatID = kAudioFormatMPEG4AAC;
+    aac.mSampleRate = sampleRate;
+    aac.mChannelsPerFrame = channels;
+    ExtAudioFileRef file = NULL;
+    OSStatus err = ExtAudioFileCreateWithURL(url, kAudioFileM4AType, &aac, NULL,
+                                             kAudioFileFlags_EraseFile, &file);
+    CFRelease(url);
+    if (err != noErr) {
+        return false;
+    }
+    AudioStreamBasicDescription pcm;
+    memset(&pcm, 0, sizeof(pcm));
+    pcm.mFormatID = kAudioFormatLinearPCM;
+    pcm.mFormatFlags = kAudioFormatFlagIsFloat | kAudioFormatFlagIsPacked;
+    pcm.mSampleRate = sampleRate;
+    pcm.mChannelsPerFrame = channels;
+    pcm.mBitsPerChannel = 32;
+    pcm.mFramesPerPacket = 1;
+    pcm.mBytesPerFrame = pcm.mBytesPerPacket = 4 * channels;
+    err = ExtAudioFileSetProperty(file, kExtAudioFileProperty_ClientDataFormat, sizeof(pcm), &pcm);
+
+    std::vector<float> block(4096 * channels);
+    const long long frames = static_cast<long long>(sampleRate) * seconds;
+    for (long long f = 0; err == noErr && f < frames; f += 4096) {
+        const UInt32 n = static_cast<UInt32>(std::min<long long>(4096, frames - f));
+        for (UInt32 i = 0; i < n; i++) {
+            for (int c = 0; c < channels; c++) {
+                block[i * channels + c] = signalAt(f + i, c, sampleRate);
+            }
+        }
+        AudioBufferList list;
+        list.mNumberBuffers = 1;
+        list.mBuffers[0].mNumberChannels = channels;
+        list.mBuffers[0].mDataByteSize = n * 4 * channels;
+        list.mBuffers[0].mData = &block[0];
+        err = ExtAudioFileWrite(file, n, &list);
+    }
+    return ExtAudioFileDispose(file) == noErr && err == noErr;
+}
+#elif defined(_WIN32)
+/** AAC in an .m4a through a Media Foundation sink writer. */
+static bool writeAac(const std::string& path, int sampleRate, int channels, int seconds)
+{
+    if (FAILED(CoInitializeEx(NULL, COINIT_MULTITHREADED)) || FAILED(MFStartup(MF_VERSION))) {
+        return false;
+    }
+    wchar_t wpath[MAX_PATH];
+    MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, wpath, MAX_PATH);
+
+    IMFSinkWriter *writer = NULL;
+    IMFMediaType *outType = NULL;
+    IMFMediaType *inType = NULL;
+    DWORD stream = 0;
+    HRESULT hr = MFCreateSinkWriterFromURL(wpath, NULL, NULL, &writer);
+    if (SUCCEEDED(hr)) hr = MFCreateMediaType(&outType);
+    if (SUCCEEDED(hr)) hr = outType->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Audio);
+    if (SUCCEEDED(hr)) hr = outType->SetGUID(MF_MT_SUBTYPE, MFAudioFormat_AAC);
+    if (SUCCEEDED(hr)) hr = outType->SetUINT32(MF_MT_AUDIO_BITS_PER_SAMPLE, 16);
+    if (SUCCEEDED(hr)) hr = outType->SetUINT32(MF_MT_AUDIO_SAMPLES_PER_SECOND, sampleRate);
+    if (SUCCEEDED(hr)) hr = outType->SetUINT32(MF_MT_AUDIO_NUM_CHANNELS, channels);
+    if (SUCCEEDED(hr)) hr = outType->SetUINT32(MF_MT_AUDIO_AVG_BYTES_PER_SECOND, 16000);
+    if (SUCCEEDED(hr)) hr = writer->AddStream(outType, &stream);
+    if (SUCCEEDED(hr)) hr = MFCreateMediaType(&inType);
+    if (SUCCEEDED(hr)) hr = inType->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Audio);
+    if (SUCCEEDED(hr)) hr = inType->SetGUID(MF_MT_SUBTYPE, MFAudioFormat_PCM);
+    if (SUCCEEDED(hr)) hr = inType->SetUINT32(MF_MT_AUDIO_BITS_PER_SAMPLE, 16);
+    if (SUCCEEDED(hr)) hr = inType->SetUINT32(MF_MT_AUDIO_SAMPLES_PER_SECOND, sampleRate);
+    if (SUCCEEDED(hr)) hr = inType->SetUINT32(MF_MT_AUDIO_NUM_CHANNELS, channels);
+    if (SUCCEEDED(hr)) hr = inType->SetUINT32(MF_MT_AUDIO_BLOCK_ALIGNMENT, 2 * channels);
+    if (SUCCEEDED(hr)) hr = inType->SetUINT32(MF_MT_AUDIO_AVG_BYTES_PER_SECOND, 2 * channels * sampleRate);
+    if (SUCCEEDED(hr)) hr = writer->SetInputMediaType(stream, inType, NULL);
+    if (SUCCEEDED(hr)) hr = writer->BeginWriting();
+
+    const long long frames = static_cast<long long>(sampleRate) * seconds;
+    const LONGLONG hundredNs = 10000000;
+    for (long long f = 0; SUCCEEDED(hr) && f < frames; f += 4096) {
+        const DWORD n = static_cast<DWORD>(std::min<long long>(4096, frames - f));
+        IMFMediaBuffer *buffer = NULL;
+        IMFSample *sample = NULL;
+        BYTE *data = NULL;
+        hr = MFCreateMemoryBuffer(n * 2 * channels, &buffer);
+        if (SUCCEEDED(hr)) hr = buffer->Lock(&data, NULL, NULL);
+        if (SUCCEEDED(hr)) {
+            short *pcm = reinterpret_cast<short*>(data);
+            for (DWORD i = 0; i < n; i++) {
+                for (int c = 0; c < channels; c++) {
+                    pcm[i * channels + c] = static_cast<short>(signalAt(f + i, c, sampleRate) * 32767.0f);
+                }
+            }
+            buffer->Unlock();
+            hr = buffer->SetCurrentLength(n * 2 * channels);
+        }
+        if (SUCCEEDED(hr)) hr = MFCreateSample(&sample);
+        if (SUCCEEDED(hr)) hr = sample->AddBuffer(buffer);
+        if (SUCCEEDED(hr)) hr = sample->SetSampleTime(f * hundredNs / sampleRate);
+        if (SUCCEEDED(hr)) hr = sample->SetSampleDuration(n * hundredNs / sampleRate);
+        if (SUCCEEDED(hr)) hr = writer->WriteSample(stream, sample);
+        if (sample) sample->Release();
+        if (buffer) buffer->Release();
+    }
+    if (SUCCEEDED(hr)) hr = writer->Finalize();
+    if (inType) inType->Release();
+    if (outType) outType->Release();
+    if (writer) writer->Release();
+    MFShutdown();
+    return SUCCEEDED(hr);
+}
+#else
+static bool writeAac(const std::string&, int, int, int) { return false; }
+#endif
+
+static std::vector<CorpusFile> makeCorpus(const std::string& dir, int seconds)
+{
+#ifdef _WIN32
+    CreateDirectoryA(dir.c_str(), NULL);
+#else
+    mkdir(dir.c_str(), 0755);
+#endif
+    struct Spec { const char *format; int sampleRate; int channels; int bits; bool isFloat; };
+    const Spec specs[] = {
+        { "wav", 44100, 2, 16, false },
+        { "wav", 22050, 1, 16, false },
+        { "wav", 48000, 2, 24, false },
+        { "wav", 96000, 2, 32, true },
+        { "aac", 44100, 2, 16, false },
+    };
+    std::vector<CorpusFile> corpus;
+    for (size_t i = 0; i < sizeof(specs) / sizeof(specs[0]); i++) {
+        const Spec& spec = specs[i];
+        char name[64];
+        snprintf(name, sizeof(name), "%s_%s%d_%d_%dch", spec.format,
+                 spec.isFloat ? "f" : "s", spec.bits, spec.sampleRate, spec.channels);
+        CorpusFile file;
+        file.name = name;
+        file.format = spec.format;
+        file.sampleRate = spec.sampleRate;
+        file.channels = spec.channels;
+        file.bitsPerSample = spec.bits;
+        bool ok;
+        if (file.format == "wav") {
+            file.path = dir + "/" + name + ".wav";
+            ok = writeWav(file.path, spec.sampleRate, spec.channels, spec.bits, spec.isFloat, seconds);
+        } else {
+            file.path = dir + "/" + name + ".m4a";
+            ok = writeAac(file.path, spec.sampleRate, spec.channels, seconds);
+        }
+        if (ok) {
+            corpus.push_back(file);
+        } else if (file.format == "wav") {
+            fprintf(stderr, "Couldn't write %s\n", file.path.c_str());
+        }
+    }
+    return corpus;
+}
+
+struct Result
+{
+    bool ok;
+    int sampleRate;
+    int channels;
+    double duration;
+    double openMs;
+    double decodeXrt;
+    double viewXrt;
+    std::vector<double> seekUs;
+    std::vector<int> seekErrors; // frames; INT_MAX when the audio wasn't found nearby
+};
+
+/** Where the block read after a seek to targetFrame really starts, relative
+    to targetFrame, judged against a linear decode of the whole file. */
+static int seekError(const std::vector<SAMPLE>& reference, const SAMPLE *block,
+                     int blockSamples, long long targetFrame, int channels)
+{
+    const int samples = std::min(blockSamples, kMatchSamples) / channels * channels;
+    const long long totalFrames = reference.size() / channels;
+    if (samples <= 0) {
+        return INT_MAX;
+    }
+    double best = 1e30;
+    int bestOffset = INT_MAX;
+    for (int distance = 0; distance <= kSeekSearchFrames; distance++) {
+        for (int sign = 1; sign >= -1; sign -= 2) {
+            const long long frame = targetFrame + sign * distance;
+            if (frame < 0 || frame + samples / channels > totalFrames) {
+                continue;
+            }
+            const SAMPLE *ref = &reference[frame * channels];
+            double sum = 0;
+            for (int i = 0; i < samples && sum < best; i++) {
+                sum += fabs(ref[i] - block[i]);
+            }
+            if (sum < best) {
+                best = sum;
+                bestOffset = sign * distance;
+            }
+            if (distance == 0) {
+                break;
+            }
+        }
+        if (best < 1e-6) {
+            break; // exact; nothing further away will do better
+        }
+    }
+    //Lossy codecs won't match exactly, but a real match is far closer than chance.
+    return best / samples < 0.01 ? bestOffset : INT_MAX;
+}
+
+static Result benchmark(const std::string& path, int seeks)
+{
+    Result result;
+    result.ok = false;
+    result.sampleRate = result.channels = 0;
+    result.duration = result.openMs = result.decodeXrt = result.viewXrt = 0;
+
+    std::vector<double> openMs;
+    for (int i = 0; i < kOpenRuns; i++) {
+        Clock::time_point start = Clock::now();
+        AudioDecoder decoder(path);
+        const int err = decoder.open();
+        openMs.push_back(secondsSince(start) * 1000.0);
+        if (err != AUDIODECODER_OK) {
+            return result;
+        }
+    }
+    std::sort(openMs.begin(), openMs.end());
+    result.openMs = openMs[openMs.size() / 2];
+
+    //Linear decode, which doubles as the reference for seek accuracy.
+    AudioDecoder decoder(path);
+    if (decoder.open() != AUDIODECODER_OK) {
+        return result;
+    }
+    result.sampleRate = decoder.sampleRate();
+    result.channels = decoder.channels();
+    std::vector<SAMPLE> reference;
+    reference.reserve(decoder.numSamples() + kReadSize);
+    std::vector<SAMPLE> buffer(kReadSize);
+    Clock::time_point start = Clock::now();
+    int samplesRead;
+    while ((samplesRead = decoder.read(kReadSize, &buffer[0])) > 0) {
+        reference.insert(reference.end(), buffer.begin(), buffer.begin() + samplesRead);
+    }
+    const double decodeSeconds = secondsSince(start);
+    result.duration = static_cast<double>(reference.size()) / (result.channels * result.sampleRate);
+    result.decodeXrt = decodeSeconds > 0 ? result.duration / decodeSeconds : 0;
+
+    AudioDecoder viewDecoder(path);
+    if (viewDecoder.open() == AUDIODECODER_OK) {
+        AudioDecoderView view;
+        start = Clock::now();
+        while (viewDecoder.readView(&view) > 0) {}
+        const double viewSeconds = secondsSince(start);
+        result.viewXrt = viewSeconds > 0 ? result.duration / viewSeconds : 0;
+    }
+
+    //Seeks to deterministic pseudo-random frames, each followed by a read.
+    const long long totalFrames = reference.size() / result.channels;
+    unsigned int lcg = 12345;
+    std::vector<SAMPLE> block(kSeekReadFrames * result.channels);
+    for (int i = 0; i < seeks && totalFrames > kSeekReadFrames; i++) {
+        lcg = lcg * 1664525u + 1013904223u;
+        const long long target = (lcg >> 8) % (totalFrames - kSeekReadFrames);
+        start = Clock::now();
+        decoder.seek(static_cast<int>(target * result.channels));
+        const int got = decoder.read(static_cast<int>(block.size()), &block[0]);
+        result.seekUs.push_back(secondsSince(start) * 1e6);
+        result.seekErrors.push_back(seekError(reference, &block[0], got, target, result.channels));
+    }
+    result.ok = true;
+    return result;
+}
+
+/** The baseline for the converters: one loop for every format, deciding
+    how to read each sample as it goes. */
+static void convertGeneric(const unsigned char *src, SAMPLE *dest, size_t frames,
+                           int channels, int bitsPerSample)
+{
+    const int bytes = bitsPerSample / 8;
+    const float scale = ldexpf(1.0f, 1 - bitsPerSample);
+    for (size_t f = 0; f < frames; f++) {
+        for (int c = 0; c < channels; c++) {
+            const unsigned char *s = src + (f * channels + c) * bytes;
+            int v;
+            switch (bitsPerSample) {
+                case 8:  v = s[0] - 128; break;
+                case 16: v = static_cast<short>(s[0] | (s[1] << 8)); break;
+                case 24: v = static_cast<int>(s[0] << 8 | s[1] << 16 | static_cast<unsigned>(s[2]) << 24) >> 8; break;
+                default: memcpy(&v, s, sizeof(v)); break;
+            }
+            dest[f * channels + c] = v * scale;
+        }
+    }
+}
+
+struct ConvertResult
+{
+    int bitsPerSample;
+    int channels;
+    double genericMsps;
+    double specializedMsps;
+};
+
+/** Millions of samples per second through both paths, for about a tenth of a second each. */
+static ConvertResult benchmarkConvert(int bitsPerSample, int channels)
+{
+    ConvertResult result;
+    result.bitsPerSample = bitsPerSample;
+    result.channels = channels;
+    std::vector<unsigned char> src(kConvertFrames * channels * (bitsPerSample / 8));
+    for (size_t i = 0; i < src.size(); i++) {
+        src[i] = static_cast<unsigned char>(i * 2654435761u >> 13);
+    }
+    std::vector<SAMPLE> dest(kConvertFrames * channels);
+    AudioDecoderConvert::Format format = AudioDecoderConvert::FORMAT_S16;
+    AudioDecoderConvert::formatForBits(bitsPerSample, &format);
+    const AudioDecoderConvertFn convert = AudioDecoderConvert::select(format, channels);
+
+    volatile SAMPLE sink = 0; // keeps the loops from being optimized away
+    for (int pass = 0; pass < 2; pass++) {
+        long long samples = 0;
+        const Clock::time_point start = Clock::now();
+        do {
+            for (int i = 0; i < 16; i++) {
+                if (pass == 0) {
+                    convertGeneric(&src[0], &dest[0], kConvertFrames, channels, bitsPerSample);
+                } else {
+                    convert(&src[0], &dest[0], kConvertFrames, channels);
+                }
+                sink = sink + dest[i];
+                samples += dest.size();
+            }
+        } while (secondsSince(start) < 0.1);
+        const double msps = samples / secondsSince(start) / 1e6;
+        (pass == 0 ? result.genericMsps : result.specializedMsps) = msps;
+    }
+    return result;
+}
+
+static double percentile(std::vector<double> values, double p)
+{
+    if (values.empty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    return values[static_cast<size_t>(p * (values.size() - 1) + 0.5)];
+}
+
+static std::string jsonString(const std::string& s)
+{
+    std::string out = "\"";
+    for (size_t i = 0; i < s.size(); i++) {
+        const char c = s[i];
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+static void writeResult(FILE *out, const CorpusFile& file, const Result& r, bool last)
+{
+    fprintf(out, "    {\n");
+    fprintf(out, "      \"name\": %s,\n", jsonString(file.name).c_str());
+    fprintf(out, "      \"path\": %s,\n", jsonString(file.path).c_str());
+    fprintf(out, "      \"format\": %s,\n", jsonString(file.format).c_str());
+    fprintf(out, "      \"ok\": %s", r.ok ? "true" : "false");
+    if (r.ok) {
+        int exact = 0, lost = 0, worst = 0;
+        double meanAbs = 0;
+        for (size_t i = 0; i < r.seekErrors.size(); i++) {
+            if (r.seekErrors[i] == INT_MAX) {
+                lost++;
+                continue;
+            }
+            const int e = abs(r.seekErrors[i]);
+            exact += e == 0;
+            worst = std::max(worst, e);
+            meanAbs += e;
+        }
+        const size_t found = r.seekErrors.size() - lost;
+        fprintf(out, ",\n");
+        fprintf(out, "      \"sample_rate\": %d,\n", r.sampleRate);
+        fprintf(out, "      \"channels\": %d,\n", r.channels);
+        fprintf(out, "      \"duration_s\": %.3f,\n", r.duration);
+        fprintf(out, "      \"open_ms\": %.3f,\n", r.openMs);
+        fprintf(out, "      \"decode_xrt\": %.1f,\n", r.decodeXrt);
+        fprintf(out, "      \"view_xrt\": %.1f,\n", r.viewXrt);
+        fprintf(out, "      \"seek_us\": { \"count\": %d, \"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f, \"max\": %.1f },\n",
+                static_cast<int>(r.seekUs.size()), percentile(r.seekUs, 0.5), percentile(r.seekUs, 0.9),
+                percentile(r.seekUs, 0.99), percentile(r.seekUs, 1.0));
+        fprintf(out, "      \"seek_error_frames\": { \"exact\": %d, \"not_found\": %d, \"mean_abs\": %.2f, \"max_abs\": %d }\n",
+                exact, lost, found ? meanAbs / found : 0.0, worst);
+    } else {
+        fprintf(out, "\n");
+    }
+    fprintf(out, "    }%s\n", last ? "" : ",");
+}
+
+int main(int argc, char *argv[])
+{
+    std::string corpusDir = "bench_corpus";
+    std::string outPath = "libaudiodecoder_bench.json";
+    int seconds = 30;
+    int seeks = 200;
+    std::vector<std::string> extraFiles;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--corpus" && i + 1 < argc) {
+            corpusDir = argv[++i];
+        } else if (arg == "--out" && i + 1 < argc) {
+            outPath = argv[++i];
+        } else if (arg == "--seconds" && i + 1 < argc) {
+            seconds = atoi(argv[++i]);
+        } else if (arg == "--seeks" && i + 1 < argc) {
+            seeks = atoi(argv[++i]);
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            fprintf(stderr, "Usage: %s [--corpus dir] [--out results.json] [--seconds n] [--seeks n] [file ...]\n", argv[0]);
+            return 1;
+        } else {
+            extraFiles.push_back(arg);
+        }
+    }
+
+    std::vector<CorpusFile> files = makeCorpus(corpusDir, seconds);
+    for (size_t i = 0; i < extraFiles.size(); i++) {
+        CorpusFile file;
+        file.name = file.path = extraFiles[i];
+        file.format = file.path.substr(file.path.find_last_of('.') + 1);
+        file.sampleRate = file.channels = file.bitsPerSample = 0;
+        files.push_back(file);
+    }
+
+    FILE *out = fopen(outPath.c_str(), "w");
+    if (!out) {
+        fprintf(stderr, "Couldn't write %s\n", outPath.c_str());
+        return 1;
+    }
+#if defined(_WIN32)
+    const char *backend = "mediafoundation";
+#elif defined(__APPLE__)
+    const char *backend = "coreaudio";
+#else
+    const char *backend = "unknown";
+#endif
+    fprintf(out, "{\n  \"benchmark\": \"libaudiodecoder_bench\",\n  \"version\": 1,\n");
+    fprintf(out, "  \"backend\": \"%s\",\n  \"seeks_per_file\": %d,\n  \"files\": [\n", backend, seeks);
+    bool allOk = true;
+    for (size_t i = 0; i < files.size(); i++) {
+        printf("%s...\n", files[i].name.c_str());
+        const Result result = benchmark(files[i].path, seeks);
+        allOk = allOk && result.ok;
+        if (result.ok) {
+            printf("  open %.2f ms, decode %.0fx realtime, seek p50 %.0f us\n",
+                   result.openMs, result.decodeXrt, percentile(result.seekUs, 0.5));
+        } else {
+            printf("  failed to decode\n");
+        }
+        writeResult(out, files[i], result, i + 1 == files.size());
+    }
+    fprintf(out, "  ],\n  \"conversions\": [\n");
+    const int depths[] = { 8, 16, 24, 32 };
+    const int channelCounts[] = { 1, 2, 6 };
+    for (int d = 0; d < 4; d++) {
+        for (int c = 0; c < 3; c++) {
+            const ConvertResult r = benchmarkConvert(depths[d], channelCounts[c]);
+            printf("convert %d-bit %dch: generic %.0f, specialized %.0f Msamples/s (%.1fx)\n",
+                   r.bitsPerSample, r.channels, r.genericMsps, r.specializedMsps,
+                   r.specializedMsps / r.genericMsps);
+            fprintf(out, "    { \"bits_per_sample\": %d, \"channels\": %d, \"generic_msps\": %.1f, "
+                    "\"specialized_msps\": %.1f, \"speedup\": %.2f }%s\n",
+                    r.bitsPerSample, r.channels, r.genericMsps, r.specializedMsps,
+                    r.specializedMsps / r.genericMsps, d == 3 && c == 2 ? "" : ",");
+        }
+    }
+    fprintf(out, "  ]\n}\n");
+    fclose(out);
+    printf("Results written to %s\n", outPath.c_str());
+    return allOk ? 0 : 1;
+}
@@ -49,6 +49,7 @@ class DllExport AudioDecoder : public AudioDecoderMediaFoundation
 {
     public:
         AudioDecoder(const std::string filename) : AudioDecoderMediaFoundation(filename) {};
+        AudioDecoder(AudioDecoderSource *source) : AudioDecoderMediaFoundation(source) {};
     private:
         //Disable copy constructor and assignment operator
         AudioDecoder(const AudioDecoder& that);
@@ -61,6 +62,7 @@ class AudioDecoder : public AudioDecoderCoreAudio
 {
     public:
         AudioDecoder(const std::string filename) : AudioDecoderCoreAudio(filename) {};
+        AudioDecoder(AudioDecoderSource *source) : AudioDecoderCoreAudio(source) {};
     private:
         //Disable copy constructor and assignment operator
         AudioDecoder(const AudioDecoder& that);
@@ -0,0 +1,170 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+/**
+ * \file audiodecoderallocator.h
+ * \class AudioDecoderAllocator
+ * \brief Where a decoder gets its memory from.
+ *
+ * Give a decoder an allocator with setAllocator() before open() and it
+ * makes every allocation of its own through it. Once open() has returned,
+ * the backends don't allocate at all in read() or seek(), for any read
+ * size; AudioDecoderCountingAllocator checks that for you:
+ *
+ *      AudioDecoderCountingAllocator counter;
+ *      decoder.setAllocator(&counter);
+ *      decoder.open();
+ *      counter.setForbidden(true); // any allocation from here on asserts
+ *
+ * It only sees what is allocated through the decoder's allocator. Memory
+ * that Media Foundation or CoreAudio allocate inside the codec, and any
+ * plain new or malloc, go straight past it; tests/test_allocator.cpp
+ * checks the part it can see.
+ *
+ * The built-in analysis sinks size everything in begin() and don't allocate
+ * either; sinks that collect output as they go, like the peak pyramid, do.
+ *
+ * The interface mirrors std::pmr::memory_resource, and
+ * AudioDecoderPmrAllocator adapts one. It's defined here in the header
+ * only when the code including it is C++17; the library builds as C++11.
+ */
+
+#ifndef AUDIODECODERALLOCATOR_H
+#define AUDIODECODERALLOCATOR_H
+
+#include <stddef.h>
+#include <atomic>
+#include "audiodecoderbase.h"
+
+#if defined(__has_include)
+#if __has_include(<memory_resource>) && __cplusplus >= 201703L
+#include <memory_resource>
+#define AUDIODECODER_HAVE_PMR
+#endif
+#endif
+
+class DllExport AudioDecoderAllocator
+{
+    public:
+        static const size_t kDefaultAlignment = 2 * sizeof(void*);
+
+        virtual ~AudioDecoderAllocator() {};
+
+        /** Returns NULL when the memory can't be had. */
+        virtual void *allocate(size_t bytes, size_t alignment = kDefaultAlignment) = 0;
+        virtual void deallocate(void *p, size_t bytes, size_t alignment = kDefaultAlignment) = 0;
+
+        /** Plain operator new and delete; what decoders use unless told otherwise. */
+        static AudioDecoderAllocator *heap();
+};
+
+/** Hands out memory from a caller-supplied buffer, front to back. deallocate()
+    does nothing; reset() makes the whole buffer available again. When the
+    buffer runs out it falls back to upstream, if there is one. */
+class DllExport AudioDecoderArena : public AudioDecoderAllocator
+{
+    public:
+        AudioDecoderArena(void *buffer, size_t size, AudioDecoderAllocator *upstream = NULL);
+
+        virtual void *allocate(size_t bytes, size_t alignment = kDefaultAlignment);
+        virtual void deallocate(void *p, size_t bytes, size_t alignment = kDefaultAlignment);
+
+        /** Forgets every allocation. Whatever came from upstream isn't given back. */
+        void reset() { m_used = 0; };
+        size_t used() const { return m_used; };
+
+    private:
+        unsigned char *m_pBuffer;
+        size_t m_size;
+        size_t m_used;
+        AudioDecoderAllocator *m_pUpstream;
+        //Disable copy constructor and assignment
+        AudioDecoderArena(const AudioDecoderArena&);
+        AudioDecoderArena& operator=(const AudioDecoderArena&);
+};
+
+/** Counts what passes through it on the way to upstream. While forbidden,
+    any allocation is counted as a violation and asserts in debug builds. */
+class DllExport AudioDecoderCountingAllocator : public AudioDecoderAllocator
+{
+    public:
+        AudioDecoderCountingAllocator(AudioDecoderAllocator *upstream = heap());
+
+        virtual void *allocate(size_t bytes, size_t alignment = kDefaultAlignment);
+        virtual void deallocate(void *p, size_t bytes, size_t alignment = kDefaultAlignment);
+
+        void setForbidden(bool forbidden) { m_forbidden = forbidden; };
+
+        long long allocations() const { return m_allocations; };
+        long long deallocations() const { return m_deallocations; };
+        long long bytesInUse() const { return m_bytesInUse; };
+        long long violations() const { return m_violations; };
+
+    private:
+        AudioDecoderAllocator *m_pUpstream;
+        std::atomic<bool> m_forbidden;
+        std::atomic<long long> m_allocations;
+        std::atomic<long long> m_deallocations;
+        std::atomic<long long> m_bytesInUse;
+        std::atomic<long long> m_violations;
+};
+
+#ifdef AUDIODECODER_HAVE_PMR
+/** Lets a decoder allocate from a std::pmr::memory_resource. */
+class AudioDecoderPmrAllocator : public AudioDecoderAllocator
+{
+    public:
+        AudioDecoderPmrAllocator(std::pmr::memory_resource *resource) : m_pResource(resource) {};
+
+        virtual void *allocate(size_t bytes, size_t alignment = kDefaultAlignment) {
+            try {
+                return m_pResource->allocate(bytes, alignment);
+            } catch (...) {
+                return NULL;
+            }
+        };
+        virtual void deallocate(void *p, size_t bytes, size_t alignment = kDefaultAlignment) {
+            m_pResource->deallocate(p, bytes, alignment);
+        };
+
+    private:
+        std::pmr::memory_resource *m_pResource;
+};
+#endif
+
+#endif // ifndef AUDIODECODERALLOCATOR_H
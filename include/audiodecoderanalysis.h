@@ -0,0 +1,182 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+/**
+ * \file audiodecoderanalysis.h
+ * \brief Analysis sinks: loudness, true peak, RMS and silence bounds.
+ *
+ * Each of these is an AudioDecoderSink, so any number of them can be
+ * attached to one decoder with addSink() and measured in the same pass:
+ *
+ *      AudioDecoderLoudnessSink loudness;
+ *      AudioDecoderTruePeakSink peak;
+ *      AudioDecoderSilenceSink silence;
+ *      decoder.addSink(&loudness); decoder.addSink(&peak); decoder.addSink(&silence);
+ *      decoder.open();
+ *      while (decoder.read(size, buffer) > 0) {}
+ *      loudness.integratedLoudness(); ...
+ *
+ * The results are valid at any point during the decode, covering what has
+ * been read so far.
+ */
+
+#ifndef AUDIODECODERANALYSIS_H
+#define AUDIODECODERANALYSIS_H
+
+#include "audiodecodersink.h"
+
+/** Loudness in LUFS as in EBU R128 / ITU-R BS.1770: K-weighted, with 400 ms
+    momentary and 3 s short-term windows and the two-stage gate for the
+    integrated value. Loudness of silence is -HUGE_VAL. */
+class DllExport AudioDecoderLoudnessSink : public AudioDecoderSink
+{
+    public:
+        AudioDecoderLoudnessSink();
+
+        virtual void begin(int channels, int sampleRate);
+        virtual void process(const SAMPLE *buffer, int size);
+        virtual void seeked(int sampleIdx);
+
+        /** Gated loudness of everything read so far. */
+        double integratedLoudness() const;
+        /** Loudness of the last 400 ms, and the loudest 400 ms so far. */
+        double momentaryLoudness() const;
+        double maxMomentaryLoudness() const { return m_maxMomentary; };
+        /** Loudness of the last 3 s, and the loudest 3 s so far. */
+        double shortTermLoudness() const;
+        double maxShortTermLoudness() const { return m_maxShortTerm; };
+
+    private:
+        struct Biquad {
+            double b0, b1, b2, a1, a2;
+        };
+
+        void resetFilters();
+        void addGatingBlock(double power);
+        double windowPower(int subBlocks) const;
+
+        Biquad m_shelf;
+        Biquad m_highPass;
+        std::vector<double> m_state;      // 4 per channel: two per biquad
+        std::vector<double> m_weights;    // per channel
+        std::vector<double> m_subBlockSum; // per channel, the 100 ms being filled
+        int m_iChannels;
+        int m_iSubBlockFrames;
+        int m_iFramesInSubBlock;
+        std::vector<double> m_recent;     // weighted power of the last 30 sub-blocks, a ring
+        int m_iRecentCount;
+        int m_iRecentNext;
+        std::vector<long long> m_histogramCount; // 400 ms gating blocks, by loudness
+        std::vector<double> m_histogramPower;
+        double m_maxMomentary;
+        double m_maxShortTerm;
+};
+
+/** The highest sample and true (4x oversampled, inter-sample) peak per
+    channel, as linear values. */
+class DllExport AudioDecoderTruePeakSink : public AudioDecoderSink
+{
+    public:
+        AudioDecoderTruePeakSink();
+
+        virtual void begin(int channels, int sampleRate);
+        virtual void process(const SAMPLE *buffer, int size);
+        virtual void seeked(int sampleIdx);
+
+        double samplePeak(int channel) const { return m_samplePeak[channel]; };
+        double truePeak(int channel) const { return m_truePeak[channel]; };
+        /** The highest true peak over all channels, in dBTP. */
+        double truePeakDb() const;
+
+    private:
+        void oversample(const SAMPLE *buffer, int frames);
+
+        std::vector<float> m_history; // the last kTaps - 1 samples of each channel
+        std::vector<float> m_scratch;
+        std::vector<double> m_samplePeak;
+        std::vector<double> m_truePeak;
+        std::vector<double> m_sumSquares; // not reported, accumulateFrames() wants somewhere to put it
+        int m_iChannels;
+};
+
+/** Root mean square level per channel and over all channels. */
+class DllExport AudioDecoderRmsSink : public AudioDecoderSink
+{
+    public:
+        AudioDecoderRmsSink();
+
+        virtual void begin(int channels, int sampleRate);
+        virtual void process(const SAMPLE *buffer, int size);
+
+        double rms(int channel) const;
+        double rms() const;
+        /** rms() in dBFS. */
+        double rmsDb() const;
+
+    private:
+        std::vector<double> m_sumSquares;
+        std::vector<double> m_peaks;
+        long long m_frames;
+        int m_iChannels;
+};
+
+/** Finds the first and last frame louder than a threshold, for trimming
+    leading and trailing silence. */
+class DllExport AudioDecoderSilenceSink : public AudioDecoderSink
+{
+    public:
+        /** @param thresholdDb Any sample above this level (dBFS) counts as sound. */
+        AudioDecoderSilenceSink(double thresholdDb = -60.0);
+
+        virtual void begin(int channels, int sampleRate);
+        virtual void process(const SAMPLE *buffer, int size);
+        virtual void seeked(int sampleIdx);
+
+        /** Frame numbers; -1 when nothing above the threshold has been read. */
+        long long firstSoundFrame() const { return m_firstSound; };
+        long long lastSoundFrame() const { return m_lastSound; };
+
+    private:
+        float m_threshold;
+        int m_iChannels;
+        long long m_frame;
+        long long m_firstSound;
+        long long m_lastSound;
+};
+
+#endif // ifndef AUDIODECODERANALYSIS_H
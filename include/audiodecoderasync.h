@@ -0,0 +1,202 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+
+/**
+ * \file audiodecoderasync.h
+ * \class AudioDecoderAsync
+ * \brief Non-blocking open(), seek() and read(), with callbacks or C++20
+ *        coroutines.
+ *
+ * Everything in AudioDecoderBase blocks. To keep a UI or network thread
+ * responsive, wrap the decoder in an AudioDecoderAsync and the calls run
+ * on an executor instead:
+ *
+ *     AudioDecoderAsync async(&decoder, &myExecutor);
+ *     async.openAsync([&](int result) { ... });
+ *
+ * or, when the compiler supports coroutines:
+ *
+ *     if (co_await async.openAsync() == AUDIODECODER_OK) {
+ *         int samplesRead = co_await async.readAsync(size, buffer);
+ *     }
+ *
+ * Calls on one AudioDecoderAsync run one at a time and in the order they
+ * were made, even on an executor with many threads. Callbacks, and
+ * coroutines after co_await, carry on on the executor's thread. Don't use
+ * the decoder directly while an AudioDecoderAsync has it.
+ */
+
+#ifndef AUDIODECODERASYNC_H
+#define AUDIODECODERASYNC_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "audiodecoderbase.h"
+
+//Nested, as older preprocessors choke on __has_include().
+#if defined(__cpp_impl_coroutine)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#define AUDIODECODER_HAS_COROUTINES 1
+#endif
+#endif
+
+class AudioDecoder;
+
+/** Runs work somewhere else. Implement it on top of your own thread pool,
+    so decoding shares your threads instead of spawning more. */
+class DllExport AudioDecoderExecutor
+{
+    public:
+        virtual ~AudioDecoderExecutor() {};
+
+        /** Run work, on any thread, as soon as possible. Must not block. */
+        virtual void execute(std::function<void()> work) = 0;
+
+        /** The one used when you don't pass your own: a single thread of its
+            own, started on first use. */
+        static AudioDecoderExecutor *defaultExecutor();
+};
+
+/** A plain fixed-size thread pool, if you don't have one already. */
+class DllExport AudioDecoderThreadPoolExecutor : public AudioDecoderExecutor
+{
+    public:
+        AudioDecoderThreadPoolExecutor(int numThreads = 1);
+        /** Finishes the work already queued, then stops the threads. */
+        ~AudioDecoderThreadPoolExecutor();
+
+        void execute(std::function<void()> work);
+
+    private:
+        void workerLoop();
+
+        //Disable copy constructor and assignment operator
+        AudioDecoderThreadPoolExecutor(const AudioDecoderThreadPoolExecutor& that);
+        AudioDecoderThreadPoolExecutor& operator=(AudioDecoderThreadPoolExecutor const&);
+
+        std::deque<std::function<void()> > m_queue;
+        std::vector<std::thread> m_threads;
+        bool m_quit;
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+};
+
+class DllExport AudioDecoderAsync
+{
+    public:
+        /** Called with what the blocking call returned. */
+        typedef std::function<void(int result)> Callback;
+
+        /** @param executor Where the calls run; NULL for AudioDecoderExecutor::defaultExecutor(). */
+        AudioDecoderAsync(AudioDecoder *decoder, AudioDecoderExecutor *executor = NULL);
+
+        /** Waits for the calls already made to finish. Don't destroy it from
+            one of its own callbacks. */
+        ~AudioDecoderAsync();
+
+        void openAsync(Callback done);
+        void seekAsync(int sampleIdx, Callback done);
+        /** buffer must stay valid until done is called. */
+        void readAsync(int size, SAMPLE *buffer, Callback done);
+
+        AudioDecoder *decoder() const { return m_pDecoder; };
+
+#ifdef AUDIODECODER_HAS_COROUTINES
+        /** co_await one of these for the result of the call. */
+        class Awaitable
+        {
+            public:
+                Awaitable(std::function<void(Callback)> start) : m_start(start), m_result(AUDIODECODER_ERROR) {}
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(std::coroutine_handle<> handle)
+                {
+                    //The callback can resume the coroutine on another thread,
+                    //which ends the co_await and destroys this Awaitable,
+                    //before start() has returned. So start() mustn't live
+                    //in it, and nothing here may touch this after the call.
+                    std::function<void(Callback)> start = std::move(m_start);
+                    start([this, handle](int result) {
+                        m_result = result;
+                        handle.resume();
+                    });
+                }
+                int await_resume() const noexcept { return m_result; }
+
+            private:
+                std::function<void(Callback)> m_start;
+                int m_result;
+        };
+
+        Awaitable openAsync()
+        {
+            return Awaitable([this](Callback done) { openAsync(done); });
+        }
+        Awaitable seekAsync(int sampleIdx)
+        {
+            return Awaitable([this, sampleIdx](Callback done) { seekAsync(sampleIdx, done); });
+        }
+        Awaitable readAsync(int size, SAMPLE *buffer)
+        {
+            return Awaitable([this, size, buffer](Callback done) { readAsync(size, buffer, done); });
+        }
+#endif
+
+    private:
+        void enqueue(std::function<void()> call);
+        void drain();
+
+        //Disable copy constructor and assignment operator
+        AudioDecoderAsync(const AudioDecoderAsync& that);
+        AudioDecoderAsync& operator=(AudioDecoderAsync const&);
+
+        AudioDecoder *m_pDecoder;
+        AudioDecoderExecutor *m_pExecutor;
+        std::deque<std::function<void()> > m_calls; // waiting their turn
+        bool m_running; // a drain() is queued on or running on the executor
+        std::mutex m_mutex;
+        std::condition_variable m_finished;
+};
+
+#endif //AUDIODECODERASYNC_H
@@ -52,10 +52,36 @@
 //Types
 typedef float SAMPLE;
 
+class AudioDecoderSource;
+class AudioDecoderSink;
+class AudioDecoderAllocator;
+
 //Error codes
 #define AUDIODECODER_ERROR -1
 #define AUDIODECODER_OK     0
 
+#include "audiodecodermetrics.h"
+
+/** A block of decoded audio lent out by readView(). It points into the
+    decoder and is only valid until the next call on that decoder. */
+struct AudioDecoderView
+{
+    enum Format {
+        FORMAT_FLOAT, // SAMPLE, as read() returns
+        FORMAT_INT16  // short, as the codec produced it
+    };
+
+    const void *data;
+    Format format;
+    int frames;
+    int channels;
+    int position; // in samples, of the first frame
+
+    inline int size() const { return frames * channels; };
+    inline const SAMPLE *floats() const { return static_cast<const SAMPLE*>(data); };
+    inline const short *shorts() const { return static_cast<const short*>(data); };
+};
+
 /** 
 A word on real-time safety: 
 At present, all API calls are blocking and none are considered real-time safe. For best performance,
@@ -66,11 +92,36 @@ class DllExport AudioDecoderBase
 {
     public:
         AudioDecoderBase(const std::string filename);
+
+        /** Construct a decoder that reads from a source you own instead of a
+            named file (see audiodecodersource.h). The source must outlive the decoder. */
+        AudioDecoderBase(AudioDecoderSource *source);
         virtual ~AudioDecoderBase();
 
         /** Opens the file for decoding */
         int open() { return 0; };
 
+        /** Closes the file but keeps the decoder's buffers, sinks, allocator and
+            metrics, ready for reset(). Nothing else works until then. */
+        void close() {};
+
+        /** Closes the current file and opens another in its place, reusing the
+            buffers and whatever codec setup outlives a file. Cheaper than
+            deleting the decoder and constructing a new one, eg. for previews
+            or batch scans (see AudioDecoderPool). Returns what open() does. */
+        int reset(const std::string filename) { return 0; };
+        int reset(AudioDecoderSource *source) { return 0; };
+
+        /** Instead of copying into a buffer like read(), lends you the
+            decoder's next decoded block as it is, 16-bit or float, in the
+            length the codec produced. Other sample formats come converted to
+            float, which costs a copy. Otherwise nothing is copied, so it's the
+            cheapest way to scan a file (analysis, hashing, waveforms). The
+            view is only valid until the next call on the decoder. Mixes
+            freely with read() and seek(). Returns the number of samples
+            in the view; 0 at the end of the file, AUDIODECODER_ERROR if it fails. */
+        int readView(AudioDecoderView *view) { return 0; };
+
         /** Seek to a sample in the file */
         int seek(int filepos) { return 0l; };
 
@@ -81,7 +132,8 @@ class DllExport AudioDecoderBase
 
         /** Get the number of audio samples in the file. This will be a good estimate of the 
             number of samples you can get out of read(), though you should not rely on it
-            being perfectly accurate always. (eg. it might be slightly inaccurate with VBR MP3s)*/
+            being perfectly accurate always. An MP3 with a Xing/Info or VBRI header gets an exact
+            length from it; AudioDecoderProbe can count the frames of the rest (see audiodecoderprobe.h).*/
         inline int    numSamples()        const { return m_iNumSamples; };
 
         /** Get the number of channels in the audio file */
@@ -102,13 +154,39 @@ class DllExport AudioDecoderBase
             return std::vector<std::string>();
         };
 
+        /** Attach a sink that is fed every block read() returns (see audiodecodersink.h).
+            Add sinks before open(). The decoder doesn't take ownership. */
+        void addSink(AudioDecoderSink *sink);
+        void removeSink(AudioDecoderSink *sink);
+
+        /** Where the decoder allocates its own memory (see audiodecoderallocator.h).
+            Set it before open(); the default is the heap. */
+        void setAllocator(AudioDecoderAllocator *allocator) { m_pAllocator = allocator; };
+        AudioDecoderAllocator *allocator() const;
+
+        /** Counters and latency histograms for this decoder (see audiodecodermetrics.h). */
+        const AudioDecoderMetrics& metrics() const { return m_metrics; };
+
     protected:
+        /** For the backends' reset(): switch to a new file and forget the old one's properties. */
+        void setInput(const std::string& filename, AudioDecoderSource *source);
+
+        /** For the backends: call at the end of open(), read() and seek(). */
+        void beginSinks();
+        void notifySinks(const SAMPLE *buffer, int size);
+        void notifySinks(const short *buffer, int size); // converts a piece at a time
+        void seekSinks(int sampleIdx);
+
         std::string     m_filename;
+        AudioDecoderSource *m_pSource; // NULL when decoding m_filename
         int   m_iNumSamples;
         int   m_iChannels;
         int   m_iSampleRate;
         float m_fDuration; // in seconds
         int   m_iPositionInSamples; // in samples;
+        std::vector<AudioDecoderSink*> m_sinks;
+        AudioDecoderAllocator *m_pAllocator; // NULL for the heap
+        AudioDecoderMetrics m_metrics;
 };
 
 #endif //__AUDIODECODERBASE_H__
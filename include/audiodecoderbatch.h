@@ -0,0 +1,186 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+/**
+ * \file audiodecoderbatch.h
+ * \class AudioDecoderBatch
+ * \brief Probes or decodes a whole list of files on a work-stealing pool
+ *        of worker threads, for library imports and re-analysis scans.
+ */
+
+#ifndef AUDIODECODERBATCH_H
+#define AUDIODECODERBATCH_H
+
+#include "audiodecoderbase.h"
+#include "audiodecoderreadaheadsource.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+class AudioDecoder;
+
+/** Receives decoded audio from an AudioDecoderBatch running JOB_DECODE_TO_SINK.
+    process() is called from the worker threads, concurrently for different
+    files and for different parts of the same (split) file, so it must be
+    thread-safe. startSample tells you where in the file the block belongs. */
+class DllExport AudioDecoderBatchSink
+{
+    public:
+        virtual ~AudioDecoderBatchSink() {};
+        virtual void process(int fileIndex, int startSample,
+                             const SAMPLE *buffer, int size) = 0;
+};
+
+/** The outcome of one file in a batch. */
+struct AudioDecoderBatchResult
+{
+    std::string filename;
+    int   status;         // AUDIODECODER_OK or AUDIODECODER_ERROR
+    int   numSamples;
+    int   channels;
+    int   sampleRate;
+    float duration;       // in seconds
+    int   samplesDecoded; // zero for JOB_PROBE
+};
+
+/** Receives progress and per-file results. Called from the worker threads. */
+class DllExport AudioDecoderBatchListener
+{
+    public:
+        virtual ~AudioDecoderBatchListener() {};
+        virtual void fileFinished(int fileIndex, const AudioDecoderBatchResult& result) {};
+        virtual void progress(int filesFinished, int filesTotal) {};
+};
+
+class DllExport AudioDecoderBatch
+{
+    public:
+        enum Job {
+            JOB_PROBE,          // collect the stream properties only (see AudioDecoderProbe)
+            JOB_DECODE,         // decode everything and throw it away (eg. warming caches, validation)
+            JOB_DECODE_TO_SINK  // decode everything into an AudioDecoderBatchSink
+        };
+
+        /** @param numThreads Number of worker threads, or 0 to use one per core. */
+        AudioDecoderBatch(int numThreads = 0);
+        virtual ~AudioDecoderBatch();
+
+        void setJob(Job job) { m_job = job; };
+        void setSink(AudioDecoderBatchSink *sink) { m_pSink = sink; };
+        void setListener(AudioDecoderBatchListener *listener) { m_pListener = listener; };
+
+        /** Size of the per-worker decode buffer, in samples (default 8192). */
+        void setBlockSize(int samples);
+
+        /** Files with more samples than this are decoded as several sub-tasks
+            of this many samples each, so that other workers can steal the
+            tail of a long file. Zero disables splitting. Sub-task boundaries
+            are only as accurate as the backend's seek(). */
+        void setSplitSize(int samples) { m_iSplitSize = samples; };
+
+        /** Use IO_SCAN or IO_DIRECT for nightly re-analysis and other bulk
+            jobs, so the batch doesn't evict the page cache that playback in
+            this process (or on this host) is using. Files are then read
+            through an AudioDecoderReadAheadSource. Default is IO_CACHED. */
+        void setIoMode(AudioDecoderReadAheadSource::IoMode ioMode) { m_ioMode = ioMode; };
+
+        /** Processes every file and blocks until all of them are finished.
+            Returns AUDIODECODER_OK if every file succeeded. */
+        int run(const std::vector<std::string>& filenames);
+
+        /** Per-file results of the last run(), in the order of the input list. */
+        const std::vector<AudioDecoderBatchResult>& results() const { return m_results; };
+
+    private:
+        struct Task {
+            int  fileIndex;
+            int  startSample;
+            int  endSample;
+            bool isRoot;     // the first task of a file, which may split it
+            bool toEnd;      // ignore endSample and decode until read() runs dry
+        };
+
+        struct FileState {
+            std::atomic<int>  pendingParts;
+            std::atomic<int>  samplesDecoded;
+            std::atomic<bool> failed;
+        };
+
+        struct Worker {
+            std::mutex        mutex;
+            std::deque<Task>  tasks;
+            std::vector<SAMPLE> buffer;
+            AudioDecoder      *decoder; // reset() onto each file, so it's only built once
+            std::thread       thread;
+        };
+
+        void workerLoop(int workerIndex);
+        bool popTask(int workerIndex, Task *task);
+        bool stealTask(int workerIndex, Task *task);
+        void pushTask(int workerIndex, const Task& task);
+        void runTask(int workerIndex, const Task& task);
+        void decodeTask(int workerIndex, const Task& task, AudioDecoder *decoder, int openStatus);
+        int  decodeRange(Worker *worker, const Task& task, AudioDecoder *decoder);
+        void finishPart(int fileIndex);
+
+        //Disable copy constructor and assignment operator
+        AudioDecoderBatch(const AudioDecoderBatch& that);
+        AudioDecoderBatch& operator=(AudioDecoderBatch const&);
+
+        int m_iNumThreads;
+        int m_iBlockSize;
+        int m_iSplitSize;
+        Job m_job;
+        AudioDecoderBatchSink *m_pSink;
+        AudioDecoderBatchListener *m_pListener;
+        AudioDecoderReadAheadSource::IoMode m_ioMode;
+
+        std::vector<Worker*> m_workers;
+        std::vector<std::string> m_filenames;
+        std::vector<AudioDecoderBatchResult> m_results;
+        FileState *m_fileStates;
+        std::atomic<int> m_outstandingTasks;
+        std::atomic<int> m_filesFinished;
+        std::mutex m_idleMutex;
+        std::condition_variable m_idleCondition;
+};
+
+#endif // ifndef AUDIODECODERBATCH_H
@@ -0,0 +1,177 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+
+/**
+ * \file audiodecodercapi.h
+ * \brief A plain C interface to the decoder, for calling libaudiodecoder
+ *        from Rust, Python (ctypes/cffi), Go and anything else with a C FFI.
+ *
+ * Everything is plain C: an opaque handle, UTF-8 paths, ints and structs.
+ * There are no copies at the boundary. audiodecoder_read() writes into a
+ * buffer you own, and audiodecoder_read_view() lends you the decoder's own
+ * decoded block, which a binding can wrap as a memory view:
+ *
+ *     audiodecoder *d = audiodecoder_open("track.m4a");
+ *     audiodecoder_info info;
+ *     audiodecoder_get_info(d, &info);
+ *     audiodecoder_view view;
+ *     while (audiodecoder_read_view(d, &view) > 0) {
+ *         ... view.data, view.frames ...
+ *     }
+ *     audiodecoder_close(d);
+ *
+ * Check audiodecoder_api_version() against AUDIODECODER_CAPI_VERSION when
+ * you load the library. Within a major version, functions are only ever
+ * added, and the structs and constants here never change. A handle may
+ * be used from any thread, but only from one thread at a time.
+ */
+
+#ifndef AUDIODECODERCAPI_H
+#define AUDIODECODERCAPI_H
+
+#ifdef _WIN32
+#define AUDIODECODER_CAPI __declspec( dllexport )
+#else
+#define AUDIODECODER_CAPI
+#endif
+
+/* Major version in the top 16 bits, minor in the bottom 16. */
+#define AUDIODECODER_CAPI_VERSION 0x00010000
+
+#ifndef AUDIODECODER_OK
+#define AUDIODECODER_ERROR -1
+#define AUDIODECODER_OK     0
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** An open decoder. */
+typedef struct audiodecoder audiodecoder;
+
+/** Properties of an opened decoder. Positions and sizes are in interleaved samples. */
+typedef struct audiodecoder_info
+{
+    int   channels;
+    int   sample_rate;
+    int   num_samples;
+    float duration; /* in seconds */
+} audiodecoder_info;
+
+/** What audiodecoder_probe() reads from a file's headers (see audiodecoderprobe.h). */
+typedef enum audiodecoder_format
+{
+    AUDIODECODER_FORMAT_UNKNOWN = 0,
+    AUDIODECODER_FORMAT_WAV,
+    AUDIODECODER_FORMAT_AIFF,
+    AUDIODECODER_FORMAT_MP3,
+    AUDIODECODER_FORMAT_MP4,
+    AUDIODECODER_FORMAT_WMA
+} audiodecoder_format;
+
+typedef struct audiodecoder_stream_info
+{
+    int   format; /* an audiodecoder_format */
+    int   sample_rate;
+    int   channels;
+    int   bits_per_sample; /* zero for compressed formats */
+    int   num_samples;
+    float duration;
+    int   bitrate;
+} audiodecoder_stream_info;
+
+typedef enum audiodecoder_sample_format
+{
+    AUDIODECODER_SAMPLE_FLOAT = 0, /* 32-bit float */
+    AUDIODECODER_SAMPLE_INT16 = 1
+} audiodecoder_sample_format;
+
+/** A block lent out by audiodecoder_read_view(). Valid until the next call on the handle. */
+typedef struct audiodecoder_view
+{
+    const void *data;
+    int format; /* an audiodecoder_sample_format */
+    int frames;
+    int channels;
+    int position; /* in samples, of the first frame */
+} audiodecoder_view;
+
+/** AUDIODECODER_CAPI_VERSION of the library you're linked to. */
+AUDIODECODER_CAPI unsigned int audiodecoder_api_version(void);
+
+/** Opens a file, by UTF-8 path. NULL if it can't be opened. */
+AUDIODECODER_CAPI audiodecoder *audiodecoder_open(const char *path);
+
+/** Opens a file that's already in memory. Nothing is copied, so data must
+    stay valid until the handle is closed. NULL if it can't be opened. */
+AUDIODECODER_CAPI audiodecoder *audiodecoder_open_memory(const void *data, long long size);
+
+/** Closes the file and frees the handle. NULL is ignored. */
+AUDIODECODER_CAPI void audiodecoder_close(audiodecoder *decoder);
+
+AUDIODECODER_CAPI int audiodecoder_get_info(const audiodecoder *decoder, audiodecoder_info *info);
+
+/** Reads the stream properties from a file's headers, without opening a decoder. */
+AUDIODECODER_CAPI int audiodecoder_probe(const char *path, audiodecoder_stream_info *info);
+AUDIODECODER_CAPI int audiodecoder_probe_memory(const void *data, long long size,
+                                                audiodecoder_stream_info *info);
+
+/** Reads up to size samples of interleaved 32-bit floats into your buffer.
+    Returns the number read; 0 at the end of the file. */
+AUDIODECODER_CAPI int audiodecoder_read(audiodecoder *decoder, float *buffer, int size);
+
+/** Seeks to a sample. Returns where the decoder ended up. */
+AUDIODECODER_CAPI int audiodecoder_seek(audiodecoder *decoder, int sample);
+
+AUDIODECODER_CAPI int audiodecoder_position(const audiodecoder *decoder);
+
+/** Lends you the next decoded block with no copy. Returns its size in
+    samples; 0 at the end, or when the codec's samples can't be lent out. */
+AUDIODECODER_CAPI int audiodecoder_read_view(audiodecoder *decoder, audiodecoder_view *view);
+
+/** The file extensions the platform decoder handles, eg. "mp3;m4a;wav".
+    The string belongs to the library and stays valid. */
+AUDIODECODER_CAPI const char *audiodecoder_supported_extensions(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AUDIODECODERCAPI_H */
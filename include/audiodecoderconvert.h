@@ -0,0 +1,91 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+
+/**
+ * \file audiodecoderconvert.h
+ * \class AudioDecoderConvert
+ * \brief Turns blocks of decoded PCM into the floats read() returns.
+ *
+ * A backend that gets integer PCM from its codec picks a converter once,
+ * when it opens the file:
+ *
+ *     m_pConvert = AudioDecoderConvert::select(AudioDecoderConvert::FORMAT_S24, m_iChannels);
+ *     ...
+ *     m_pConvert(block, dest, frames, m_iChannels);
+ *
+ * Each converter is a template instantiated for one sample format and one
+ * channel count (mono, stereo, or any), with the scale a compile-time
+ * constant. The loop inside has nothing to branch on and the compiler
+ * vectorizes it. Output is always interleaved SAMPLEs, like read().
+ */
+
+#ifndef AUDIODECODERCONVERT_H
+#define AUDIODECODERCONVERT_H
+
+#include <stddef.h>
+#include "audiodecoderbase.h"
+
+/** Converts frames of interleaved PCM at src to SAMPLEs at dest. channels is
+    only looked at by the converters for uncommon channel counts. */
+typedef void (*AudioDecoderConvertFn)(const void *src, SAMPLE *dest, size_t frames, int channels);
+
+class DllExport AudioDecoderConvert
+{
+    public:
+        /** Little-endian (native) PCM sample formats. */
+        enum Format {
+            FORMAT_U8,  // unsigned, 128 is silence
+            FORMAT_S16,
+            FORMAT_S24, // packed in 3 bytes
+            FORMAT_S32,
+            FORMAT_F32
+        };
+
+        /** The converter for format with this many channels. Never NULL. */
+        static AudioDecoderConvertFn select(Format format, int channels);
+
+        /** The integer format with bitsPerSample bits, as a codec reports it.
+            Returns false for depths there's no converter for. */
+        static bool formatForBits(int bitsPerSample, Format *format);
+
+        /** Bytes one sample takes in format. */
+        static int bytesPerSample(Format format);
+};
+
+#endif // AUDIODECODERCONVERT_H
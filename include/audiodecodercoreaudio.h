@@ -67,15 +67,28 @@
 class AudioDecoderCoreAudio : public AudioDecoderBase {
 public:
     AudioDecoderCoreAudio(const std::string filename);
+    AudioDecoderCoreAudio(AudioDecoderSource *source);
     ~AudioDecoderCoreAudio();
     // Overriding AudioDecoderBase 
     int open();
+    void close();
+    int reset(const std::string filename);
+    int reset(AudioDecoderSource *source);
     int seek(int sampleIdx);
     int read(int size, const SAMPLE *buffer);
+    int readView(AudioDecoderView *view);
     static std::vector<std::string> supportedFileExtensions();
 private:
+    OSStatus openSource();
+    static OSStatus sourceRead(void *inClientData, SInt64 inPosition, UInt32 requestCount,
+                               void *buffer, UInt32 *actualCount);
+    static SInt64 sourceGetSize(void *inClientData);
+
     SInt64 m_headerFrames;
+    AudioFileID m_audioFileID; // only used when decoding from an AudioDecoderSource
     ExtAudioFileRef m_audioFile;
+    SAMPLE *m_pViewBuffer; // what readView() decodes into and lends out
+    size_t m_viewBufferSize; // in samples
     CAStreamBasicDescription m_clientFormat;
     CAStreamBasicDescription m_inputFormat;
 };
@@ -0,0 +1,164 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+
+/**
+ * \file audiodecodercuecache.h
+ * \class AudioDecoderCueCache
+ * \brief Keeps the audio after each hot cue, and whole loops, decoded in
+ *        memory, so jumping to them doesn't wait for the decoder.
+ *
+ * A seek() into a compressed file has to find a packet and decode up to
+ * the target before any audio comes out, which is audible when a DJ hits
+ * a hot cue or a loop wraps. Read the track through a cue cache instead
+ * and tell it where the cues and loops are:
+ *
+ *     AudioDecoderRandomAccess file("track.m4a");
+ *     file.open();
+ *     AudioDecoderCueCache deck(&file);
+ *     deck.open();
+ *     int cue = deck.addCue(sampleIdx);
+ *     int loop = deck.addLoop(loopStart, loopEnd);
+ *     deck.setActiveLoop(loop);
+ *     deck.seek(sampleIdx); // answered from memory
+ *     deck.read(size, buffer);
+ *
+ * A background thread decodes the first cueMilliseconds after each cue
+ * and the whole body of each loop, through the file's readAt(), and does
+ * it again whenever cues and loops are added. A read() inside one of
+ * those regions is a copy. Meanwhile the thread moves the deck's own
+ * decoder to where the region ends, so playback carries on from there
+ * without a seek. While a loop is active, reaching its end wraps back to
+ * its start.
+ *
+ * A jump to a cue that isn't decoded yet, or anywhere else, is an
+ * ordinary seek. Use the deck from one thread at a time; the cue and loop
+ * calls can come from any thread.
+ */
+
+#ifndef AUDIODECODERCUECACHE_H
+#define AUDIODECODERCUECACHE_H
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "audiodecoderbase.h"
+
+class AudioDecoder;
+class AudioDecoderRandomAccess;
+
+class DllExport AudioDecoderCueCache
+{
+    public:
+        /** @param file An opened file to decode from. It must outlive the cache.
+            @param cueMilliseconds How much audio after each cue is kept decoded. */
+        AudioDecoderCueCache(AudioDecoderRandomAccess *file, int cueMilliseconds = 500);
+        ~AudioDecoderCueCache();
+
+        /** Makes the deck's decoder and starts the background thread. */
+        int open();
+
+        /** Registers a hot cue. Returns its id, or AUDIODECODER_ERROR. */
+        int addCue(int sampleIdx);
+
+        /** Registers a loop from startSample up to endSample. Returns its id,
+            or AUDIODECODER_ERROR. */
+        int addLoop(int startSample, int endSample);
+
+        /** Forgets a cue or loop. */
+        void remove(int id);
+
+        /** Loops the given loop from now on; -1 stops looping. */
+        int setActiveLoop(int id);
+
+        /** True once the cue or loop is decoded and a jump to it is free. */
+        bool isReady(int id) const;
+
+        /** Like AudioDecoder::seek() and read(), served from memory where they can be. */
+        int seek(int sampleIdx);
+        int read(int size, const SAMPLE *buffer);
+        int positionInSamples() const;
+
+        /** Seeks that landed in a decoded region, and those that didn't. */
+        int cacheHits() const;
+        int cacheMisses() const;
+
+    private:
+        struct Region
+        {
+            int id;
+            int start; // in samples
+            int end;
+            bool loop;
+            bool ready;
+            std::vector<SAMPLE> samples;
+        };
+
+        int addRegion(int start, int end, bool loop);
+        Region *findRegion(int id) const;
+        const Region *readyRegionAt(int sampleIdx) const;
+        void moveDecoderTo(int sampleIdx);
+        void run();
+
+        //Disable copy constructor and assignment operator
+        AudioDecoderCueCache(const AudioDecoderCueCache& that);
+        AudioDecoderCueCache& operator=(AudioDecoderCueCache const&);
+
+        AudioDecoderRandomAccess *m_pFile;
+        const int m_iCueMilliseconds;
+        AudioDecoder *m_pDecoder; // the deck's own, for reading outside the regions
+
+        //All of the below are guarded by m_mutex.
+        std::vector<Region*> m_regions;
+        int m_iNextId;
+        int m_iActiveLoop; // id, or -1
+        int m_iPosition; // in samples
+        int m_iDecoderPosition; // where m_pDecoder is
+        int m_iDecoderTarget; // where the thread should move it, or -1
+        bool m_decoderBusy; // a seek() or read() on m_pDecoder is under way without the lock
+        int m_iHits;
+        int m_iMisses;
+        bool m_quit;
+        mutable std::mutex m_mutex;
+        std::condition_variable m_wake; // work for the thread
+        std::condition_variable m_decoderFree;
+        std::thread m_thread;
+};
+
+#endif //AUDIODECODERCUECACHE_H
@@ -0,0 +1,180 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+
+/**
+ * \file audiodecoderfanout.h
+ * \class AudioDecoderFanOut
+ * \brief Decodes a file once for several readers going at their own pace.
+ *
+ * The player, the live waveform and the beat tracker all want the same
+ * track at the same time. Rather than opening it three times, give the
+ * decoder to an AudioDecoderFanOut and hand each of them a cursor:
+ *
+ *     AudioDecoderFanOut fanOut(&decoder); // after decoder.open()
+ *     AudioDecoderFanOutCursor *player = fanOut.createCursor();
+ *     AudioDecoderFanOutCursor *waveform = fanOut.createCursor();
+ *     player->read(size, buffer); // on the player's thread
+ *     waveform->read(size, buffer); // on the waveform's thread
+ *
+ * Each cursor reads and seeks like a decoder of its own. Behind them the
+ * file is decoded once, a block at a time, into a ring of numBlocks
+ * blocks. A block is only reused once every cursor has read past it, so
+ * cursors can also seek back within what's still buffered for free.
+ *
+ * When the fastest cursor needs a new block and the ring is full, the
+ * slowest one is holding it up. With BACKPRESSURE_BLOCK the fast one waits
+ * for it; with BACKPRESSURE_DETACH the slow one is dropped instead, and
+ * its read() returns 0 until it seek()s back into the buffered range.
+ * A seek() outside the buffered range moves the shared decoder, so any
+ * other cursor that is left outside the new range is detached too.
+ *
+ * Every cursor must only be used by one thread at a time; different
+ * cursors can be used from different threads. With BACKPRESSURE_BLOCK, a
+ * thread that reads from two cursors can wait on itself forever, so give
+ * each cursor its own thread (or use BACKPRESSURE_DETACH).
+ */
+
+#ifndef AUDIODECODERFANOUT_H
+#define AUDIODECODERFANOUT_H
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+#include "audiodecoderbase.h"
+
+class AudioDecoder;
+class AudioDecoderFanOut;
+
+/** One reader of an AudioDecoderFanOut. Get it from createCursor() and
+    delete it when you're done, before the fan-out. */
+class DllExport AudioDecoderFanOutCursor
+{
+    public:
+        ~AudioDecoderFanOutCursor();
+
+        /** Like AudioDecoder::read(). Returns 0 while the cursor is detached. */
+        int read(int size, const SAMPLE *buffer);
+
+        /** Like AudioDecoder::seek(). Also re-attaches a detached cursor. */
+        int seek(int sampleIdx);
+
+        /** True once backpressure or another cursor's seek() has dropped this
+            cursor. It stays at its position until the next seek(). */
+        bool isDetached() const;
+
+        int   positionInSamples() const;
+        int   numSamples() const;
+        int   channels() const;
+        int   sampleRate() const;
+        float duration() const;
+
+    private:
+        friend class AudioDecoderFanOut;
+        AudioDecoderFanOutCursor(AudioDecoderFanOut *fanOut, int position);
+
+        //Disable copy constructor and assignment operator
+        AudioDecoderFanOutCursor(const AudioDecoderFanOutCursor& that);
+        AudioDecoderFanOutCursor& operator=(AudioDecoderFanOutCursor const&);
+
+        AudioDecoderFanOut *m_pFanOut;
+        int  m_iPosition; // in samples; guarded by the fan-out's mutex
+        bool m_detached;  // guarded by the fan-out's mutex
+};
+
+class DllExport AudioDecoderFanOut
+{
+    public:
+        enum Backpressure {
+            BACKPRESSURE_BLOCK,  // the fastest cursor waits for the slowest
+            BACKPRESSURE_DETACH  // the slowest cursor is dropped
+        };
+
+        /** @param decoder An opened decoder. The fan-out reads from it from
+                   whichever cursor's thread needs a new block, so don't use
+                   it directly while the fan-out exists.
+            @param numBlocks The size of the ring, in blocks.
+            @param blockFrames Frames decoded at a time. */
+        AudioDecoderFanOut(AudioDecoder *decoder, int numBlocks = 32, int blockFrames = 4096,
+                           Backpressure backpressure = BACKPRESSURE_BLOCK);
+        ~AudioDecoderFanOut();
+
+        /** A new cursor at the start of what's buffered. Delete it when you're done. */
+        AudioDecoderFanOutCursor *createCursor();
+
+        void setBackpressure(Backpressure backpressure);
+
+        /** The range of samples buffered right now, for all cursors. */
+        void bufferedRange(int *firstSample, int *endSample) const;
+
+        AudioDecoder *decoder() const { return m_pDecoder; };
+
+    private:
+        friend class AudioDecoderFanOutCursor;
+
+        int  read(AudioDecoderFanOutCursor *cursor, int size, SAMPLE *buffer);
+        int  seek(AudioDecoderFanOutCursor *cursor, int sampleIdx);
+        void removeCursor(AudioDecoderFanOutCursor *cursor);
+        bool makeRoom(std::unique_lock<std::mutex>& lock);
+        void decodeBlock(std::unique_lock<std::mutex>& lock);
+
+        //Disable copy constructor and assignment operator
+        AudioDecoderFanOut(const AudioDecoderFanOut& that);
+        AudioDecoderFanOut& operator=(AudioDecoderFanOut const&);
+
+        AudioDecoder *m_pDecoder;
+        const int m_iNumBlocks;
+        const int m_iBlockSamples;
+        Backpressure m_backpressure;
+        std::vector<SAMPLE> m_samples; // m_iNumBlocks blocks, used as a ring
+
+        //Every block in the ring is full except maybe the last one, at the
+        //end of the file, so block k starts at m_iWindowStart + k * m_iBlockSamples.
+        int  m_iFirstBlock;  // ring index of the oldest block
+        int  m_iNumFilled;
+        int  m_iWindowStart; // first sample still buffered
+        int  m_iWindowEnd;   // one past the last sample decoded
+        bool m_eof;
+        bool m_decoding;     // a cursor is in m_pDecoder->read(), without the lock
+
+        std::vector<AudioDecoderFanOutCursor*> m_cursors;
+        mutable std::mutex m_mutex;
+        std::condition_variable m_changed;
+};
+
+#endif //AUDIODECODERFANOUT_H
@@ -0,0 +1,118 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+
+/**
+ * \file audiodecoderframescanner.h
+ * \class AudioDecoderFrameScanner
+ * \brief Finds every frame of an MPEG audio (MP3) or ADTS (raw AAC)
+ *        stream from the frame headers alone, without decoding.
+ *
+ * The result is a table of frame offsets, for building seek tables,
+ * counting exact durations (AudioDecoderProbe uses it when asked to count
+ * the frames of an MP3 with no Xing header) or indexing.
+ *
+ * Once it has found a frame, the scanner jumps from header to header.
+ * It only searches byte by byte at the start and after junk or damage.
+ * That search tests 32 bytes at a time for the sync pattern with SSE2 or
+ * NEON. A header only counts if the next few headers follow on from it
+ * with the same sample rate. Random bytes that happen to look like a sync
+ * word are thrown out that way.
+ */
+
+#ifndef AUDIODECODERFRAMESCANNER_H
+#define AUDIODECODERFRAMESCANNER_H
+
+#include <stddef.h>
+#include <vector>
+#include "audiodecoderbase.h"
+
+class AudioDecoderSource;
+
+/** What one frame header says. */
+struct AudioDecoderFrameHeader
+{
+    int version;         // MPEG: 1, 2 or 25 (for MPEG 2.5); ADTS: 2 or 4
+    int layer;           // MPEG: 1 to 3; ADTS: 0
+    int bitrate;         // in bits per second; 0 for ADTS, which doesn't say
+    int sampleRate;
+    int channels;        // ADTS: 0 if the channel layout is in the stream instead
+    int samplesPerFrame;
+    int frameLength;     // in bytes, including the header
+};
+
+/** What scan() found. */
+struct AudioDecoderFrameIndex
+{
+    std::vector<long long> offsets; // of every frame, if scan() was asked to keep them
+    long long frames;
+    long long samples;   // per channel, over every frame
+    long long bytes;     // in the frames, not counting junk between them
+    AudioDecoderFrameHeader first;
+    bool constantBitrate;
+};
+
+class DllExport AudioDecoderFrameScanner
+{
+    public:
+        enum Format {
+            FORMAT_MPEG, // MPEG-1/2/2.5 layers 1 to 3
+            FORMAT_ADTS  // AAC in ADTS frames
+        };
+
+        /** Consecutive frames a header must start before it's believed
+            (fewer if the stream ends first). */
+        static const int kChainFrames = 4;
+
+        /** Scans the bytes from start to end of a source. Memory-mapped and
+            memory sources are scanned in place, others are read in large
+            chunks. Returns AUDIODECODER_ERROR if no frames were found. */
+        static int scan(AudioDecoderSource *source, long long start, long long end, Format format,
+                        AudioDecoderFrameIndex *index, bool keepOffsets = true);
+
+        /** Index of the first byte in data that could begin a frame header
+            (a sync word), or size if there's none. */
+        static size_t findSync(const unsigned char *data, size_t size, Format format);
+
+        /** Parse a header: 4 bytes for MPEG, 7 for ADTS. False if it isn't
+            one, or is one we can't follow (MPEG free format). */
+        static bool parseMpegHeader(const unsigned char *h, AudioDecoderFrameHeader *header);
+        static bool parseAdtsHeader(const unsigned char *h, AudioDecoderFrameHeader *header);
+};
+
+#endif // AUDIODECODERFRAMESCANNER_H
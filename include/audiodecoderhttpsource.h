@@ -0,0 +1,197 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+/**
+ * \file audiodecoderhttpsource.h
+ * \class AudioDecoderHttpSource
+ * \brief Reads a file from an HTTP server with byte-range requests, so a
+ *        decoder can open and start playing a track in an object store
+ *        without downloading all of it first.
+ *
+ * Data is fetched in blocks and kept in a small LRU block cache. Sequential
+ * reading doubles the read-ahead on every miss (up to a limit); anything
+ * else drops it back to a single block, so a seek only fetches what it
+ * needs. One keep-alive connection is used per source. A server that stops
+ * answering fails the read after the timeout. Plain http:// only:
+ * put a TLS-terminating proxy or a presigned http URL in front of HTTPS
+ * stores.
+ *
+ * AudioDecoderLoopbackHttpServer serves a block of memory on 127.0.0.1, for
+ * testing and benchmarking the source without a network.
+ */
+
+#ifndef AUDIODECODERHTTPSOURCE_H
+#define AUDIODECODERHTTPSOURCE_H
+
+#include "audiodecodersource.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+class DllExport AudioDecoderHttpSource : public AudioDecoderSource
+{
+    public:
+        /** Connects and fetches the first block, which also tells us the size.
+            @param url                 http://host[:port]/path
+            @param blockSize           Granularity of requests and of the cache, in bytes.
+            @param cacheBlocks         Number of blocks kept in the cache.
+            @param maxReadAheadBlocks  Most blocks fetched by one request.
+            @param timeoutMs           How long a send or receive may stall before the read fails. */
+        AudioDecoderHttpSource(const std::string url, int blockSize = 64 * 1024,
+                               int cacheBlocks = 64, int maxReadAheadBlocks = 16,
+                               int timeoutMs = 10000);
+        virtual ~AudioDecoderHttpSource();
+
+        virtual long long pread(void *buffer, long long size, long long offset);
+        virtual long long size() const { return m_size; };
+        bool isOpen() const { return m_size >= 0; };
+
+        /** Number of HTTP requests made so far, and the body bytes they returned. */
+        int requestCount() const { return m_iRequests; };
+        long long bytesFetched() const { return m_bytesFetched; };
+
+    private:
+        struct Block {
+            long long index;
+            std::vector<char> data;
+            unsigned long long lastUsed;
+        };
+
+        Block *findBlock(long long index);
+        Block *allocateBlock(long long index);
+        bool fetch(long long firstBlock, int numBlocks);
+        /** What request() makes of the response headers; -1 for what they don't say. */
+        struct Response {
+            int status;
+            long long contentLength;
+            long long rangeFirst;  // from Content-Range
+            long long rangeLast;
+            long long totalSize;
+            bool keepAlive;
+        };
+
+        bool request(long long first, long long last, Response *response);
+        bool connectToServer();
+        void disconnect();
+        bool sendAll(const char *data, size_t size);
+        bool recvExact(char *data, size_t size);
+
+        //Disable copy constructor and assignment operator
+        AudioDecoderHttpSource(const AudioDecoderHttpSource& that);
+        AudioDecoderHttpSource& operator=(AudioDecoderHttpSource const&);
+
+        std::string m_host;
+        std::string m_port;
+        std::string m_path;
+        long long m_socket;        // -1 when not connected
+        std::string m_recvBuffer;  // bytes received but not consumed yet
+        long long m_size;
+        int m_iBlockSize;
+        int m_iCacheBlocks;
+        int m_iMaxReadAhead;
+        int m_iTimeoutMs;
+        int m_iReadAhead;
+        long long m_nextSequentialBlock;
+        std::vector<Block> m_cache;
+        unsigned long long m_useClock;
+        int m_iRequests;
+        long long m_bytesFetched;
+        std::mutex m_mutex;
+};
+
+class DllExport AudioDecoderLoopbackHttpServer
+{
+    public:
+        /** Serves data (owned by the caller) at any path, honouring Range requests. */
+        AudioDecoderLoopbackHttpServer(const void *data, long long size);
+        ~AudioDecoderLoopbackHttpServer();
+
+        /** Listens on an ephemeral port on 127.0.0.1 and starts serving. */
+        int start();
+        void stop();
+
+        int port() const { return m_iPort; };
+        std::string url() const;
+
+        int requestCount() const { return m_iRequests; };
+        int connectionCount() const { return m_iConnections; };
+        long long bytesServed() const { return m_bytesServed; };
+
+        /** Misbehaviours for testing clients against. Ignore Range headers and
+            send the whole body with 200, like a server without range support. */
+        void setRangesSupported(bool supported) { m_rangesSupported = supported; };
+
+        /** Hang up after this many responses on a connection without saying
+            so, like a server dropping idle keep-alive connections. 0 for no limit. */
+        void setMaxRequestsPerConnection(int requests) { m_iMaxRequestsPerConnection = requests; };
+
+        /** Read requests but never answer them. */
+        void setStalled(bool stalled) { m_stalled = stalled; };
+
+        /** Start ranged responses this many bytes from where they were asked
+            to (within the file), and say so in Content-Range. */
+        void setRangeShift(long long bytes) { m_rangeShift = bytes; };
+
+    private:
+        void acceptLoop();
+        void serveConnection(long long socket);
+
+        //Disable copy constructor and assignment operator
+        AudioDecoderLoopbackHttpServer(const AudioDecoderLoopbackHttpServer& that);
+        AudioDecoderLoopbackHttpServer& operator=(AudioDecoderLoopbackHttpServer const&);
+
+        const char *m_pData;
+        long long m_size;
+        long long m_listenSocket;
+        int m_iPort;
+        std::atomic<bool> m_running;
+        std::atomic<int> m_iRequests;
+        std::atomic<int> m_iConnections;
+        std::atomic<long long> m_bytesServed;
+        std::atomic<bool> m_rangesSupported;
+        std::atomic<int> m_iMaxRequestsPerConnection;
+        std::atomic<bool> m_stalled;
+        std::atomic<long long> m_rangeShift;
+        std::thread m_acceptThread;
+        std::mutex m_mutex;
+        std::vector<std::thread> m_connectionThreads;
+        std::vector<long long> m_connectionSockets;
+};
+
+#endif // ifndef AUDIODECODERHTTPSOURCE_H
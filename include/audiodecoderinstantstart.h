@@ -0,0 +1,146 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+
+/**
+ * \file audiodecoderinstantstart.h
+ * \class AudioDecoderInstantStart
+ * \brief Starts playback as soon as the first block is decoded, instead of
+ *        blocking in open().
+ *
+ * A decoder's open() configures the codec, reads the file's properties
+ * and seeks to the start before it returns. From slow storage, or with
+ * Media Foundation, that can take a few hundred milliseconds, and the
+ * user hears nothing while it runs. Wrap the decoder and open() returns
+ * at once:
+ *
+ *     AudioDecoderInstantStart track(&decoder);
+ *     track.open([](int result) { ... numSamples() etc. are set now ... });
+ *     track.read(size, buffer); // waits for the first block only
+ *
+ * In the background, on the executor, the decoder is opened and its
+ * first block of firstBlockFrames frames is decoded. The callback comes
+ * as soon as open() has finished, with its result, and from then on the
+ * properties are exact (before, they're 0). The first read() waits for
+ * the first block and no more; later reads go to the decoder as usual.
+ *
+ * Use it from one thread, except for the callback, which runs on the
+ * executor. Don't destroy it from its own callback.
+ */
+
+#ifndef AUDIODECODERINSTANTSTART_H
+#define AUDIODECODERINSTANTSTART_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include "audiodecoderbase.h"
+
+class AudioDecoder;
+class AudioDecoderExecutor;
+
+class DllExport AudioDecoderInstantStart
+{
+    public:
+        /** Called with what the decoder's open() returned. */
+        typedef std::function<void(int result)> Callback;
+
+        /** @param decoder A decoder that isn't open yet. Don't use it directly
+                   while this object has it.
+            @param executor Where it's opened; NULL for AudioDecoderExecutor::defaultExecutor().
+            @param firstBlockFrames How much is decoded before read() can start. */
+        AudioDecoderInstantStart(AudioDecoder *decoder, AudioDecoderExecutor *executor = NULL,
+                                 int firstBlockFrames = 4096);
+
+        /** Waits for the background open to finish. */
+        ~AudioDecoderInstantStart();
+
+        /** Starts opening the decoder and returns straight away. */
+        void open(Callback propertiesReady = Callback());
+
+        /** Blocks until the decoder is open and returns what open() did. */
+        int waitForOpen();
+
+        /** True once the open has finished, successfully or not. */
+        bool isOpen() const;
+
+        /** Like AudioDecoder::read(). The first call waits for the first
+            block; returns 0 if the open failed. */
+        int read(int size, const SAMPLE *buffer);
+
+        /** Like AudioDecoder::seek(). Waits for the open to finish. */
+        int seek(int sampleIdx);
+
+        /** The decoder's, once isOpen(); 0 until then. */
+        int   numSamples() const;
+        int   channels() const;
+        int   sampleRate() const;
+        float duration() const;
+        int   positionInSamples() const;
+
+    private:
+        void run();
+        void waitForFirstBlock(std::unique_lock<std::mutex>& lock);
+
+        //Disable copy constructor and assignment operator
+        AudioDecoderInstantStart(const AudioDecoderInstantStart& that);
+        AudioDecoderInstantStart& operator=(AudioDecoderInstantStart const&);
+
+        AudioDecoder *m_pDecoder;
+        AudioDecoderExecutor *m_pExecutor;
+        const int m_iFirstBlockFrames;
+        Callback m_propertiesReady;
+
+        //Guarded by m_mutex until m_firstBlockDone; after that only the caller's thread uses them.
+        bool m_started;
+        bool m_opened; // open() has returned; m_iOpenResult holds what it returned
+        bool m_firstBlockDone; // and the background work is over
+        int  m_iOpenResult;
+        int  m_iNumSamples;
+        int  m_iChannels;
+        int  m_iSampleRate;
+        float m_fDuration;
+        std::vector<SAMPLE> m_firstBlock; // decoded ahead; read() returns it first
+        size_t m_firstBlockOffset; // samples of it already returned
+        int  m_iPosition;
+        mutable std::mutex m_mutex;
+        std::condition_variable m_changed;
+};
+
+#endif //AUDIODECODERINSTANTSTART_H
@@ -0,0 +1,146 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+
+/**
+ * \file audiodecoderlog.h
+ * \class AudioDecoderLog
+ * \brief Where libaudiodecoder's diagnostics go.
+ *
+ * The decoders report problems through AUDIODECODER_LOG() instead of
+ * writing to std::cout/std::cerr, so you decide what gets printed, and
+ * where. By default warnings and errors go to stderr. To route them into
+ * your own logger:
+ *
+ *     static void logToApp(AudioDecoderLog::Level level, const char *message, void *app)
+ *     {
+ *         static_cast<App*>(app)->log(level, message);
+ *     }
+ *     AudioDecoderLog::setSink(logToApp, &app);
+ *     AudioDecoderLog::setLevel(AudioDecoderLog::LEVEL_INFO);
+ *
+ * A disabled message costs one relaxed atomic load: its arguments aren't
+ * even formatted. Messages below AUDIODECODER_LOG_LEVEL (a number, 0 for
+ * DEBUG to 4 for NONE, set when building the library) aren't compiled in
+ * at all. Each call site may log at most setRateLimit() messages a second;
+ * the rest are counted and the next message that gets through says how
+ * many were dropped.
+ */
+
+#ifndef AUDIODECODERLOG_H
+#define AUDIODECODERLOG_H
+
+#include <atomic>
+#include "audiodecoderbase.h"
+
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#define AUDIODECODER_CONSTEXPR
+#else
+#define AUDIODECODER_CONSTEXPR constexpr
+#endif
+
+/** The state one AUDIODECODER_LOG() call site keeps for rate limiting. */
+struct AudioDecoderLogSite
+{
+    std::atomic<long long> windowStart; // ms
+    std::atomic<int> count; // messages in the current window
+    std::atomic<int> suppressed; // dropped since the last one that got through
+
+    AUDIODECODER_CONSTEXPR AudioDecoderLogSite() : windowStart(0), count(0), suppressed(0) {}
+};
+
+class DllExport AudioDecoderLog
+{
+    public:
+        enum Level {
+            LEVEL_DEBUG   = 0,
+            LEVEL_INFO    = 1,
+            LEVEL_WARNING = 2,
+            LEVEL_ERROR   = 3,
+            LEVEL_NONE    = 4  // for setLevel(): log nothing
+        };
+
+        /** Called with each message, on the thread that logged it, possibly
+            several at once. message has no trailing newline. */
+        typedef void (*Sink)(Level level, const char *message, void *userData);
+
+        /** Only log messages at this level or above. The default is LEVEL_WARNING. */
+        static void setLevel(Level level);
+        static Level level();
+        static inline bool isEnabled(Level level)
+        {
+            return level >= s_level.load(std::memory_order_relaxed);
+        };
+
+        /** Send messages to sink instead of stderr. NULL goes back to stderr. */
+        static void setSink(Sink sink, void *userData);
+
+        /** At most this many messages a second from any one call site; 0 for no limit. The default is 10. */
+        static void setRateLimit(int messagesPerSecond);
+
+        /** Use AUDIODECODER_LOG() instead. printf-style; the message is cut off after 1 kB. */
+        static void write(AudioDecoderLogSite *site, Level level, const char *format, ...)
+#if defined(__GNUC__) || defined(__clang__)
+            __attribute__((format(printf, 3, 4)))
+#endif
+            ;
+
+        static const char *levelName(Level level);
+
+    private:
+        AudioDecoderLog();
+
+        static std::atomic<int> s_level;
+};
+
+#ifndef AUDIODECODER_LOG_LEVEL
+#define AUDIODECODER_LOG_LEVEL 0
+#endif
+
+/** AUDIODECODER_LOG(WARNING, "seek to %d failed", sampleIdx): level is DEBUG,
+    INFO, WARNING or ERROR. */
+#define AUDIODECODER_LOG(level, ...) \
+    do { \
+        if (AudioDecoderLog::LEVEL_##level >= AUDIODECODER_LOG_LEVEL && \
+            AudioDecoderLog::isEnabled(AudioDecoderLog::LEVEL_##level)) { \
+            static AudioDecoderLogSite logSite; \
+            AudioDecoderLog::write(&logSite, AudioDecoderLog::LEVEL_##level, __VA_ARGS__); \
+        } \
+    } while (0)
+
+#endif //AUDIODECODERLOG_H
@@ -51,46 +51,59 @@
 #define AUDIODECODERMEDIAFOUNDATION_H
 
 #include "audiodecoderbase.h"
+#include "audiodecoderconvert.h"
 
 struct IMFSourceReader;
 struct IMFMediaType;
 struct IMFMediaSource;
-
-#define SHORT_SAMPLE short
+struct IMFSample;
+struct IMFMediaBuffer;
 
 class DllExport AudioDecoderMediaFoundation : public AudioDecoderBase {
   public:
     AudioDecoderMediaFoundation(const std::string filename);
+    AudioDecoderMediaFoundation(AudioDecoderSource *source);
     ~AudioDecoderMediaFoundation();
     int open();
+    void close();
+    int reset(const std::string filename);
+    int reset(AudioDecoderSource *source);
     int seek(int sampleIdx);
     int read(int size, const SAMPLE *buffer);
-    int numSamples() const;
+    int readView(AudioDecoderView *view);
     std::vector<std::string> supportedFileExtensions();
 
   private:
+    void init();
     bool configureAudioStream();
     bool readProperties();
-    void copyFrames(short *dest, size_t *destFrames, const short *src, size_t srcFrames);
+    bool nextBlock(SAMPLE *dest, size_t *framesNeeded);
+    void releaseBlock();
     static double secondsFromMF(__int64 mf);
     static __int64 mfFromSeconds(double sec);
     __int64 frameFromMF(__int64 mf) const;
     __int64 mfFromFrame(__int64 frame) const;
     IMFSourceReader *m_pReader;
     IMFMediaType *m_pAudioType;
-    wchar_t *m_wcFilename;
+    wchar_t m_wcFilename[248 + 260];
     int m_nextFrame;
-    short *m_leftoverBuffer;
-    size_t m_leftoverBufferSize;
-    size_t m_leftoverBufferLength;
-    int m_leftoverBufferPosition;
+    // The decoded block read() is working through, held locked until it's used up
+    IMFSample *m_pSample;
+    IMFMediaBuffer *m_pMBuffer;
+    const unsigned char *m_pBlock;
+    size_t m_blockFrames;
+    size_t m_blockOffset; // frames of the block already returned
     __int64 m_mfDuration;
-    long m_iCurrentPosition;
     bool m_dead;
     bool m_seeking;
     unsigned int m_iBitsPerSample;
-    SHORT_SAMPLE m_destBufferShort[8192];
-    bool m_com_preinitialized = false;
+    // What the reader hands us, and the converter read() runs on it, both picked in configureAudioStream()
+    AudioDecoderConvert::Format m_sampleFormat;
+    AudioDecoderConvertFn m_pConvert;
+    size_t m_bytesPerFrame;
+    SAMPLE *m_pViewBuffer;    // what readView() converts blocks that aren't 16-bit or float into
+    size_t m_viewBufferSize;  // in samples
+    bool m_mfStarted; // Media Foundation is up, for as long as the decoder lives; COM is per thread
 };
 
 #endif // ifndef AUDIODECODERMEDIAFOUNDATION_H
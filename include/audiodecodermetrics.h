@@ -0,0 +1,170 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+/**
+ * \file audiodecodermetrics.h
+ * \class AudioDecoderMetrics
+ * \brief Counters and latency histograms kept by every decoder.
+ *
+ * Each decoder updates its own AudioDecoderMetrics (see
+ * AudioDecoderBase::metrics()) with relaxed atomics, so reading them from
+ * another thread, say a monitoring one, never blocks the decoder. Every
+ * AudioDecoderMetrics also adds itself to a process-wide total, which
+ * processSnapshot() sums and prometheusText() exports in the Prometheus
+ * text format. Counters from decoders that have since been destroyed stay
+ * in the total.
+ */
+
+#ifndef AUDIODECODERMETRICS_H
+#define AUDIODECODERMETRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+//audiodecoderbase.h includes this file, so it can't include that one.
+#ifndef DllExport
+#ifdef _WIN32
+#define DllExport   __declspec( dllexport )
+#else
+#define DllExport
+#endif
+#endif
+
+/** Durations in log2 buckets: bucket 0 counts everything under 1 us and
+    bucket i the range [2^(i-1), 2^i) us; the last one also takes
+    everything longer. */
+class DllExport AudioDecoderLatencyHistogram
+{
+    public:
+        static const int kBuckets = 32; // the last full bucket ends at about 36 minutes
+
+        AudioDecoderLatencyHistogram();
+
+        void record(long long microseconds);
+
+        long long count() const { return m_count.load(std::memory_order_relaxed); };
+        long long sumMicroseconds() const { return m_sum.load(std::memory_order_relaxed); };
+        long long bucket(int i) const { return m_buckets[i].load(std::memory_order_relaxed); };
+
+        /** The upper end of bucket i in microseconds. */
+        static long long bucketLimit(int i) { return 1LL << i; };
+
+    private:
+        std::atomic<long long> m_buckets[kBuckets];
+        std::atomic<long long> m_count;
+        std::atomic<long long> m_sum;
+};
+
+/** A plain copy of one or more decoders' metrics, for adding up and reporting. */
+struct DllExport AudioDecoderMetricsSnapshot
+{
+    struct Histogram {
+        long long buckets[AudioDecoderLatencyHistogram::kBuckets];
+        long long count;
+        long long sumMicroseconds;
+
+        /** An estimate: the upper end of the bucket the p-th quantile falls in, in microseconds. */
+        long long percentile(double p) const;
+    };
+
+    long long decoders;            // live decoders counted in here
+    long long framesDecoded;
+    long long bytesRead;
+    long long seeks;
+    long long seekErrorFrames;
+    long long silencePaddedFrames;
+    long long bufferBytesHeld;     // a gauge: live decoders only
+    Histogram openLatency;
+    Histogram seekLatency;
+    Histogram readLatency;
+
+    AudioDecoderMetricsSnapshot();
+    AudioDecoderMetricsSnapshot& operator+=(const AudioDecoderMetricsSnapshot& other);
+};
+
+class DllExport AudioDecoderMetrics
+{
+    public:
+        AudioDecoderMetrics();
+        ~AudioDecoderMetrics();
+
+        std::atomic<long long> framesDecoded;
+        /** Bytes read through an AudioDecoderSource. When a backend opens a
+            named file itself it does its own I/O, which isn't counted. */
+        std::atomic<long long> bytesRead;
+        std::atomic<long long> seeks;
+        /** How far seeks landed from where they were asked to, in frames. */
+        std::atomic<long long> seekErrorFrames;
+        /** Silence written to make up for a seek that overshot. */
+        std::atomic<long long> silencePaddedFrames;
+        /** Decoded audio the decoder is holding on to between calls. */
+        std::atomic<long long> bufferBytesHeld;
+        AudioDecoderLatencyHistogram openLatency;
+        AudioDecoderLatencyHistogram seekLatency;
+        AudioDecoderLatencyHistogram readLatency; // read() and readView()
+
+        AudioDecoderMetricsSnapshot snapshot() const;
+
+        /** Every decoder in the process, live or gone, added up. */
+        static AudioDecoderMetricsSnapshot processSnapshot();
+        /** processSnapshot() in the Prometheus text exposition format. */
+        static std::string prometheusText();
+
+        /** Times a call into a histogram: put one at the top of the function. */
+        class Timer
+        {
+            public:
+                Timer(AudioDecoderLatencyHistogram& histogram)
+                : m_histogram(histogram), m_start(std::chrono::steady_clock::now()) {};
+                ~Timer() {
+                    m_histogram.record(std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - m_start).count());
+                };
+            private:
+                AudioDecoderLatencyHistogram& m_histogram;
+                std::chrono::steady_clock::time_point m_start;
+        };
+
+    private:
+        //Disable copy constructor and assignment
+        AudioDecoderMetrics(const AudioDecoderMetrics&);
+        AudioDecoderMetrics& operator=(const AudioDecoderMetrics&);
+};
+
+#endif // ifndef AUDIODECODERMETRICS_H
@@ -0,0 +1,149 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+/**
+ * \file audiodecoderpeakpyramid.h
+ * \class AudioDecoderPeakPyramid
+ * \brief Builds min/max/RMS waveform peaks at several zoom levels while a
+ *        decoder runs, and saves them to a file that AudioDecoderPeakFile
+ *        maps straight back into memory.
+ *
+ * Attach the pyramid to a decoder with addSink() before open(), read the
+ * file through, then save(). Every level is derived from the one below it,
+ * so the levels line up exactly; each level's bin size must be a multiple
+ * of the previous one. Seeking is allowed but the pyramid is meant to be
+ * built by a linear decode: bins a seek cut short only cover the frames
+ * that were decoded, and isPartial() says which they are.
+ */
+
+#ifndef AUDIODECODERPEAKPYRAMID_H
+#define AUDIODECODERPEAKPYRAMID_H
+
+#include "audiodecodersink.h"
+#include "audiodecodersource.h"
+
+class DllExport AudioDecoderPeakPyramid : public AudioDecoderSink
+{
+    public:
+        /** @param framesPerBin Bin size of each level in frames, finest first
+                                (default 64, 512 and 4096). */
+        AudioDecoderPeakPyramid(const std::vector<int>& framesPerBin = std::vector<int>());
+
+        virtual void begin(int channels, int sampleRate);
+        virtual void process(const SAMPLE *buffer, int size);
+        virtual void seeked(int sampleIdx);
+
+        /** Writes out the partly filled bins at the end of the stream. save() does this for you. */
+        void finish();
+
+        /** Saves the pyramid in the format AudioDecoderPeakFile reads. */
+        int save(const std::string filename);
+
+        int numLevels() const { return static_cast<int>(m_levels.size()); };
+        int framesPerBin(int level) const { return m_levels[level].framesPerBin; };
+        long long numBins(int level) const;
+
+        /** channels() * 3 values per bin: min, max and RMS scaled to +/-32767. */
+        const short *bins(int level) const;
+
+        /** True if a seek skipped some of a bin's frames, so its values only
+            cover the rest. Not saved to the file. */
+        bool isPartial(int level, long long bin) const;
+
+    private:
+        struct Level {
+            int framesPerBin;
+            int framesInBin;      // decoded into the bin being filled
+            bool binIsPartial;    // a seek skipped some of its frames
+            long long binIndex;
+            std::vector<float> min;    // per channel, for the bin being filled
+            std::vector<float> max;
+            std::vector<double> sumSquares;
+            std::vector<short> bins;
+            std::vector<bool> partial; // per stored bin
+        };
+
+        void resetBin(Level& level);
+        void emitBin(int levelIndex);
+
+        std::vector<Level> m_levels;
+        int m_iChannels;
+        int m_iSampleRate;
+        long long m_position;  // frame the next process() starts at
+        long long m_numFrames;
+};
+
+class DllExport AudioDecoderPeakFile
+{
+    public:
+        /** Maps a file written by AudioDecoderPeakPyramid::save(). */
+        AudioDecoderPeakFile(const std::string filename);
+
+        bool isOpen() const { return m_iNumLevels > 0; };
+        int channels() const { return m_iChannels; };
+        int sampleRate() const { return m_iSampleRate; };
+        long long numFrames() const { return m_numFrames; };
+
+        int numLevels() const { return m_iNumLevels; };
+        int framesPerBin(int level) const;
+        long long numBins(int level) const;
+
+        /** The coarsest level whose bins are no wider than framesPerPixel. */
+        int levelForZoom(double framesPerPixel) const;
+
+        /** A level's bins, straight from the mapping: channels() * 3 shorts
+            (min, max, RMS scaled to +/-32767) per bin. */
+        const short *bins(int level) const;
+
+        /** Copies bins [firstBin, firstBin + count) of a level into float arrays
+            of count * channels() values each. Returns the number of bins copied. */
+        long long getBins(int level, long long firstBin, long long count,
+                          float *min, float *max, float *rms) const;
+
+    private:
+        const unsigned char *levelEntry(int level) const;
+
+        AudioDecoderMmapSource m_source;
+        const unsigned char *m_pData;
+        int m_iChannels;
+        int m_iSampleRate;
+        int m_iNumLevels;
+        long long m_numFrames;
+};
+
+#endif // ifndef AUDIODECODERPEAKPYRAMID_H
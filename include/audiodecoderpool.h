@@ -0,0 +1,108 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+
+/**
+ * \file audiodecoderpool.h
+ * \class AudioDecoderPool
+ * \brief Recycles decoders, so opening one more file doesn't mean building
+ *        one more decoder.
+ *
+ * Constructing a decoder and starting up its platform codec framework
+ * costs more than decoding a short preview clip. A pool keeps decoders
+ * you're finished with and reset()s them onto the next file:
+ *
+ *     AudioDecoderPool pool;
+ *     AudioDecoder *decoder = pool.acquire("preview.m4a"); // opened
+ *     if (decoder) {
+ *         decoder->read(...);
+ *         pool.release(decoder);
+ *     }
+ *
+ * acquire() and release() may be called from any thread. Each build has
+ * one backend, so every decoder in the pool is interchangeable. Take
+ * your sinks off a decoder before releasing it, and don't change its
+ * allocator: both stay with it.
+ */
+
+#ifndef AUDIODECODERPOOL_H
+#define AUDIODECODERPOOL_H
+
+#include <mutex>
+#include <vector>
+#include "audiodecoderbase.h"
+
+class AudioDecoder;
+
+class DllExport AudioDecoderPool
+{
+    public:
+        /** @param maxIdle Decoders kept for reuse; any more are deleted on release(). */
+        AudioDecoderPool(int maxIdle = 4);
+        ~AudioDecoderPool();
+
+        /** An opened decoder for filename: an idle one reset() onto it, or a new
+            one. NULL if the file can't be opened. Give it back with release(). */
+        AudioDecoder *acquire(const std::string filename);
+
+        /** The same for a source. The source must outlive your use of the decoder. */
+        AudioDecoder *acquire(AudioDecoderSource *source);
+
+        /** Closes the decoder's file and keeps the decoder for the next acquire(). */
+        void release(AudioDecoder *decoder);
+
+        /** Number of decoders waiting to be reused. */
+        int idleCount() const;
+
+        /** Deletes every idle decoder. */
+        void clear();
+
+    private:
+        AudioDecoder *takeIdle();
+        void putIdle(AudioDecoder *decoder);
+
+        //Disable copy constructor and assignment operator
+        AudioDecoderPool(const AudioDecoderPool& that);
+        AudioDecoderPool& operator=(AudioDecoderPool const&);
+
+        const int m_iMaxIdle;
+        std::vector<AudioDecoder*> m_idle;
+        mutable std::mutex m_mutex;
+};
+
+#endif //AUDIODECODERPOOL_H
@@ -0,0 +1,113 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+/**
+ * \file audiodecoderprobe.h
+ * \class AudioDecoderProbe
+ * \brief Reads the stream properties of an audio file straight out of its
+ *        container headers, without creating a decoder.
+ *
+ * This is meant for library browsing and import, where opening a
+ * MediaFoundation source reader or an ExtAudioFile per track is far too
+ * expensive. Only a few KB at the start (and for MP4 files, the moov box)
+ * are read. Numbers describe the file as stored: channels() on a decoder
+ * may differ (eg. CoreAudio always decodes to stereo).
+ *
+ * MP3 lengths come from the Xing/Info or VBRI header, less the encoder
+ * delay and padding in a LAME tag, and are exact. Without such a header
+ * (most CBR files) the length is estimated from the bitrate and the file
+ * size, unless you ask for the frames to be counted: that reads every
+ * frame header in the file, which takes time in proportion to its size,
+ * but decodes nothing.
+ */
+
+#ifndef AUDIODECODERPROBE_H
+#define AUDIODECODERPROBE_H
+
+#include "audiodecoderbase.h"
+
+class AudioDecoderSource;
+
+struct AudioStreamInfo
+{
+    enum Format {
+        FORMAT_UNKNOWN = 0,
+        FORMAT_WAV,
+        FORMAT_AIFF,
+        FORMAT_MP3,
+        FORMAT_MP4,   // AAC or ALAC in an MPEG-4 container (m4a, mp4)
+        FORMAT_WMA
+    };
+
+    Format format;
+    int   sampleRate;
+    int   channels;
+    int   bitsPerSample; // zero for compressed formats
+    int   numSamples;    // interleaved samples, like AudioDecoderBase::numSamples()
+    float duration;      // in seconds
+    int   bitrate;       // in bits per second, averaged over the file
+    int   encoderDelay;   // frames of priming silence the encoder added at the start (MP3)
+    int   encoderPadding; // and at the end; both are left out of numSamples
+    bool  lengthIsExact;  // false if numSamples is an estimate from the bitrate (MP3)
+};
+
+class DllExport AudioDecoderProbe
+{
+    public:
+        /** Fills in info from the headers of the file.
+            Returns AUDIODECODER_ERROR if the format isn't recognized or the
+            headers are damaged, in which case you need a full open().
+            @param countFrames For an MP3 with no Xing/Info or VBRI header,
+                   count its frames for an exact length instead of estimating it. */
+        static int probe(const std::string filename, AudioStreamInfo *info, bool countFrames = false);
+        static int probe(AudioDecoderSource *source, AudioStreamInfo *info, bool countFrames = false);
+
+        /** Just the format, from the first few bytes; for the backends'
+            content-type hints. FORMAT_UNKNOWN if it isn't obvious there. */
+        static AudioStreamInfo::Format sniff(AudioDecoderSource *source);
+
+    private:
+        class Reader;
+        static int probeWav(Reader& reader, AudioStreamInfo *info);
+        static int probeAiff(Reader& reader, AudioStreamInfo *info);
+        static int probeMp4(Reader& reader, AudioStreamInfo *info);
+        static int probeWma(Reader& reader, AudioStreamInfo *info);
+        static int probeMp3(Reader& reader, AudioStreamInfo *info, bool countFrames);
+};
+
+#endif // ifndef AUDIODECODERPROBE_H
@@ -0,0 +1,128 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+
+/**
+ * \file audiodecoderrandomaccess.h
+ * \class AudioDecoderRandomAccess
+ * \brief Reads any part of a file from any thread, without opening it again
+ *        for every reader.
+ *
+ * A decoder's read() and seek() share one position, so two threads can't
+ * read different parts of it. AudioDecoderRandomAccess keeps a few cursors,
+ * decoders that all read through one source opened once, and lends one to
+ * each readAt():
+ *
+ *     AudioDecoderRandomAccess file("set.m4a");
+ *     if (file.open() == AUDIODECODER_OK) {
+ *         file.readAt(sampleIdx, size, buffer); // from as many threads as you like
+ *     }
+ *
+ * A cursor already sitting at sampleIdx is preferred, so a thread reading
+ * its way through the file doesn't seek at all. The platform codecs keep
+ * their packet index to themselves, so each cursor reads the header once
+ * when it's made; after that, cursors are reused and no read opens anything.
+ * clone() hands you a cursor of your own, eg. for a thread that streams.
+ */
+
+#ifndef AUDIODECODERRANDOMACCESS_H
+#define AUDIODECODERRANDOMACCESS_H
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+#include "audiodecoderbase.h"
+
+class AudioDecoder;
+
+class DllExport AudioDecoderRandomAccess
+{
+    public:
+        /** @param maxCursors Most cursors readAt() makes; more callers than this wait their turn. */
+        AudioDecoderRandomAccess(const std::string filename, int maxCursors = 8);
+
+        /** The same for a source, which must outlive this object and its clones. */
+        AudioDecoderRandomAccess(AudioDecoderSource *source, int maxCursors = 8);
+        ~AudioDecoderRandomAccess();
+
+        /** Opens the source and the first cursor. */
+        int open();
+
+        /** Reads up to size samples starting at sampleIdx into buffer, without
+            disturbing any other reader. Safe to call from several threads at
+            once. Returns the number of samples read (short at the end of the
+            file), or AUDIODECODER_ERROR. */
+        int readAt(int sampleIdx, int size, SAMPLE *buffer);
+
+        /** A new opened decoder, at the start of the file, reading through the
+            same source. It's yours to use on one thread and delete; it must
+            not outlive this object. NULL on failure. */
+        AudioDecoder *clone();
+
+        inline int   numSamples() const { return m_iNumSamples; };
+        inline int   channels()   const { return m_iChannels; };
+        inline int   sampleRate() const { return m_iSampleRate; };
+        inline float duration()   const { return m_fDuration; };
+
+        /** Number of cursors made so far. */
+        int cursorCount() const;
+
+    private:
+        AudioDecoder *takeCursor(int sampleIdx);
+        void putCursor(AudioDecoder *cursor);
+
+        //Disable copy constructor and assignment operator
+        AudioDecoderRandomAccess(const AudioDecoderRandomAccess& that);
+        AudioDecoderRandomAccess& operator=(AudioDecoderRandomAccess const&);
+
+        std::string m_filename;
+        AudioDecoderSource *m_pSource; // ours if m_pOwnedSource is set
+        AudioDecoderSource *m_pOwnedSource;
+        const int m_iMaxCursors;
+        int m_iNumSamples;
+        int m_iChannels;
+        int m_iSampleRate;
+        float m_fDuration;
+
+        std::vector<AudioDecoder*> m_idle;
+        int m_iCursors; // idle and lent out
+        mutable std::mutex m_mutex;
+        std::condition_variable m_cursorReturned;
+};
+
+#endif //AUDIODECODERRANDOMACCESS_H
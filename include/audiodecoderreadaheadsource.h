@@ -0,0 +1,122 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+/**
+ * \file audiodecoderreadaheadsource.h
+ * \class AudioDecoderReadAheadSource
+ * \brief A file source that keeps a window of large, aligned reads in
+ *        flight ahead of the decoder, so decode threads aren't stalled by
+ *        cold or slow storage.
+ *
+ * On Linux the reads are submitted through io_uring. Elsewhere, or when
+ * io_uring isn't available (old kernels, seccomp sandboxes), the window is
+ * announced to the kernel with posix_fadvise(WILLNEED) and read with plain
+ * pread() when the decoder gets there. Data that has already arrived is
+ * handed out without any system call.
+ *
+ * For bulk jobs (nightly re-analysis, library imports) the source can also
+ * keep out of the page cache, so that streaming terabytes through it doesn't
+ * evict what interactive decoders in this process or on this host depend on.
+ * See IoMode. Scan modes currently only have an effect on Linux and Mac OS X.
+ */
+
+#ifndef AUDIODECODERREADAHEADSOURCE_H
+#define AUDIODECODERREADAHEADSOURCE_H
+
+#include "audiodecodersource.h"
+
+#include <mutex>
+
+class DllExport AudioDecoderReadAheadSource : public AudioDecoderFileSource
+{
+    public:
+        enum IoMode {
+            IO_CACHED,  // ordinary reads through the page cache
+            IO_SCAN,    // drop every block from the page cache once the reader is past it
+            IO_DIRECT   // bypass the page cache (O_DIRECT / F_NOCACHE), or IO_SCAN if we can't
+        };
+
+        /** @param queueDepth Number of blocks kept in flight ahead of the reader.
+            @param blockSize  Size of each read in bytes, rounded up to 4 KB.
+            @param ioMode     How to treat the page cache. */
+        AudioDecoderReadAheadSource(const std::string filename, int queueDepth = 4,
+                                    int blockSize = 256 * 1024, IoMode ioMode = IO_CACHED);
+        virtual ~AudioDecoderReadAheadSource();
+
+        virtual long long pread(void *buffer, long long size, long long offset);
+
+        /** True if reads go through io_uring rather than the pread fallback. */
+        bool usingIoUring() const { return m_pRing != NULL; };
+
+        /** The mode actually in use, after any fallback from IO_DIRECT. */
+        IoMode ioMode() const { return m_ioMode; };
+
+    private:
+        enum SlotState { SLOT_EMPTY, SLOT_PENDING, SLOT_READY };
+
+        struct Slot {
+            char     *data;
+            long long offset;
+            long long bytes;     // bytes read, or -1 if the read failed
+            SlotState state;
+        };
+
+        struct Ring; // io_uring plumbing, see the .cpp
+
+        Slot *findSlot(long long offset);
+        void restartAt(long long offset);
+        void refill(long long offset);
+        void submit(Slot *slot, long long offset);
+        void waitFor(Slot *slot);
+        void drain();
+        void dropFromCache(long long offset, long long size);
+
+        //Disable copy constructor and assignment operator
+        AudioDecoderReadAheadSource(const AudioDecoderReadAheadSource& that);
+        AudioDecoderReadAheadSource& operator=(AudioDecoderReadAheadSource const&);
+
+        int m_iQueueDepth;
+        int m_iBlockSize;
+        Slot *m_slots;
+        long long m_nextOffset; // where the next read-ahead will start
+        Ring *m_pRing;
+        IoMode m_ioMode;
+        std::mutex m_mutex;
+};
+
+#endif // ifndef AUDIODECODERREADAHEADSOURCE_H
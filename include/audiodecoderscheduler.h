@@ -0,0 +1,179 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+
+/**
+ * \file audiodecoderscheduler.h
+ * \class AudioDecoderScheduler
+ * \brief Decodes many streams on a fixed set of worker threads, most
+ *        urgent first.
+ *
+ * Each deck or sampler slot registers its decoder with addStream(). The
+ * workers keep a ring of decoded audio topped up for every stream, and the
+ * audio thread takes it out with read(). Neither read() nor seek() locks,
+ * allocates or calls into the decoder, so they are safe in an audio
+ * callback.
+ *
+ * Streams are served earliest deadline first. A stream's deadline is when
+ * its ring will run dry at the current playback rate (see setRate()), so
+ * a deck at 2x with a quarter of its buffer left goes before a deck at 1x
+ * with half. Background jobs (addBackground(), eg. analysis through the
+ * decoder's sinks) only get a worker when no stream needs one. A worker
+ * decodes blockFrames at a time, so that's as long as a background job
+ * can hold up a deck. Every time read() comes up short before the end of
+ * the file, that's a deadline miss, and it's counted.
+ *
+ * Decks that must stay in step can be read together with
+ * readSynchronized(), which always advances them all by the same number
+ * of frames.
+ */
+
+#ifndef AUDIODECODERSCHEDULER_H
+#define AUDIODECODERSCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "audiodecoderbase.h"
+
+class AudioDecoder;
+
+class DllExport AudioDecoderScheduler
+{
+    public:
+        static const int kMaxStreams = 64;
+
+        /** @param numThreads Worker threads.
+            @param blockFrames Frames a worker decodes before it picks again. */
+        AudioDecoderScheduler(int numThreads = 2, int blockFrames = 1024);
+        ~AudioDecoderScheduler();
+
+        /** Registers an opened decoder for playback, with a ring of bufferFrames.
+            It's decoded from its current position. Returns the stream's id, or
+            AUDIODECODER_ERROR if there are kMaxStreams already. From now on
+            only the scheduler may touch the decoder, and it must outlive the
+            stream (removeStream() or the scheduler's destructor). */
+        int addStream(AudioDecoder *decoder, int bufferFrames = 16384);
+
+        /** Registers an opened decoder to be decoded to the end whenever no
+            stream needs a worker. The audio only goes to the decoder's sinks. */
+        int addBackground(AudioDecoder *decoder);
+
+        /** Waits for any decode of the stream in progress and forgets it. Don't
+            call read() or seek() on it meanwhile. */
+        void removeStream(int id);
+
+        /** Playback speed, 1.0 for normal; 0 means paused, and the stream is
+            topped up like a background job. Lock-free. */
+        void setRate(int id, double rate);
+
+        /** Up to size samples of the stream, like AudioDecoder::read(). If the
+            ring has less, that's all you get, and a deadline miss is counted
+            (except at the end of the file). Lock-free. */
+        int read(int id, int size, const SAMPLE *buffer);
+
+        /** Reads frames from each of count streams into buffers[i], but only as
+            many as all of them have, so they stay sample-aligned. Returns the
+            number of frames each stream advanced. Lock-free. */
+        int readSynchronized(const int *ids, int count, int frames, SAMPLE *const *buffers);
+
+        /** Jumps the stream to sampleIdx. Lock-free: the ring is refilled from
+            there by a worker, urgently, and read() returns nothing until the
+            first block lands. */
+        int seek(int id, int sampleIdx);
+
+        /** True once a stream's ring is drained at the end of the file, or a
+            background job has been decoded to the end. */
+        bool isFinished(int id) const;
+
+        /** Samples of the stream decoded and waiting in its ring. */
+        int bufferedSamples(int id) const;
+
+        long long deadlineMisses(int id) const;
+        long long totalDeadlineMisses() const;
+
+    private:
+        struct Stream {
+            AudioDecoder *decoder;
+            bool background;
+            int channels;
+            int sampleRate;
+            std::vector<SAMPLE> ring;
+            long long capacity; // samples
+
+            //Positions are absolute, in samples of the file. The audio thread
+            //owns readPos and seekSerial; the worker decoding it owns writePos
+            //and filledSerial. Data is only valid when the two serials match.
+            std::atomic<long long> readPos;
+            std::atomic<long long> writePos;
+            std::atomic<long long> seekTarget;
+            std::atomic<int> seekSerial;
+            std::atomic<int> filledSerial;
+            std::atomic<bool> eof;
+            std::atomic<double> rate;
+            std::atomic<long long> misses;
+
+            bool busy;     // a worker is decoding it; guarded by m_mutex
+            bool removing; // guarded by m_mutex
+        };
+
+        void workerLoop();
+        Stream *pickStream();
+        void decodeBlock(Stream *stream, std::vector<SAMPLE> *scratch);
+        int  available(const Stream *stream) const;
+        void consume(Stream *stream, int size, SAMPLE *buffer);
+        int  addStream(AudioDecoder *decoder, int bufferFrames, bool background);
+
+        //Disable copy constructor and assignment operator
+        AudioDecoderScheduler(const AudioDecoderScheduler& that);
+        AudioDecoderScheduler& operator=(AudioDecoderScheduler const&);
+
+        const int m_iBlockFrames;
+        Stream *m_streams[kMaxStreams];
+        int m_iNextBackground; // round-robin among background jobs
+        std::atomic<long long> m_totalMisses;
+        bool m_quit;
+        std::vector<std::thread> m_workers;
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::condition_variable m_idle; // a decode finished, for removeStream()
+};
+
+#endif //AUDIODECODERSCHEDULER_H
@@ -0,0 +1,68 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+/**
+ * \file audiodecodersink.h
+ * \class AudioDecoderSink
+ * \brief Sees every block of audio a decoder's read() returns, so that
+ *        waveforms, analysis and the like can be computed on the fly
+ *        instead of decoding the file again.
+ */
+
+#ifndef AUDIODECODERSINK_H
+#define AUDIODECODERSINK_H
+
+#include "audiodecoderbase.h"
+
+class DllExport AudioDecoderSink
+{
+    public:
+        virtual ~AudioDecoderSink() {};
+
+        /** Called at the end of a successful open(). */
+        virtual void begin(int channels, int sampleRate) {};
+
+        /** Called with the samples every read() returns, before read() does.
+            Same interleaving as read(). */
+        virtual void process(const SAMPLE *buffer, int size) = 0;
+
+        /** Called after seek(): what comes next isn't contiguous with what came before. */
+        virtual void seeked(int sampleIdx) {};
+};
+
+#endif // ifndef AUDIODECODERSINK_H
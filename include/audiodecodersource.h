@@ -0,0 +1,147 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+/**
+ * \file audiodecodersource.h
+ * \class AudioDecoderSource
+ * \brief Where a decoder gets its bytes from, if not straight from a file
+ *        name: a file, a memory-mapped file or a block of memory you
+ *        already hold (downloads, archive members, sample packs...).
+ *
+ * Sources are owned by the caller and must outlive every decoder that
+ * reads from them.
+ */
+
+#ifndef AUDIODECODERSOURCE_H
+#define AUDIODECODERSOURCE_H
+
+#include "audiodecoderbase.h"
+
+class DllExport AudioDecoderSource
+{
+    public:
+        AudioDecoderSource() : m_position(0) {};
+        virtual ~AudioDecoderSource() {};
+
+        /** Reads up to size bytes at offset, without touching the current
+            position. Must be safe to call from several threads at once.
+            Returns the number of bytes read, 0 at the end, or -1 on error. */
+        virtual long long pread(void *buffer, long long size, long long offset) = 0;
+
+        /** Total size of the source in bytes, or -1 if it can't be opened. */
+        virtual long long size() const = 0;
+
+        /** If the whole source is addressable memory, a pointer to its first
+            byte, otherwise NULL. Valid for the lifetime of the source. */
+        virtual const void *mapView() { return NULL; };
+
+        /** Sequential read from the current position, which it advances.
+            Not thread-safe; use pread() for that. */
+        long long read(void *buffer, long long size);
+
+        /** Moves the current position used by read(). */
+        int seek(long long position);
+        long long position() const { return m_position; };
+
+    protected:
+        long long m_position;
+};
+
+/** Reads a file with positional reads (pread or overlapped ReadFile). */
+class DllExport AudioDecoderFileSource : public AudioDecoderSource
+{
+    public:
+        AudioDecoderFileSource(const std::string filename);
+        virtual ~AudioDecoderFileSource();
+        virtual long long pread(void *buffer, long long size, long long offset);
+        virtual long long size() const { return m_size; };
+        bool isOpen() const { return m_size >= 0; };
+
+    protected:
+#ifdef _WIN32
+        void *m_hFile;
+#else
+        int m_fd;
+#endif
+        long long m_size;
+
+    private:
+        //Disable copy constructor and assignment operator
+        AudioDecoderFileSource(const AudioDecoderFileSource& that);
+        AudioDecoderFileSource& operator=(AudioDecoderFileSource const&);
+};
+
+/** Maps the whole file into memory, so mapView() works and reads are memcpy. */
+class DllExport AudioDecoderMmapSource : public AudioDecoderSource
+{
+    public:
+        AudioDecoderMmapSource(const std::string filename);
+        virtual ~AudioDecoderMmapSource();
+        virtual long long pread(void *buffer, long long size, long long offset);
+        virtual long long size() const { return m_size; };
+        virtual const void *mapView() { return m_pData; };
+        bool isOpen() const { return m_size >= 0; };
+
+    private:
+        //Disable copy constructor and assignment operator
+        AudioDecoderMmapSource(const AudioDecoderMmapSource& that);
+        AudioDecoderMmapSource& operator=(AudioDecoderMmapSource const&);
+
+        const unsigned char *m_pData;
+        long long m_size;
+#ifdef _WIN32
+        void *m_hMapping;
+#endif
+};
+
+/** A span of memory owned by the caller. Nothing is copied. */
+class DllExport AudioDecoderMemorySource : public AudioDecoderSource
+{
+    public:
+        AudioDecoderMemorySource(const void *data, long long size)
+        : m_pData(static_cast<const unsigned char*>(data)), m_size(size) {};
+        virtual long long pread(void *buffer, long long size, long long offset);
+        virtual long long size() const { return m_size; };
+        virtual const void *mapView() { return m_pData; };
+
+    private:
+        const unsigned char *m_pData;
+        long long m_size;
+};
+
+#endif // ifndef AUDIODECODERSOURCE_H
@@ -0,0 +1,133 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+
+/**
+ * \file audiodecodertrace.h
+ * \class AudioDecoderTrace
+ * \brief Timeline of what the decoder is doing, for chrome://tracing and Perfetto.
+ *
+ * Counters (see audiodecodermetrics.h) tell you how slow something was on
+ * average; a trace shows you which thread was waiting on which when the
+ * audio glitched. With AUDIODECODER_TRACE defined (the
+ * LIBAUDIODECODER_TRACE CMake option), open(), configureAudioStream(),
+ * seek(), read(), every codec decode call and every I/O request become
+ * spans. Without it the macros below compile to nothing.
+ *
+ * Recording is lock-free: each thread writes into its own ring of
+ * kEventsPerThread events, which is allocated the first time that thread
+ * records a span, and once a ring is full it overwrites its oldest events.
+ * Nothing is recorded until start() is called:
+ *
+ *     AudioDecoderTrace::start();
+ *     ... decode ...
+ *     AudioDecoderTrace::stop();
+ *     AudioDecoderTrace::save("decode.json"); // open it in ui.perfetto.dev
+ */
+
+#ifndef AUDIODECODERTRACE_H
+#define AUDIODECODERTRACE_H
+
+#include <string>
+#include "audiodecoderbase.h"
+
+class DllExport AudioDecoderTrace
+{
+    public:
+        static const int kEventsPerThread = 32768;
+
+        /** Start or stop recording spans, from any thread. */
+        static void start();
+        static void stop();
+        static bool isRecording();
+
+        /** Forget everything recorded so far. */
+        static void clear();
+
+        /** Name the calling thread in the trace, eg. "audio" or "disk". */
+        static void setThreadName(const char *name);
+
+        /** Everything recorded so far, in the Chrome trace event JSON format.
+            Safe to call while other threads are still recording. */
+        static std::string toJson();
+
+        /** Writes toJson() to a file. */
+        static int save(const std::string& path);
+
+    private:
+        AudioDecoderTrace();
+};
+
+/** One span: records its lifetime on the calling thread when it goes out of
+    scope. The name, category and argName must be string literals (or
+    otherwise live forever), as only the pointers are kept. Use the macros
+    instead, so the spans go away when tracing is compiled out. */
+class DllExport AudioDecoderTraceScope
+{
+    public:
+        AudioDecoderTraceScope(const char *category, const char *name,
+                               const char *argName = 0, long long arg = 0);
+        ~AudioDecoderTraceScope();
+
+    private:
+        AudioDecoderTraceScope(const AudioDecoderTraceScope&);
+        AudioDecoderTraceScope& operator=(const AudioDecoderTraceScope&);
+
+        const char *m_category;
+        const char *m_name;
+        const char *m_argName;
+        long long m_arg;
+        long long m_begin; // in ns; -1 when not recording
+};
+
+#define AUDIODECODER_TRACE_CONCAT2(a, b) a##b
+#define AUDIODECODER_TRACE_CONCAT(a, b) AUDIODECODER_TRACE_CONCAT2(a, b)
+
+#ifdef AUDIODECODER_TRACE
+/** A span from here to the end of the enclosing block. */
+#define AUDIODECODER_TRACE_SCOPE(category, name) \
+    AudioDecoderTraceScope AUDIODECODER_TRACE_CONCAT(traceScope, __LINE__)(category, name)
+/** The same, with one numeric argument shown alongside it (eg. a byte count). */
+#define AUDIODECODER_TRACE_SCOPE_ARG(category, name, argName, arg) \
+    AudioDecoderTraceScope AUDIODECODER_TRACE_CONCAT(traceScope, __LINE__)(category, name, argName, arg)
+#else
+#define AUDIODECODER_TRACE_SCOPE(category, name) do {} while (0)
+#define AUDIODECODER_TRACE_SCOPE_ARG(category, name, argName, arg) do {} while (0)
+#endif
+
+#endif //AUDIODECODERTRACE_H
@@ -0,0 +1,130 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+#include <assert.h>
+#include <stdint.h>
+#include <new>
+#include "audiodecoderallocator.h"
+
+class HeapAllocator : public AudioDecoderAllocator
+{
+    public:
+        virtual void *allocate(size_t bytes, size_t alignment) {
+            //operator new is only guaranteed to align for the fundamental
+            //types, so over-allocate and keep the original pointer in front.
+            if (alignment <= kDefaultAlignment) {
+                return ::operator new(bytes, std::nothrow);
+            }
+            unsigned char *raw = static_cast<unsigned char*>(
+                ::operator new(bytes + alignment + sizeof(void*), std::nothrow));
+            if (!raw) {
+                return NULL;
+            }
+            uintptr_t aligned = (reinterpret_cast<uintptr_t>(raw) + sizeof(void*) + alignment - 1)
+                                & ~static_cast<uintptr_t>(alignment - 1);
+            reinterpret_cast<void**>(aligned)[-1] = raw;
+            return reinterpret_cast<void*>(aligned);
+        };
+        virtual void deallocate(void *p, size_t bytes, size_t alignment) {
+            if (p && alignment > kDefaultAlignment) {
+                p = static_cast<void**>(p)[-1];
+            }
+            ::operator delete(p);
+        };
+};
+
+AudioDecoderAllocator *AudioDecoderAllocator::heap()
+{
+    static HeapAllocator s_heap;
+    return &s_heap;
+}
+
+AudioDecoderArena::AudioDecoderArena(void *buffer, size_t size, AudioDecoderAllocator *upstream)
+: m_pBuffer(static_cast<unsigned char*>(buffer))
+, m_size(size)
+, m_used(0)
+, m_pUpstream(upstream)
+{
+}
+
+void *AudioDecoderArena::allocate(size_t bytes, size_t alignment)
+{
+    const uintptr_t base = reinterpret_cast<uintptr_t>(m_pBuffer);
+    const uintptr_t start = (base + m_used + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+    if (start + bytes <= base + m_size) {
+        m_used = start + bytes - base;
+        return reinterpret_cast<void*>(start);
+    }
+    return m_pUpstream ? m_pUpstream->allocate(bytes, alignment) : NULL;
+}
+
+void AudioDecoderArena::deallocate(void *p, size_t bytes, size_t alignment)
+{
+    const unsigned char *pc = static_cast<unsigned char*>(p);
+    if (m_pUpstream && (pc < m_pBuffer || pc >= m_pBuffer + m_size)) {
+        m_pUpstream->deallocate(p, bytes, alignment);
+    }
+}
+
+AudioDecoderCountingAllocator::AudioDecoderCountingAllocator(AudioDecoderAllocator *upstream)
+: m_pUpstream(upstream)
+, m_forbidden(false)
+, m_allocations(0)
+, m_deallocations(0)
+, m_bytesInUse(0)
+, m_violations(0)
+{
+}
+
+void *AudioDecoderCountingAllocator::allocate(size_t bytes, size_t alignment)
+{
+    if (m_forbidden) {
+        m_violations++;
+        assert(!"AudioDecoderCountingAllocator: allocation while forbidden");
+    }
+    m_allocations++;
+    m_bytesInUse += bytes;
+    return m_pUpstream->allocate(bytes, alignment);
+}
+
+void AudioDecoderCountingAllocator::deallocate(void *p, size_t bytes, size_t alignment)
+{
+    m_deallocations++;
+    m_bytesInUse -= bytes;
+    m_pUpstream->deallocate(p, bytes, alignment);
+}
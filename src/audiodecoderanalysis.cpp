@@ -0,0 +1,516 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define ANALYSIS_USE_SSE
+#endif
+#include "audiodecoderanalysis.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/** Per channel peak (absolute value) and sum of squares of interleaved frames. */
+static void accumulateFrames(const SAMPLE *samples, int count, int channels,
+                             double *peaks, double *sumSquares)
+{
+    int i = 0;
+#ifdef ANALYSIS_USE_SSE
+    //With 1, 2 or 4 channels, lane k of every group of four always holds channel k % channels.
+    if (4 % channels == 0 && count >= 4) {
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+        __m128 vpeak = _mm_setzero_ps();
+        __m128 vsquares = _mm_setzero_ps();
+        for (; i + 4 <= count; i += 4) {
+            __m128 v = _mm_loadu_ps(samples + i);
+            vpeak = _mm_max_ps(vpeak, _mm_andnot_ps(signMask, v));
+            vsquares = _mm_add_ps(vsquares, _mm_mul_ps(v, v));
+        }
+        float lanes[2][4];
+        _mm_storeu_ps(lanes[0], vpeak);
+        _mm_storeu_ps(lanes[1], vsquares);
+        for (int lane = 0; lane < 4; lane++) {
+            const int channel = lane % channels;
+            peaks[channel] = lanes[0][lane] > peaks[channel] ? lanes[0][lane] : peaks[channel];
+            sumSquares[channel] += lanes[1][lane];
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        const int channel = i % channels;
+        const double v = samples[i];
+        peaks[channel] = fabs(v) > peaks[channel] ? fabs(v) : peaks[channel];
+        sumSquares[channel] += v * v;
+    }
+}
+
+//-------------------------------------------------------------------
+// AudioDecoderLoudnessSink
+//-------------------------------------------------------------------
+
+const int kRecentSubBlocks = 30;    // 3 s of 100 ms sub-blocks
+const int kMomentarySubBlocks = 4;  // 400 ms
+const double kAbsoluteGate = -70.0; // LUFS
+const double kRelativeGate = -10.0; // LU
+const int kHistogramBinsPerLU = 100;
+const int kHistogramBins = 75 * kHistogramBinsPerLU; // -70 to +5 LUFS
+
+static double powerToLufs(double power)
+{
+    return power > 0 ? -0.691 + 10.0 * log10(power) : -HUGE_VAL;
+}
+
+AudioDecoderLoudnessSink::AudioDecoderLoudnessSink()
+: m_iChannels(0)
+, m_iSubBlockFrames(0)
+, m_iFramesInSubBlock(0)
+, m_iRecentCount(0)
+, m_iRecentNext(0)
+, m_maxMomentary(-HUGE_VAL)
+, m_maxShortTerm(-HUGE_VAL)
+{
+    memset(&m_shelf, 0, sizeof(m_shelf));
+    memset(&m_highPass, 0, sizeof(m_highPass));
+}
+
+void AudioDecoderLoudnessSink::begin(int channels, int sampleRate)
+{
+    m_iChannels = channels;
+    m_iSubBlockFrames = static_cast<int>(sampleRate / 10.0 + 0.5);
+
+    //BS.1770 K-weighting: a high shelf for the head, then the RLB high-pass,
+    //with the coefficients worked out for this sample rate.
+    double K = tan(M_PI * 1681.974450955533 / sampleRate);
+    double Q = 0.7071752369554196;
+    const double Vh = pow(10.0, 3.999843853973347 / 20.0);
+    const double Vb = pow(Vh, 0.4996667741545416);
+    double a0 = 1.0 + K / Q + K * K;
+    m_shelf.b0 = (Vh + Vb * K / Q + K * K) / a0;
+    m_shelf.b1 = 2.0 * (K * K - Vh) / a0;
+    m_shelf.b2 = (Vh - Vb * K / Q + K * K) / a0;
+    m_shelf.a1 = 2.0 * (K * K - 1.0) / a0;
+    m_shelf.a2 = (1.0 - K / Q + K * K) / a0;
+
+    K = tan(M_PI * 38.13547087602444 / sampleRate);
+    Q = 0.5003270373238773;
+    a0 = 1.0 + K / Q + K * K;
+    m_highPass.b0 = 1.0;
+    m_highPass.b1 = -2.0;
+    m_highPass.b2 = 1.0;
+    m_highPass.a1 = 2.0 * (K * K - 1.0) / a0;
+    m_highPass.a2 = (1.0 - K / Q + K * K) / a0;
+
+    //Surround channels count +1.5 dB; in 5.1 (L R C LFE Ls Rs) the LFE isn't counted.
+    m_weights.assign(channels, 1.0);
+    if (channels == 5) {
+        m_weights[3] = m_weights[4] = 1.41;
+    } else if (channels == 6) {
+        m_weights[3] = 0.0;
+        m_weights[4] = m_weights[5] = 1.41;
+    }
+
+    m_state.assign(channels * 4, 0.0);
+    m_subBlockSum.assign(channels, 0.0);
+    m_recent.assign(kRecentSubBlocks, 0.0);
+    m_histogramCount.assign(kHistogramBins, 0);
+    m_histogramPower.assign(kHistogramBins, 0.0);
+    m_maxMomentary = -HUGE_VAL;
+    m_maxShortTerm = -HUGE_VAL;
+    resetFilters();
+}
+
+void AudioDecoderLoudnessSink::resetFilters()
+{
+    std::fill(m_state.begin(), m_state.end(), 0.0);
+    std::fill(m_subBlockSum.begin(), m_subBlockSum.end(), 0.0);
+    std::fill(m_recent.begin(), m_recent.end(), 0.0);
+    m_iFramesInSubBlock = 0;
+    m_iRecentCount = 0;
+    m_iRecentNext = 0;
+}
+
+void AudioDecoderLoudnessSink::process(const SAMPLE *buffer, int size)
+{
+    if (m_iChannels <= 0 || m_iSubBlockFrames <= 0) {
+        return;
+    }
+    const int frames = size / m_iChannels;
+    for (int f = 0; f < frames; f++) {
+        //The filters are recursive, so this runs a sample at a time in double
+        //precision; it's the other sinks' loops that vectorize.
+        for (int c = 0; c < m_iChannels; c++) {
+            double *s = &m_state[c * 4];
+            const double x = buffer[f * m_iChannels + c];
+            const double y = m_shelf.b0 * x + s[0];
+            s[0] = m_shelf.b1 * x - m_shelf.a1 * y + s[1];
+            s[1] = m_shelf.b2 * x - m_shelf.a2 * y;
+            const double z = m_highPass.b0 * y + s[2];
+            s[2] = m_highPass.b1 * y - m_highPass.a1 * z + s[3];
+            s[3] = m_highPass.b2 * y - m_highPass.a2 * z;
+            m_subBlockSum[c] += z * z;
+        }
+        if (++m_iFramesInSubBlock < m_iSubBlockFrames) {
+            continue;
+        }
+
+        double power = 0;
+        for (int c = 0; c < m_iChannels; c++) {
+            power += m_weights[c] * m_subBlockSum[c] / m_iSubBlockFrames;
+            m_subBlockSum[c] = 0;
+        }
+        m_iFramesInSubBlock = 0;
+        m_recent[m_iRecentNext] = power;
+        m_iRecentNext = (m_iRecentNext + 1) % kRecentSubBlocks;
+        m_iRecentCount++;
+
+        //Gating blocks are 400 ms long and overlap by 75%, one per sub-block.
+        if (m_iRecentCount >= kMomentarySubBlocks) {
+            const double block = windowPower(kMomentarySubBlocks);
+            addGatingBlock(block);
+            if (powerToLufs(block) > m_maxMomentary) {
+                m_maxMomentary = powerToLufs(block);
+            }
+        }
+        if (m_iRecentCount >= kRecentSubBlocks) {
+            const double shortTerm = powerToLufs(windowPower(kRecentSubBlocks));
+            if (shortTerm > m_maxShortTerm) {
+                m_maxShortTerm = shortTerm;
+            }
+        }
+    }
+}
+
+/** Mean power of the last subBlocks sub-blocks; missing ones count as silence. */
+double AudioDecoderLoudnessSink::windowPower(int subBlocks) const
+{
+    double sum = 0;
+    const int available = m_iRecentCount < subBlocks ? m_iRecentCount : subBlocks;
+    for (int i = 1; i <= available; i++) {
+        sum += m_recent[(m_iRecentNext - i + kRecentSubBlocks) % kRecentSubBlocks];
+    }
+    return sum / subBlocks;
+}
+
+void AudioDecoderLoudnessSink::seeked(int sampleIdx)
+{
+    //The filters and windows mustn't run across the jump; the gating blocks
+    //measured so far still count towards the integrated loudness.
+    resetFilters();
+}
+
+/** Blocks are kept in a histogram of 0.01 LU bins rather than one by one,
+    so memory stays fixed however long the file. Each bin also sums the exact
+    power of its blocks; only the relative gate is rounded to a bin. */
+void AudioDecoderLoudnessSink::addGatingBlock(double power)
+{
+    const double loudness = powerToLufs(power);
+    if (loudness <= kAbsoluteGate) {
+        return;
+    }
+    int bin = static_cast<int>((loudness - kAbsoluteGate) * kHistogramBinsPerLU);
+    if (bin >= kHistogramBins) {
+        bin = kHistogramBins - 1;
+    }
+    m_histogramCount[bin]++;
+    m_histogramPower[bin] += power;
+}
+
+double AudioDecoderLoudnessSink::integratedLoudness() const
+{
+    double sum = 0;
+    long long count = 0;
+    for (int i = 0; i < kHistogramBins; i++) {
+        sum += m_histogramPower[i];
+        count += m_histogramCount[i];
+    }
+    if (count == 0) {
+        return -HUGE_VAL;
+    }
+    const double relativeGate = powerToLufs(sum / count) + kRelativeGate;
+    int firstBin = static_cast<int>(floor((relativeGate - kAbsoluteGate) * kHistogramBinsPerLU + 0.5));
+    if (firstBin < 0) {
+        firstBin = 0;
+    }
+    sum = 0;
+    count = 0;
+    for (int i = firstBin; i < kHistogramBins; i++) {
+        sum += m_histogramPower[i];
+        count += m_histogramCount[i];
+    }
+    return count > 0 ? powerToLufs(sum / count) : -HUGE_VAL;
+}
+
+double AudioDecoderLoudnessSink::momentaryLoudness() const
+{
+    return powerToLufs(windowPower(kMomentarySubBlocks));
+}
+
+double AudioDecoderLoudnessSink::shortTermLoudness() const
+{
+    return powerToLufs(windowPower(kRecentSubBlocks));
+}
+
+//-------------------------------------------------------------------
+// AudioDecoderTruePeakSink
+//-------------------------------------------------------------------
+
+const int kOversample = 4;
+const int kTaps = 12; // per phase; 48 in all
+const int kChunkFrames = 1024;
+
+/** Polyphase windowed-sinc interpolator. Each phase is stored back to front
+    so that phase p of input sample t is a plain dot product with
+    history[t .. t + kTaps - 1]. */
+class TruePeakFilter
+{
+    public:
+        TruePeakFilter() {
+            const int length = kOversample * kTaps;
+            const double center = (length - 1) / 2.0;
+            for (int p = 0; p < kOversample; p++) {
+                double sum = 0;
+                for (int j = 0; j < kTaps; j++) {
+                    const int n = kOversample * (kTaps - 1 - j) + p;
+                    const double x = (n - center) / kOversample;
+                    const double sinc = x == 0 ? 1.0 : sin(M_PI * x) / (M_PI * x);
+                    //Blackman-Harris window
+                    const double w = 2.0 * M_PI * (n + 0.5) / length;
+                    const double window = 0.35875 - 0.48829 * cos(w) + 0.14128 * cos(2 * w) - 0.01168 * cos(3 * w);
+                    coefficients[p][j] = static_cast<float>(sinc * window);
+                    sum += coefficients[p][j];
+                }
+                for (int j = 0; j < kTaps; j++) {
+                    coefficients[p][j] = static_cast<float>(coefficients[p][j] / sum);
+                }
+            }
+        }
+        float coefficients[kOversample][kTaps];
+};
+
+static const TruePeakFilter s_truePeakFilter;
+
+AudioDecoderTruePeakSink::AudioDecoderTruePeakSink()
+: m_iChannels(0)
+{
+}
+
+void AudioDecoderTruePeakSink::begin(int channels, int sampleRate)
+{
+    m_iChannels = channels;
+    m_history.assign(channels * (kTaps - 1), 0.0f);
+    m_samplePeak.assign(channels, 0.0);
+    m_truePeak.assign(channels, 0.0);
+    m_sumSquares.assign(channels, 0.0);
+    m_scratch.assign(kTaps - 1 + kChunkFrames, 0.0f);
+}
+
+void AudioDecoderTruePeakSink::process(const SAMPLE *buffer, int size)
+{
+    if (m_iChannels <= 0) {
+        return;
+    }
+    accumulateFrames(buffer, size, m_iChannels, &m_samplePeak[0], &m_sumSquares[0]);
+    for (int c = 0; c < m_iChannels; c++) {
+        if (m_samplePeak[c] > m_truePeak[c]) {
+            m_truePeak[c] = m_samplePeak[c];
+        }
+    }
+
+    //Work in chunks so the scratch line sized in begin() is always enough;
+    //nothing is allocated while decoding.
+    const int frames = size / m_iChannels;
+    for (int f = 0; f < frames; f += kChunkFrames) {
+        oversample(buffer + f * m_iChannels, frames - f < kChunkFrames ? frames - f : kChunkFrames);
+    }
+}
+
+/** Runs up to kChunkFrames frames through the interpolator, per channel. */
+void AudioDecoderTruePeakSink::oversample(const SAMPLE *buffer, int frames)
+{
+    float *line = &m_scratch[0];
+    for (int c = 0; c < m_iChannels; c++) {
+        //De-interleave behind this channel's history so the taps are contiguous.
+        float *history = &m_history[c * (kTaps - 1)];
+        memcpy(line, history, (kTaps - 1) * sizeof(float));
+        for (int f = 0; f < frames; f++) {
+            line[kTaps - 1 + f] = buffer[f * m_iChannels + c];
+        }
+        float peak = static_cast<float>(m_truePeak[c]);
+        for (int f = 0; f < frames; f++) {
+            const float *x = line + f;
+            for (int p = 0; p < kOversample; p++) {
+                const float *h = s_truePeakFilter.coefficients[p];
+                float y = 0;
+                for (int j = 0; j < kTaps; j++) {
+                    y += h[j] * x[j];
+                }
+                y = fabsf(y);
+                peak = y > peak ? y : peak;
+            }
+        }
+        m_truePeak[c] = peak;
+        memcpy(history, line + frames, (kTaps - 1) * sizeof(float));
+    }
+}
+
+void AudioDecoderTruePeakSink::seeked(int sampleIdx)
+{
+    //Don't interpolate across the jump.
+    std::fill(m_history.begin(), m_history.end(), 0.0f);
+}
+
+double AudioDecoderTruePeakSink::truePeakDb() const
+{
+    double peak = 0;
+    for (int c = 0; c < m_iChannels; c++) {
+        peak = m_truePeak[c] > peak ? m_truePeak[c] : peak;
+    }
+    return peak > 0 ? 20.0 * log10(peak) : -HUGE_VAL;
+}
+
+//-------------------------------------------------------------------
+// AudioDecoderRmsSink
+//-------------------------------------------------------------------
+
+AudioDecoderRmsSink::AudioDecoderRmsSink()
+: m_frames(0)
+, m_iChannels(0)
+{
+}
+
+void AudioDecoderRmsSink::begin(int channels, int sampleRate)
+{
+    m_iChannels = channels;
+    m_sumSquares.assign(channels, 0.0);
+    m_peaks.assign(channels, 0.0);
+    m_frames = 0;
+}
+
+void AudioDecoderRmsSink::process(const SAMPLE *buffer, int size)
+{
+    if (m_iChannels <= 0) {
+        return;
+    }
+    accumulateFrames(buffer, size, m_iChannels, &m_peaks[0], &m_sumSquares[0]);
+    m_frames += size / m_iChannels;
+}
+
+double AudioDecoderRmsSink::rms(int channel) const
+{
+    return m_frames > 0 ? sqrt(m_sumSquares[channel] / m_frames) : 0.0;
+}
+
+double AudioDecoderRmsSink::rms() const
+{
+    double sum = 0;
+    for (int c = 0; c < m_iChannels; c++) {
+        sum += m_sumSquares[c];
+    }
+    return m_frames > 0 ? sqrt(sum / (m_frames * m_iChannels)) : 0.0;
+}
+
+double AudioDecoderRmsSink::rmsDb() const
+{
+    const double value = rms();
+    return value > 0 ? 20.0 * log10(value) : -HUGE_VAL;
+}
+
+//-------------------------------------------------------------------
+// AudioDecoderSilenceSink
+//-------------------------------------------------------------------
+
+AudioDecoderSilenceSink::AudioDecoderSilenceSink(double thresholdDb)
+: m_threshold(static_cast<float>(pow(10.0, thresholdDb / 20.0)))
+, m_iChannels(0)
+, m_frame(0)
+, m_firstSound(-1)
+, m_lastSound(-1)
+{
+}
+
+void AudioDecoderSilenceSink::begin(int channels, int sampleRate)
+{
+    m_iChannels = channels;
+    m_frame = 0;
+    m_firstSound = -1;
+    m_lastSound = -1;
+}
+
+void AudioDecoderSilenceSink::process(const SAMPLE *buffer, int size)
+{
+    if (m_iChannels <= 0) {
+        return;
+    }
+    const int count = size - size % m_iChannels;
+    //Only the ends matter: scan forwards for the first sound (until we've
+    //found one) and backwards for the last.
+    int last = -1;
+    for (int i = count - 1; i >= 0; i--) {
+        if (fabsf(buffer[i]) > m_threshold) {
+            last = i;
+            break;
+        }
+    }
+    if (last >= 0) {
+        const long long lastFrame = m_frame + last / m_iChannels;
+        if (lastFrame > m_lastSound) {
+            m_lastSound = lastFrame;
+        }
+        for (int i = 0; i <= last; i++) {
+            if (fabsf(buffer[i]) > m_threshold) {
+                const long long firstFrame = m_frame + i / m_iChannels;
+                if (m_firstSound < 0 || firstFrame < m_firstSound) {
+                    m_firstSound = firstFrame;
+                }
+                break;
+            }
+        }
+    }
+    m_frame += count / m_iChannels;
+}
+
+void AudioDecoderSilenceSink::seeked(int sampleIdx)
+{
+    if (m_iChannels > 0) {
+        m_frame = sampleIdx / m_iChannels;
+    }
+}
@@ -0,0 +1,179 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+
+#include "audiodecoder.h"
+#include "audiodecoderasync.h"
+
+AudioDecoderExecutor *AudioDecoderExecutor::defaultExecutor()
+{
+    static AudioDecoderThreadPoolExecutor s_executor(1);
+    return &s_executor;
+}
+
+AudioDecoderThreadPoolExecutor::AudioDecoderThreadPoolExecutor(int numThreads)
+: m_quit(false)
+{
+    if (numThreads <= 0) {
+        numThreads = 1;
+    }
+    for (int i = 0; i < numThreads; i++) {
+        m_threads.push_back(std::thread(&AudioDecoderThreadPoolExecutor::workerLoop, this));
+    }
+}
+
+AudioDecoderThreadPoolExecutor::~AudioDecoderThreadPoolExecutor()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_wake.notify_all();
+    for (size_t i = 0; i < m_threads.size(); i++) {
+        m_threads[i].join();
+    }
+}
+
+void AudioDecoderThreadPoolExecutor::execute(std::function<void()> work)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back(work);
+    }
+    m_wake.notify_one();
+}
+
+void AudioDecoderThreadPoolExecutor::workerLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        while (m_queue.empty() && !m_quit) {
+            m_wake.wait(lock);
+        }
+        if (m_queue.empty()) {
+            return; // quitting, and the queue is done
+        }
+        std::function<void()> work = m_queue.front();
+        m_queue.pop_front();
+        lock.unlock();
+        work();
+        lock.lock();
+    }
+}
+
+AudioDecoderAsync::AudioDecoderAsync(AudioDecoder *decoder, AudioDecoderExecutor *executor)
+: m_pDecoder(decoder)
+, m_pExecutor(executor ? executor : AudioDecoderExecutor::defaultExecutor())
+, m_running(false)
+{
+}
+
+AudioDecoderAsync::~AudioDecoderAsync()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_running) {
+        m_finished.wait(lock);
+    }
+}
+
+void AudioDecoderAsync::openAsync(Callback done)
+{
+    AudioDecoder *decoder = m_pDecoder;
+    enqueue([decoder, done]() {
+        int result = decoder->open();
+        if (done) {
+            done(result);
+        }
+    });
+}
+
+void AudioDecoderAsync::seekAsync(int sampleIdx, Callback done)
+{
+    AudioDecoder *decoder = m_pDecoder;
+    enqueue([decoder, sampleIdx, done]() {
+        int result = decoder->seek(sampleIdx);
+        if (done) {
+            done(result);
+        }
+    });
+}
+
+void AudioDecoderAsync::readAsync(int size, SAMPLE *buffer, Callback done)
+{
+    AudioDecoder *decoder = m_pDecoder;
+    enqueue([decoder, size, buffer, done]() {
+        int result = decoder->read(size, buffer);
+        if (done) {
+            done(result);
+        }
+    });
+}
+
+/** The decoder isn't thread-safe, so the calls line up here and one drain()
+    at a time runs them on the executor, like a strand. */
+void AudioDecoderAsync::enqueue(std::function<void()> call)
+{
+    bool start = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_calls.push_back(call);
+        if (!m_running) {
+            m_running = true;
+            start = true;
+        }
+    }
+    if (start) {
+        m_pExecutor->execute(std::bind(&AudioDecoderAsync::drain, this));
+    }
+}
+
+void AudioDecoderAsync::drain()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_calls.empty()) {
+        std::function<void()> call = m_calls.front();
+        m_calls.pop_front();
+        //A callback may queue the next call (a coroutine usually does), which
+        //just lands in m_calls for this loop to pick up.
+        lock.unlock();
+        call();
+        lock.lock();
+    }
+    m_running = false;
+    m_finished.notify_all();
+}
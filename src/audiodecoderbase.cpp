@@ -36,15 +36,32 @@
  * license above.
  */
 
+#include <algorithm>
 #include "audiodecoderbase.h"
+#include "audiodecoderallocator.h"
+#include "audiodecoderconvert.h"
+#include "audiodecodersink.h"
 
 AudioDecoderBase::AudioDecoderBase(const std::string filename)
-: m_iNumSamples(0)
+: m_filename(filename)
+, m_pSource(NULL)
+, m_iNumSamples(0)
 , m_iChannels(0)
 , m_iSampleRate(0)
 , m_fDuration(0)
 , m_iPositionInSamples(0)
-, m_filename(filename)
+, m_pAllocator(NULL)
+{
+}
+
+AudioDecoderBase::AudioDecoderBase(AudioDecoderSource *source)
+: m_pSource(source)
+, m_iNumSamples(0)
+, m_iChannels(0)
+, m_iSampleRate(0)
+, m_fDuration(0)
+, m_iPositionInSamples(0)
+, m_pAllocator(NULL)
 {
 }
 
@@ -53,4 +70,68 @@ AudioDecoderBase::~AudioDecoderBase()
 
 }
 
+void AudioDecoderBase::addSink(AudioDecoderSink *sink)
+{
+    m_sinks.push_back(sink);
+}
+
+void AudioDecoderBase::removeSink(AudioDecoderSink *sink)
+{
+    m_sinks.erase(std::remove(m_sinks.begin(), m_sinks.end(), sink), m_sinks.end());
+}
+
+void AudioDecoderBase::setInput(const std::string& filename, AudioDecoderSource *source)
+{
+    m_filename = filename;
+    m_pSource = source;
+    m_iNumSamples = 0;
+    m_iChannels = 0;
+    m_iSampleRate = 0;
+    m_fDuration = 0;
+    m_iPositionInSamples = 0;
+}
 
+AudioDecoderAllocator *AudioDecoderBase::allocator() const
+{
+    return m_pAllocator ? m_pAllocator : AudioDecoderAllocator::heap();
+}
+
+void AudioDecoderBase::beginSinks()
+{
+    for (size_t i = 0; i < m_sinks.size(); i++) {
+        m_sinks[i]->begin(m_iChannels, m_iSampleRate);
+    }
+}
+
+void AudioDecoderBase::notifySinks(const SAMPLE *buffer, int size)
+{
+    if (size <= 0) {
+        return;
+    }
+    for (size_t i = 0; i < m_sinks.size(); i++) {
+        m_sinks[i]->process(buffer, size);
+    }
+}
+
+void AudioDecoderBase::notifySinks(const short *buffer, int size)
+{
+    if (m_sinks.empty()) {
+        return;
+    }
+    SAMPLE converted[1024];
+    const int chunk = (1024 / m_iChannels) * m_iChannels; // whole frames
+    const AudioDecoderConvertFn convert =
+        AudioDecoderConvert::select(AudioDecoderConvert::FORMAT_S16, m_iChannels);
+    for (int i = 0; i < size; i += chunk) {
+        const int n = size - i < chunk ? size - i : chunk;
+        convert(buffer + i, converted, n / m_iChannels, m_iChannels);
+        notifySinks(converted, n);
+    }
+}
+
+void AudioDecoderBase::seekSinks(int sampleIdx)
+{
+    for (size_t i = 0; i < m_sinks.size(); i++) {
+        m_sinks[i]->seeked(sampleIdx);
+    }
+}
@@ -0,0 +1,322 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+#include <chrono>
+#include "audiodecoder.h"
+#include "audiodecoderbatch.h"
+#include "audiodecoderprobe.h"
+
+const int kDefaultBlockSize = 8192;         // in samples
+const int kDefaultSplitSize = 44100 * 2 * 600; // ten minutes of 44.1 kHz stereo
+
+AudioDecoderBatch::AudioDecoderBatch(int numThreads)
+: m_iNumThreads(numThreads)
+, m_iBlockSize(kDefaultBlockSize)
+, m_iSplitSize(kDefaultSplitSize)
+, m_job(JOB_PROBE)
+, m_pSink(NULL)
+, m_pListener(NULL)
+, m_ioMode(AudioDecoderReadAheadSource::IO_CACHED)
+, m_fileStates(NULL)
+{
+    if (m_iNumThreads <= 0) {
+        m_iNumThreads = std::thread::hardware_concurrency();
+    }
+    if (m_iNumThreads <= 0) {
+        m_iNumThreads = 2;
+    }
+    m_outstandingTasks = 0;
+    m_filesFinished = 0;
+}
+
+AudioDecoderBatch::~AudioDecoderBatch()
+{
+    delete [] m_fileStates;
+}
+
+void AudioDecoderBatch::setBlockSize(int samples)
+{
+    //Keep it a multiple of two so stereo blocks never end mid-frame.
+    m_iBlockSize = samples < 2 ? 2 : samples - (samples % 2);
+}
+
+int AudioDecoderBatch::run(const std::vector<std::string>& filenames)
+{
+    m_filenames = filenames;
+    m_results.assign(filenames.size(), AudioDecoderBatchResult());
+    delete [] m_fileStates;
+    m_fileStates = new FileState[filenames.size()];
+    for (size_t i = 0; i < filenames.size(); i++) {
+        AudioDecoderBatchResult& result = m_results[i];
+        result.filename = filenames[i];
+        result.status = AUDIODECODER_ERROR;
+        result.numSamples = 0;
+        result.channels = 0;
+        result.sampleRate = 0;
+        result.duration = 0;
+        result.samplesDecoded = 0;
+        m_fileStates[i].pendingParts = 1;
+        m_fileStates[i].samplesDecoded = 0;
+        m_fileStates[i].failed = false;
+    }
+    m_outstandingTasks = static_cast<int>(filenames.size());
+    m_filesFinished = 0;
+
+    //Deal the files out round-robin; idle workers steal from the busy ones.
+    for (int i = 0; i < m_iNumThreads; i++) {
+        Worker *worker = new Worker();
+        worker->buffer.resize(m_iBlockSize);
+        m_workers.push_back(worker);
+    }
+    for (size_t i = 0; i < filenames.size(); i++) {
+        Task task = { static_cast<int>(i), 0, 0, true, true };
+        m_workers[i % m_iNumThreads]->tasks.push_back(task);
+    }
+
+    for (int i = 0; i < m_iNumThreads; i++) {
+        m_workers[i]->thread = std::thread(&AudioDecoderBatch::workerLoop, this, i);
+    }
+    for (int i = 0; i < m_iNumThreads; i++) {
+        m_workers[i]->thread.join();
+        delete m_workers[i]->decoder;
+        delete m_workers[i];
+    }
+    m_workers.clear();
+
+    for (size_t i = 0; i < m_results.size(); i++) {
+        if (m_results[i].status != AUDIODECODER_OK) {
+            return AUDIODECODER_ERROR;
+        }
+    }
+    return AUDIODECODER_OK;
+}
+
+void AudioDecoderBatch::workerLoop(int workerIndex)
+{
+    Task task;
+    while (m_outstandingTasks > 0) {
+        if (popTask(workerIndex, &task) || stealTask(workerIndex, &task)) {
+            runTask(workerIndex, task);
+            if (--m_outstandingTasks == 0) {
+                m_idleCondition.notify_all();
+            }
+            continue;
+        }
+        //Nothing to do right now, but a long file somewhere may still be
+        //split into sub-tasks. Nap until someone pushes work.
+        std::unique_lock<std::mutex> lock(m_idleMutex);
+        m_idleCondition.wait_for(lock, std::chrono::milliseconds(5));
+    }
+}
+
+bool AudioDecoderBatch::popTask(int workerIndex, Task *task)
+{
+    Worker *worker = m_workers[workerIndex];
+    std::lock_guard<std::mutex> lock(worker->mutex);
+    if (worker->tasks.empty()) {
+        return false;
+    }
+    //LIFO for our own queue: the sub-tasks we just pushed are still warm.
+    *task = worker->tasks.back();
+    worker->tasks.pop_back();
+    return true;
+}
+
+bool AudioDecoderBatch::stealTask(int workerIndex, Task *task)
+{
+    for (int i = 1; i < m_iNumThreads; i++) {
+        Worker *victim = m_workers[(workerIndex + i) % m_iNumThreads];
+        std::lock_guard<std::mutex> lock(victim->mutex);
+        if (!victim->tasks.empty()) {
+            //FIFO when stealing, which takes the oldest (usually biggest) work.
+            *task = victim->tasks.front();
+            victim->tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void AudioDecoderBatch::pushTask(int workerIndex, const Task& task)
+{
+    m_outstandingTasks++;
+    {
+        Worker *worker = m_workers[workerIndex];
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        worker->tasks.push_back(task);
+    }
+    m_idleCondition.notify_one();
+}
+
+void AudioDecoderBatch::runTask(int workerIndex, const Task& task)
+{
+    //Probing only needs the headers, so don't spin up a decoder unless the
+    //container is one AudioDecoderProbe doesn't understand.
+    AudioStreamInfo info;
+    if (m_job == JOB_PROBE &&
+        AudioDecoderProbe::probe(m_filenames[task.fileIndex], &info) == AUDIODECODER_OK) {
+        AudioDecoderBatchResult& result = m_results[task.fileIndex];
+        result.numSamples = info.numSamples;
+        result.channels = info.channels;
+        result.sampleRate = info.sampleRate;
+        result.duration = info.duration;
+        finishPart(task.fileIndex);
+        return;
+    }
+
+    //In a scan, read through our own source so the I/O can stay out of the
+    //page cache; otherwise let the backend open the file however it likes.
+    //Each worker keeps one decoder and moves it from file to file.
+    Worker *worker = m_workers[workerIndex];
+    AudioDecoderReadAheadSource *pSource = NULL;
+    if (m_ioMode != AudioDecoderReadAheadSource::IO_CACHED) {
+        pSource = new AudioDecoderReadAheadSource(m_filenames[task.fileIndex], 4,
+                                                  256 * 1024, m_ioMode);
+    }
+    int openStatus;
+    if (!worker->decoder) {
+        worker->decoder = pSource ? new AudioDecoder(pSource)
+                                  : new AudioDecoder(m_filenames[task.fileIndex]);
+        openStatus = worker->decoder->open();
+    } else if (pSource) {
+        openStatus = worker->decoder->reset(pSource);
+    } else {
+        openStatus = worker->decoder->reset(m_filenames[task.fileIndex]);
+    }
+    decodeTask(workerIndex, task, worker->decoder, openStatus);
+    worker->decoder->close(); // let go of pSource before it goes
+    delete pSource;
+}
+
+void AudioDecoderBatch::decodeTask(int workerIndex, const Task& task, AudioDecoder *decoder,
+                                   int openStatus)
+{
+    Worker *worker = m_workers[workerIndex];
+    FileState& state = m_fileStates[task.fileIndex];
+
+    if (openStatus != AUDIODECODER_OK) {
+        state.failed = true;
+        finishPart(task.fileIndex);
+        return;
+    }
+
+    Task range = task;
+    if (task.isRoot) {
+        //Only the root task writes the properties, so no locking is needed.
+        AudioDecoderBatchResult& result = m_results[task.fileIndex];
+        result.numSamples = decoder->numSamples();
+        result.channels = decoder->channels();
+        result.sampleRate = decoder->sampleRate();
+        result.duration = decoder->duration();
+
+        if (m_job == JOB_PROBE) {
+            finishPart(task.fileIndex);
+            return;
+        }
+
+        const int channels = decoder->channels() > 0 ? decoder->channels() : 2;
+        const int splitSize = m_iSplitSize - (m_iSplitSize % channels);
+        if (splitSize > 0 && decoder->numSamples() > splitSize) {
+            //Hand the tail of the file out as sub-tasks and keep the head.
+            //The last part reads until EOF in case numSamples() is a bit off.
+            for (int start = splitSize; start < decoder->numSamples(); start += splitSize) {
+                Task part = { task.fileIndex, start, start + splitSize, false,
+                              start + splitSize >= decoder->numSamples() };
+                state.pendingParts++;
+                pushTask(workerIndex, part);
+            }
+            range.endSample = splitSize;
+            range.toEnd = false;
+        }
+    } else if (range.startSample > 0) {
+        decoder->seek(range.startSample);
+    }
+
+    if (decodeRange(worker, range, decoder) != AUDIODECODER_OK) {
+        state.failed = true;
+    }
+    finishPart(task.fileIndex);
+}
+
+int AudioDecoderBatch::decodeRange(Worker *worker, const Task& task, AudioDecoder *decoder)
+{
+    const int channels = decoder->channels() > 0 ? decoder->channels() : 2;
+    const int blockSize = m_iBlockSize - (m_iBlockSize % channels);
+    SAMPLE *buffer = &worker->buffer[0];
+    int position = task.startSample;
+
+    while (task.toEnd || position < task.endSample) {
+        int samplesToRead = blockSize;
+        if (!task.toEnd && task.endSample - position < samplesToRead) {
+            samplesToRead = task.endSample - position;
+        }
+        int samplesRead = decoder->read(samplesToRead, buffer);
+        if (samplesRead <= 0) {
+            break;
+        }
+        if (m_job == JOB_DECODE_TO_SINK && m_pSink) {
+            m_pSink->process(task.fileIndex, position, buffer, samplesRead);
+        }
+        position += samplesRead;
+    }
+    m_fileStates[task.fileIndex].samplesDecoded += position - task.startSample;
+
+    //A split part that comes up short means the backend gave up early.
+    if (!task.toEnd && position < task.endSample) {
+        return AUDIODECODER_ERROR;
+    }
+    return AUDIODECODER_OK;
+}
+
+void AudioDecoderBatch::finishPart(int fileIndex)
+{
+    FileState& state = m_fileStates[fileIndex];
+    if (--state.pendingParts > 0) {
+        return;
+    }
+
+    AudioDecoderBatchResult& result = m_results[fileIndex];
+    result.status = state.failed ? AUDIODECODER_ERROR : AUDIODECODER_OK;
+    result.samplesDecoded = state.samplesDecoded;
+
+    int filesFinished = ++m_filesFinished;
+    if (m_pListener) {
+        m_pListener->fileFinished(fileIndex, result);
+        m_pListener->progress(filesFinished, static_cast<int>(m_filenames.size()));
+    }
+}
@@ -0,0 +1,192 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+
+#include "audiodecoder.h"
+#include "audiodecodercapi.h"
+#include "audiodecoderprobe.h"
+#include "audiodecodersource.h"
+
+struct audiodecoder
+{
+    AudioDecoder *decoder;
+    AudioDecoderSource *source; // the memory source we made, or NULL
+};
+
+static audiodecoder *openDecoder(AudioDecoder *decoder, AudioDecoderSource *source)
+{
+    if (decoder->open() != AUDIODECODER_OK) {
+        delete decoder;
+        delete source;
+        return NULL;
+    }
+    audiodecoder *handle = new audiodecoder;
+    handle->decoder = decoder;
+    handle->source = source;
+    return handle;
+}
+
+static void copyStreamInfo(const AudioStreamInfo& from, audiodecoder_stream_info *to)
+{
+    to->format = from.format; // the same numbering
+    to->sample_rate = from.sampleRate;
+    to->channels = from.channels;
+    to->bits_per_sample = from.bitsPerSample;
+    to->num_samples = from.numSamples;
+    to->duration = from.duration;
+    to->bitrate = from.bitrate;
+}
+
+unsigned int audiodecoder_api_version(void)
+{
+    return AUDIODECODER_CAPI_VERSION;
+}
+
+audiodecoder *audiodecoder_open(const char *path)
+{
+    if (!path) {
+        return NULL;
+    }
+    return openDecoder(new AudioDecoder(std::string(path)), NULL);
+}
+
+audiodecoder *audiodecoder_open_memory(const void *data, long long size)
+{
+    if (!data || size <= 0) {
+        return NULL;
+    }
+    AudioDecoderSource *source = new AudioDecoderMemorySource(data, size);
+    return openDecoder(new AudioDecoder(source), source);
+}
+
+void audiodecoder_close(audiodecoder *decoder)
+{
+    if (!decoder) {
+        return;
+    }
+    delete decoder->decoder; // before the source it reads from
+    delete decoder->source;
+    delete decoder;
+}
+
+int audiodecoder_get_info(const audiodecoder *decoder, audiodecoder_info *info)
+{
+    if (!decoder || !info) {
+        return AUDIODECODER_ERROR;
+    }
+    info->channels = decoder->decoder->channels();
+    info->sample_rate = decoder->decoder->sampleRate();
+    info->num_samples = decoder->decoder->numSamples();
+    info->duration = decoder->decoder->duration();
+    return AUDIODECODER_OK;
+}
+
+int audiodecoder_probe(const char *path, audiodecoder_stream_info *info)
+{
+    AudioStreamInfo streamInfo;
+    if (!path || !info || AudioDecoderProbe::probe(std::string(path), &streamInfo) != AUDIODECODER_OK) {
+        return AUDIODECODER_ERROR;
+    }
+    copyStreamInfo(streamInfo, info);
+    return AUDIODECODER_OK;
+}
+
+int audiodecoder_probe_memory(const void *data, long long size, audiodecoder_stream_info *info)
+{
+    if (!data || size <= 0 || !info) {
+        return AUDIODECODER_ERROR;
+    }
+    AudioDecoderMemorySource source(data, size);
+    AudioStreamInfo streamInfo;
+    if (AudioDecoderProbe::probe(&source, &streamInfo) != AUDIODECODER_OK) {
+        return AUDIODECODER_ERROR;
+    }
+    copyStreamInfo(streamInfo, info);
+    return AUDIODECODER_OK;
+}
+
+int audiodecoder_read(audiodecoder *decoder, float *buffer, int size)
+{
+    if (!decoder || !buffer || size <= 0) {
+        return 0;
+    }
+    return decoder->decoder->read(size, buffer);
+}
+
+int audiodecoder_seek(audiodecoder *decoder, int sample)
+{
+    if (!decoder) {
+        return AUDIODECODER_ERROR;
+    }
+    return decoder->decoder->seek(sample);
+}
+
+int audiodecoder_position(const audiodecoder *decoder)
+{
+    return decoder ? decoder->decoder->positionInSamples() : 0;
+}
+
+int audiodecoder_read_view(audiodecoder *decoder, audiodecoder_view *view)
+{
+    if (!decoder || !view) {
+        return 0;
+    }
+    AudioDecoderView v;
+    const int size = decoder->decoder->readView(&v);
+    view->data = v.data;
+    view->format = v.format == AudioDecoderView::FORMAT_INT16 ? AUDIODECODER_SAMPLE_INT16
+                                                              : AUDIODECODER_SAMPLE_FLOAT;
+    view->frames = v.frames;
+    view->channels = v.channels;
+    view->position = v.position;
+    return size;
+}
+
+const char *audiodecoder_supported_extensions(void)
+{
+    //Built once; a function-local static is initialized thread-safely.
+    static const std::string extensions = []() {
+        std::vector<std::string> list = AudioDecoder(std::string()).supportedFileExtensions();
+        std::string joined;
+        for (size_t i = 0; i < list.size(); i++) {
+            joined += (i ? ";" : "") + list[i];
+        }
+        return joined;
+    }();
+    return extensions.c_str();
+}
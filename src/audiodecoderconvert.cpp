@@ -0,0 +1,162 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+
+#include <stdint.h>
+#include "audiodecoderconvert.h"
+
+namespace {
+
+//One struct per sample format: the type a block is made of, and how to
+//get sample i out of it. The scales are constants, so they fold into the loop.
+struct U8
+{
+    typedef uint8_t Type;
+    static inline SAMPLE load(const Type *src, size_t i)
+    {
+        return (static_cast<int>(src[i]) - 128) * (1.0f / 128);
+    }
+};
+
+struct S16
+{
+    typedef int16_t Type;
+    static inline SAMPLE load(const Type *src, size_t i)
+    {
+        return src[i] * (1.0f / 32768);
+    }
+};
+
+struct S24
+{
+    typedef uint8_t Type;
+    static inline SAMPLE load(const Type *src, size_t i)
+    {
+        //Into the top three bytes of an int32, which sign-extends it for free.
+        const Type *s = src + i * 3;
+        const uint32_t v = (static_cast<uint32_t>(s[0]) << 8) |
+                           (static_cast<uint32_t>(s[1]) << 16) |
+                           (static_cast<uint32_t>(s[2]) << 24);
+        return static_cast<int32_t>(v) * (1.0f / 2147483648.0f);
+    }
+};
+
+struct S32
+{
+    typedef int32_t Type;
+    static inline SAMPLE load(const Type *src, size_t i)
+    {
+        return src[i] * (1.0f / 2147483648.0f);
+    }
+};
+
+struct F32
+{
+    typedef float Type;
+    static inline SAMPLE load(const Type *src, size_t i)
+    {
+        return src[i];
+    }
+};
+
+/** Channels is 1 or 2, so the inner loop unrolls away, or 0 for any count,
+    taken from the argument. */
+template <class Format, int Channels>
+void convert(const void *src, SAMPLE *dest, size_t frames, int channels)
+{
+    const typename Format::Type *in = static_cast<const typename Format::Type*>(src);
+    if (Channels == 0) {
+        const size_t count = frames * channels;
+        for (size_t i = 0; i < count; i++) {
+            dest[i] = Format::load(in, i);
+        }
+        return;
+    }
+    for (size_t f = 0; f < frames; f++) {
+        for (int c = 0; c < Channels; c++) {
+            dest[f * Channels + c] = Format::load(in, f * Channels + c);
+        }
+    }
+}
+
+template <class Format>
+AudioDecoderConvertFn selectChannels(int channels)
+{
+    switch (channels) {
+        case 1:  return &convert<Format, 1>;
+        case 2:  return &convert<Format, 2>;
+        default: return &convert<Format, 0>;
+    }
+}
+
+} // namespace
+
+AudioDecoderConvertFn AudioDecoderConvert::select(Format format, int channels)
+{
+    switch (format) {
+        case FORMAT_U8:  return selectChannels<U8>(channels);
+        case FORMAT_S24: return selectChannels<S24>(channels);
+        case FORMAT_S32: return selectChannels<S32>(channels);
+        case FORMAT_F32: return selectChannels<F32>(channels);
+        case FORMAT_S16:
+        default:         return selectChannels<S16>(channels);
+    }
+}
+
+bool AudioDecoderConvert::formatForBits(int bitsPerSample, Format *format)
+{
+    switch (bitsPerSample) {
+        case 8:  *format = FORMAT_U8;  return true;
+        case 16: *format = FORMAT_S16; return true;
+        case 24: *format = FORMAT_S24; return true;
+        case 32: *format = FORMAT_S32; return true;
+        default: return false;
+    }
+}
+
+int AudioDecoderConvert::bytesPerSample(Format format)
+{
+    switch (format) {
+        case FORMAT_U8:  return 1;
+        case FORMAT_S24: return 3;
+        case FORMAT_S32:
+        case FORMAT_F32: return 4;
+        case FORMAT_S16:
+        default:         return 2;
+    }
+}
@@ -37,42 +37,183 @@
  */
 
 #include <string>
-#include <iostream>
 #include "audiodecodercoreaudio.h"
+#include "audiodecoderallocator.h"
+#include "audiodecoderlog.h"
+#include "audiodecoderprobe.h"
+#include "audiodecodersource.h"
+#include "audiodecodertrace.h"
+
+const int kViewFrames = 4096; // a couple of AAC packets' worth
 
 
 AudioDecoderCoreAudio::AudioDecoderCoreAudio(const std::string filename) 
 : AudioDecoderBase(filename)
 , m_headerFrames(0)
+, m_audioFileID(NULL)
+, m_audioFile(NULL)
+, m_pViewBuffer(NULL)
+, m_viewBufferSize(0)
 {
     m_filename = filename;
 }
 
+AudioDecoderCoreAudio::AudioDecoderCoreAudio(AudioDecoderSource *source)
+: AudioDecoderBase(source)
+, m_headerFrames(0)
+, m_audioFileID(NULL)
+, m_audioFile(NULL)
+, m_pViewBuffer(NULL)
+, m_viewBufferSize(0)
+{
+}
+
 AudioDecoderCoreAudio::~AudioDecoderCoreAudio() 
 {
-    ExtAudioFileDispose(m_audioFile);
+    if (m_pViewBuffer) {
+        allocator()->deallocate(m_pViewBuffer, m_viewBufferSize * sizeof(SAMPLE));
+    }
+    close();
+}
+
+void AudioDecoderCoreAudio::close()
+{
+    if (m_audioFile) {
+        ExtAudioFileDispose(m_audioFile);
+        m_audioFile = NULL;
+    }
+    if (m_audioFileID) {
+        AudioFileClose(m_audioFileID);
+        m_audioFileID = NULL;
+    }
+}
+
+/** The view buffer is kept (we always decode to stereo, so it fits any file);
+    the ExtAudioFile and its converter are per file. */
+int AudioDecoderCoreAudio::reset(const std::string filename)
+{
+    close();
+    setInput(filename, NULL);
+    m_headerFrames = 0;
+    return open();
+}
+
+int AudioDecoderCoreAudio::reset(AudioDecoderSource *source)
+{
+    close();
+    setInput(std::string(), source);
+    m_headerFrames = 0;
+    return open();
+}
+
+int AudioDecoderCoreAudio::readView(AudioDecoderView *view) {
+    AudioDecoderMetrics::Timer timer(m_metrics.readLatency);
+    AUDIODECODER_TRACE_SCOPE("decoder", "readView");
+    view->data = m_pViewBuffer;
+    view->format = AudioDecoderView::FORMAT_FLOAT;
+    view->frames = 0;
+    view->channels = m_iChannels;
+    view->position = m_iPositionInSamples;
+    if (!m_pViewBuffer) {
+        return 0;
+    }
+
+    //One ExtAudioFileRead() call: the converter decodes straight into the
+    //view buffer, and the caller reads it from there.
+    AudioBufferList fillBufList;
+    fillBufList.mNumberBuffers = 1;
+    fillBufList.mBuffers[0].mNumberChannels = m_clientFormat.NumberChannels();
+    fillBufList.mBuffers[0].mDataByteSize = kViewFrames * m_iChannels * sizeof(SAMPLE);
+    fillBufList.mBuffers[0].mData = m_pViewBuffer;
+    UInt32 numFrames = kViewFrames;
+    OSStatus err;
+    {
+        AUDIODECODER_TRACE_SCOPE("codec", "ExtAudioFileRead");
+        err = ExtAudioFileRead(m_audioFile, &numFrames, &fillBufList);
+    }
+    if (err != noErr) {
+        numFrames = 0;
+    }
+
+    view->frames = numFrames;
+    m_iPositionInSamples += view->size();
+    m_metrics.framesDecoded += numFrames;
+    notifySinks(view->floats(), view->size());
+    return view->size();
+}
+
+// static
+OSStatus AudioDecoderCoreAudio::sourceRead(void *inClientData, SInt64 inPosition,
+                                           UInt32 requestCount, void *buffer,
+                                           UInt32 *actualCount)
+{
+    AUDIODECODER_TRACE_SCOPE_ARG("io", "sourceRead", "bytes", requestCount);
+    AudioDecoderCoreAudio *decoder = static_cast<AudioDecoderCoreAudio*>(inClientData);
+    long long bytesRead = decoder->m_pSource->pread(buffer, requestCount, inPosition);
+    if (bytesRead < 0) {
+        *actualCount = 0;
+        return kAudioFileUnspecifiedError;
+    }
+    decoder->m_metrics.bytesRead += bytesRead;
+    *actualCount = static_cast<UInt32>(bytesRead);
+    return noErr;
+}
+
+// static
+SInt64 AudioDecoderCoreAudio::sourceGetSize(void *inClientData)
+{
+    return static_cast<AudioDecoderCoreAudio*>(inClientData)->m_pSource->size();
+}
+
+/** Opens m_pSource through AudioFile callbacks and wraps it in an ExtAudioFile,
+    so the bytes come straight from the source with no temp file. */
+OSStatus AudioDecoderCoreAudio::openSource() {
+    //AudioFile sniffs the data, but a hint saves it some guessing.
+    AudioFileTypeID typeHint = 0;
+    switch (AudioDecoderProbe::sniff(m_pSource)) {
+        case AudioStreamInfo::FORMAT_WAV:  typeHint = kAudioFileWAVEType; break;
+        case AudioStreamInfo::FORMAT_AIFF: typeHint = kAudioFileAIFFType; break;
+        case AudioStreamInfo::FORMAT_MP3:  typeHint = kAudioFileMP3Type; break;
+        case AudioStreamInfo::FORMAT_MP4:  typeHint = kAudioFileM4AType; break;
+        default: break;
+    }
+
+    OSStatus err = AudioFileOpenWithCallbacks(this, &AudioDecoderCoreAudio::sourceRead, NULL,
+                                              &AudioDecoderCoreAudio::sourceGetSize, NULL,
+                                              typeHint, &m_audioFileID);
+    if (err != noErr) {
+        m_audioFileID = NULL;
+        return err;
+    }
+    return ExtAudioFileWrapAudioFileID(m_audioFileID, false, &m_audioFile);
 }
 
 int AudioDecoderCoreAudio::open() {
+    AudioDecoderMetrics::Timer timer(m_metrics.openLatency);
+    AUDIODECODER_TRACE_SCOPE("decoder", "open");
     
     //Open the audio file.
     OSStatus err;
 
-    /** This code blocks works with OS X 10.5+ only. DO NOT DELETE IT for now. */
-    /*CFStringRef urlStr = CFStringCreateWithCharacters(0,
-      reinterpret_cast<const UniChar *>(
-      //qurlStr.unicode()), qurlStr.size());
-      m_filename.data()), m_filename.size());
-    */
-    CFStringRef urlStr = CFStringCreateWithCString(kCFAllocatorDefault, 
-                                                   m_filename.c_str(), 
-                                                   kCFStringEncodingUTF8);
-                                                   //CFStringGetSystemEncoding());
-
-    CFURLRef urlRef = CFURLCreateWithFileSystemPath(NULL, urlStr, kCFURLPOSIXPathStyle, false);
-    err = ExtAudioFileOpenURL(urlRef, &m_audioFile);
-    CFRelease(urlStr);
-    CFRelease(urlRef);
+    if (m_pSource) {
+        err = openSource();
+    } else {
+        /** This code blocks works with OS X 10.5+ only. DO NOT DELETE IT for now. */
+        /*CFStringRef urlStr = CFStringCreateWithCharacters(0,
+          reinterpret_cast<const UniChar *>(
+          //qurlStr.unicode()), qurlStr.size());
+          m_filename.data()), m_filename.size());
+        */
+        CFStringRef urlStr = CFStringCreateWithCString(kCFAllocatorDefault, 
+                                                       m_filename.c_str(), 
+                                                       kCFStringEncodingUTF8);
+                                                       //CFStringGetSystemEncoding());
+
+        CFURLRef urlRef = CFURLCreateWithFileSystemPath(NULL, urlStr, kCFURLPOSIXPathStyle, false);
+        err = ExtAudioFileOpenURL(urlRef, &m_audioFile);
+        CFRelease(urlStr);
+        CFRelease(urlRef);
+    }
 
     /** TODO: Use FSRef for compatibility with 10.4 Tiger. 
         Note that ExtAudioFileOpen() is deprecated above Tiger, so we must maintain
@@ -84,7 +225,7 @@ int AudioDecoderCoreAudio::open() {
 
     if (err != noErr)
     {
-        std::cerr << "AudioDecoderCoreAudio: Error opening file." << std::endl;
+        AUDIODECODER_LOG(ERROR, "AudioDecoderCoreAudio: Error opening file.");
         return AUDIODECODER_ERROR;
     }
 
@@ -94,7 +235,7 @@ int AudioDecoderCoreAudio::open() {
     err = ExtAudioFileGetProperty(m_audioFile, kExtAudioFileProperty_FileDataFormat, &size, &inputFormat);
     if (err != noErr)
     {
-        std::cerr << "AudioDecoderCoreAudio: Error getting file format." << std::endl;
+        AUDIODECODER_LOG(ERROR, "AudioDecoderCoreAudio: Error getting file format.");
         return AUDIODECODER_ERROR;
     }    
     m_inputFormat = inputFormat;
@@ -144,11 +285,15 @@ int AudioDecoderCoreAudio::open() {
     m_clientFormat = clientFormat;
     size = sizeof(clientFormat);
     
-    err = ExtAudioFileSetProperty(m_audioFile, kExtAudioFileProperty_ClientDataFormat, size, &clientFormat);
+    {
+        //Creates the converter, so this is where the codec gets set up.
+        AUDIODECODER_TRACE_SCOPE("decoder", "configureAudioStream");
+        err = ExtAudioFileSetProperty(m_audioFile, kExtAudioFileProperty_ClientDataFormat, size, &clientFormat);
+    }
     if (err != noErr)
     {
             //qDebug() << "SSCA: Error setting file property";
-    std::cerr << "AudioDecoderCoreAudio: Error setting file property." << std::endl;
+        AUDIODECODER_LOG(ERROR, "AudioDecoderCoreAudio: Error setting file property.");
             return AUDIODECODER_ERROR;
     }
     
@@ -162,7 +307,7 @@ int AudioDecoderCoreAudio::open() {
     err	= ExtAudioFileGetProperty(m_audioFile, kExtAudioFileProperty_FileLengthFrames, &dataSize, &totalFrameCount);
     if (err != noErr)
     {
-        std::cerr << "AudioDecoderCoreAudio: Error getting number of frames." << std::endl;
+        AUDIODECODER_LOG(ERROR, "AudioDecoderCoreAudio: Error getting number of frames.");
         return AUDIODECODER_ERROR;
     }
 
@@ -202,10 +347,27 @@ int AudioDecoderCoreAudio::open() {
     //get the number of samples it expects (ie. no header frames).
     seek(0);
 
+    //ExtAudioFile decodes into whatever buffer it's given, so readView()
+    //needs one of its own. Get it now so reading doesn't allocate, and
+    //again only if reset() brings a file with more channels.
+    const size_t viewSize = kViewFrames * m_iChannels;
+    if (m_viewBufferSize < viewSize) {
+        if (m_pViewBuffer) {
+            allocator()->deallocate(m_pViewBuffer, m_viewBufferSize * sizeof(SAMPLE));
+        }
+        m_pViewBuffer = static_cast<SAMPLE*>(allocator()->allocate(viewSize * sizeof(SAMPLE)));
+        m_viewBufferSize = m_pViewBuffer ? viewSize : 0;
+        m_metrics.bufferBytesHeld = m_viewBufferSize * sizeof(SAMPLE);
+    }
+    beginSinks();
+
     return AUDIODECODER_OK;
 }
 
 int AudioDecoderCoreAudio::seek(int sampleIdx) {
+    AudioDecoderMetrics::Timer timer(m_metrics.seekLatency);
+    AUDIODECODER_TRACE_SCOPE("decoder", "seek");
+    m_metrics.seeks++;
     OSStatus err = noErr;
     SInt64 segmentStart = sampleIdx / 2;
 
@@ -216,15 +378,18 @@ int AudioDecoderCoreAudio::seek(int sampleIdx) {
     //err = ExtAudioFileSeek(m_audioFile, sampleIdx / 2);		
     if (err != noErr)
     {
-        std::cerr << "AudioDecoderCoreAudio: Error seeking to sample " << sampleIdx << std::endl;
+        AUDIODECODER_LOG(WARNING, "AudioDecoderCoreAudio: Error seeking to sample %d", sampleIdx);
     }
 
     m_iPositionInSamples = sampleIdx;
+    seekSinks(sampleIdx);
 
     return m_iPositionInSamples; //filepos;
 }
 
 int AudioDecoderCoreAudio::read(int size, const SAMPLE *destination) {
+    AudioDecoderMetrics::Timer timer(m_metrics.readLatency);
+    AUDIODECODER_TRACE_SCOPE("decoder", "read");
     OSStatus err;
     SAMPLE *destBuffer(const_cast<SAMPLE*>(destination));
     unsigned int samplesWritten = 0;
@@ -247,14 +412,17 @@ int AudioDecoderCoreAudio::read(int size, const SAMPLE *destination) {
         // client format is always linear PCM - so here we determine how many frames of lpcm
         // we can read/write given our buffer size
         numFrames = numFramesToRead; //This silly variable acts as both a parameter and return value.
-        err = ExtAudioFileRead (m_audioFile, &numFrames, &fillBufList);
+        {
+            AUDIODECODER_TRACE_SCOPE("codec", "ExtAudioFileRead");
+            err = ExtAudioFileRead (m_audioFile, &numFrames, &fillBufList);
+        }
         //The actual number of frames read also comes back in numFrames.
         //(It's both a parameter to a function and a return value. wat apple?)
         //XThrowIfError (err, "ExtAudioFileRead");	
         /*
         if (err != noErr)
         {
-            std::cerr << "Error reading samples from file" << std::endl;
+            AUDIODECODER_LOG(ERROR, "Error reading samples from file");
             return 0;
         }*/
 
@@ -266,6 +434,8 @@ int AudioDecoderCoreAudio::read(int size, const SAMPLE *destination) {
     }
     
     m_iPositionInSamples += numFramesRead*m_iChannels;
+    m_metrics.framesDecoded += numFramesRead;
+    notifySinks(destination, numFramesRead*m_iChannels);
 
     return numFramesRead*m_iChannels;
 }
@@ -0,0 +1,348 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+
+#include <string.h>
+#include <algorithm>
+#include "audiodecoder.h"
+#include "audiodecodercuecache.h"
+#include "audiodecoderrandomaccess.h"
+
+AudioDecoderCueCache::AudioDecoderCueCache(AudioDecoderRandomAccess *file, int cueMilliseconds)
+: m_pFile(file)
+, m_iCueMilliseconds(cueMilliseconds > 0 ? cueMilliseconds : 0)
+, m_pDecoder(NULL)
+, m_iNextId(0)
+, m_iActiveLoop(-1)
+, m_iPosition(0)
+, m_iDecoderPosition(0)
+, m_iDecoderTarget(-1)
+, m_decoderBusy(false)
+, m_iHits(0)
+, m_iMisses(0)
+, m_quit(false)
+{
+}
+
+AudioDecoderCueCache::~AudioDecoderCueCache()
+{
+    if (m_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_quit = true;
+        }
+        m_wake.notify_one();
+        m_thread.join();
+    }
+    delete m_pDecoder;
+    for (size_t i = 0; i < m_regions.size(); i++) {
+        delete m_regions[i];
+    }
+}
+
+int AudioDecoderCueCache::open()
+{
+    if (m_pDecoder) {
+        return AUDIODECODER_OK;
+    }
+    m_pDecoder = m_pFile->clone();
+    if (!m_pDecoder) {
+        return AUDIODECODER_ERROR;
+    }
+    m_thread = std::thread(&AudioDecoderCueCache::run, this);
+    return AUDIODECODER_OK;
+}
+
+int AudioDecoderCueCache::addCue(int sampleIdx)
+{
+    const int channels = m_pFile->channels();
+    if (channels <= 0 || sampleIdx < 0) {
+        return AUDIODECODER_ERROR;
+    }
+    sampleIdx -= sampleIdx % channels;
+    const long long length = static_cast<long long>(m_iCueMilliseconds) * m_pFile->sampleRate() / 1000 * channels;
+    return addRegion(sampleIdx, static_cast<int>(std::min<long long>(sampleIdx + length, m_pFile->numSamples())), false);
+}
+
+int AudioDecoderCueCache::addLoop(int startSample, int endSample)
+{
+    const int channels = m_pFile->channels();
+    if (channels <= 0 || startSample < 0) {
+        return AUDIODECODER_ERROR;
+    }
+    startSample -= startSample % channels;
+    endSample -= endSample % channels;
+    return addRegion(startSample, std::min(endSample, m_pFile->numSamples()), true);
+}
+
+int AudioDecoderCueCache::addRegion(int start, int end, bool loop)
+{
+    if (end <= start) {
+        return AUDIODECODER_ERROR;
+    }
+    Region *region = new Region;
+    region->start = start;
+    region->end = end;
+    region->loop = loop;
+    region->ready = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        region->id = m_iNextId++;
+        m_regions.push_back(region);
+    }
+    m_wake.notify_one();
+    return region->id;
+}
+
+void AudioDecoderCueCache::remove(int id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t i = 0; i < m_regions.size(); i++) {
+        if (m_regions[i]->id == id) {
+            delete m_regions[i];
+            m_regions.erase(m_regions.begin() + i);
+            break;
+        }
+    }
+    if (m_iActiveLoop == id) {
+        m_iActiveLoop = -1;
+    }
+}
+
+int AudioDecoderCueCache::setActiveLoop(int id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (id >= 0) {
+        const Region *region = findRegion(id);
+        if (!region || !region->loop) {
+            return AUDIODECODER_ERROR;
+        }
+    }
+    m_iActiveLoop = id < 0 ? -1 : id;
+    return AUDIODECODER_OK;
+}
+
+bool AudioDecoderCueCache::isReady(int id) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const Region *region = findRegion(id);
+    return region && region->ready;
+}
+
+int AudioDecoderCueCache::seek(int sampleIdx)
+{
+    const int channels = m_pFile->channels();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (sampleIdx < 0 || channels <= 0) {
+        sampleIdx = 0;
+    } else {
+        sampleIdx -= sampleIdx % channels;
+    }
+    m_iPosition = sampleIdx;
+    const Region *region = readyRegionAt(sampleIdx);
+    if (region) {
+        //Play from memory while the decoder gets to where the region ends.
+        m_iHits++;
+        moveDecoderTo(region->end);
+    } else {
+        //Still start the seek now, so it's further along by the next read().
+        m_iMisses++;
+        moveDecoderTo(sampleIdx);
+    }
+    return m_iPosition;
+}
+
+int AudioDecoderCueCache::read(int size, const SAMPLE *buffer)
+{
+    SAMPLE *dest = const_cast<SAMPLE*>(buffer);
+    const int channels = m_pFile->channels();
+    if (!m_pDecoder || channels <= 0 || size <= 0) {
+        return 0;
+    }
+    size -= size % channels;
+
+    int done = 0;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (done < size) {
+        int want = size - done;
+        const Region *loop = m_iActiveLoop >= 0 ? findRegion(m_iActiveLoop) : NULL;
+        if (loop && m_iPosition >= loop->start && m_iPosition <= loop->end) {
+            if (m_iPosition == loop->end) {
+                m_iPosition = loop->start;
+            }
+            want = std::min(want, loop->end - m_iPosition);
+        }
+
+        const Region *region = readyRegionAt(m_iPosition);
+        if (region) {
+            const int n = std::min(want, region->end - m_iPosition);
+            memcpy(dest + done, &region->samples[m_iPosition - region->start], n * sizeof(SAMPLE));
+            m_iPosition += n;
+            done += n;
+            moveDecoderTo(region->end);
+            continue;
+        }
+
+        //Outside the regions it's the decoder's job. Wait for the thread if
+        //it's moving it, which with any luck is to right here.
+        m_iDecoderTarget = -1;
+        while (m_decoderBusy) {
+            m_decoderFree.wait(lock);
+        }
+        m_decoderBusy = true;
+        const int position = m_iPosition;
+        const bool seekNeeded = m_iDecoderPosition != position;
+        lock.unlock();
+        if (seekNeeded) {
+            m_pDecoder->seek(position);
+        }
+        const int n = m_pDecoder->read(want, dest + done);
+        lock.lock();
+        m_decoderBusy = false;
+        m_iDecoderPosition = m_pDecoder->positionInSamples();
+        m_decoderFree.notify_all();
+        if (n <= 0) {
+            break;
+        }
+        m_iPosition += n;
+        done += n;
+    }
+    return done;
+}
+
+int AudioDecoderCueCache::positionInSamples() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_iPosition;
+}
+
+int AudioDecoderCueCache::cacheHits() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_iHits;
+}
+
+int AudioDecoderCueCache::cacheMisses() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_iMisses;
+}
+
+/** Call with m_mutex held. */
+AudioDecoderCueCache::Region *AudioDecoderCueCache::findRegion(int id) const
+{
+    for (size_t i = 0; i < m_regions.size(); i++) {
+        if (m_regions[i]->id == id) {
+            return m_regions[i];
+        }
+    }
+    return NULL;
+}
+
+/** Call with m_mutex held. */
+const AudioDecoderCueCache::Region *AudioDecoderCueCache::readyRegionAt(int sampleIdx) const
+{
+    for (size_t i = 0; i < m_regions.size(); i++) {
+        const Region *region = m_regions[i];
+        if (region->ready && sampleIdx >= region->start && sampleIdx < region->end) {
+            return region;
+        }
+    }
+    return NULL;
+}
+
+/** Asks the thread to seek the decoder to sampleIdx. Call with m_mutex held. */
+void AudioDecoderCueCache::moveDecoderTo(int sampleIdx)
+{
+    if (sampleIdx == m_iDecoderPosition && !m_decoderBusy) {
+        m_iDecoderTarget = -1;
+        return;
+    }
+    if (sampleIdx != m_iDecoderTarget) {
+        m_iDecoderTarget = sampleIdx;
+        m_wake.notify_one();
+    }
+}
+
+/** The background thread: moves the decoder when asked, and otherwise
+    decodes any region that isn't yet. */
+void AudioDecoderCueCache::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_quit) {
+        if (m_iDecoderTarget >= 0 && !m_decoderBusy) {
+            const int target = m_iDecoderTarget;
+            m_iDecoderTarget = -1;
+            if (target != m_iDecoderPosition) {
+                m_decoderBusy = true;
+                lock.unlock();
+                m_pDecoder->seek(target);
+                lock.lock();
+                m_decoderBusy = false;
+                m_iDecoderPosition = m_pDecoder->positionInSamples();
+                m_decoderFree.notify_all();
+            }
+            continue;
+        }
+
+        const Region *pending = NULL;
+        for (size_t i = 0; i < m_regions.size() && !pending; i++) {
+            if (!m_regions[i]->ready) {
+                pending = m_regions[i];
+            }
+        }
+        if (pending) {
+            //Decode outside the lock; the region may be gone by the time it's done.
+            const int id = pending->id;
+            const int start = pending->start;
+            std::vector<SAMPLE> samples(pending->end - start);
+            lock.unlock();
+            const int n = m_pFile->readAt(start, static_cast<int>(samples.size()), &samples[0]);
+            lock.lock();
+            Region *region = findRegion(id);
+            if (region) {
+                samples.resize(n > 0 ? n : 0);
+                region->samples.swap(samples);
+                region->end = region->start + static_cast<int>(region->samples.size());
+                region->ready = true;
+            }
+            continue;
+        }
+        m_wake.wait(lock);
+    }
+}
@@ -0,0 +1,263 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+
+#include <string.h>
+#include <algorithm>
+#include "audiodecoder.h"
+#include "audiodecoderfanout.h"
+
+AudioDecoderFanOutCursor::AudioDecoderFanOutCursor(AudioDecoderFanOut *fanOut, int position)
+: m_pFanOut(fanOut)
+, m_iPosition(position)
+, m_detached(false)
+{
+}
+
+AudioDecoderFanOutCursor::~AudioDecoderFanOutCursor()
+{
+    m_pFanOut->removeCursor(this);
+}
+
+int AudioDecoderFanOutCursor::read(int size, const SAMPLE *buffer)
+{
+    return m_pFanOut->read(this, size, const_cast<SAMPLE*>(buffer));
+}
+
+int AudioDecoderFanOutCursor::seek(int sampleIdx)
+{
+    return m_pFanOut->seek(this, sampleIdx);
+}
+
+bool AudioDecoderFanOutCursor::isDetached() const
+{
+    std::lock_guard<std::mutex> lock(m_pFanOut->m_mutex);
+    return m_detached;
+}
+
+int AudioDecoderFanOutCursor::positionInSamples() const
+{
+    std::lock_guard<std::mutex> lock(m_pFanOut->m_mutex);
+    return m_iPosition;
+}
+
+int AudioDecoderFanOutCursor::numSamples() const
+{
+    return m_pFanOut->m_pDecoder->numSamples();
+}
+
+int AudioDecoderFanOutCursor::channels() const
+{
+    return m_pFanOut->m_pDecoder->channels();
+}
+
+int AudioDecoderFanOutCursor::sampleRate() const
+{
+    return m_pFanOut->m_pDecoder->sampleRate();
+}
+
+float AudioDecoderFanOutCursor::duration() const
+{
+    return m_pFanOut->m_pDecoder->duration();
+}
+
+AudioDecoderFanOut::AudioDecoderFanOut(AudioDecoder *decoder, int numBlocks, int blockFrames,
+                                       Backpressure backpressure)
+: m_pDecoder(decoder)
+, m_iNumBlocks(numBlocks > 0 ? numBlocks : 1)
+, m_iBlockSamples((blockFrames > 0 ? blockFrames : 1) * (decoder->channels() > 0 ? decoder->channels() : 1))
+, m_backpressure(backpressure)
+, m_iFirstBlock(0)
+, m_iNumFilled(0)
+, m_iWindowStart(decoder->positionInSamples())
+, m_iWindowEnd(decoder->positionInSamples())
+, m_eof(false)
+, m_decoding(false)
+{
+    m_samples.resize(static_cast<size_t>(m_iNumBlocks) * m_iBlockSamples);
+}
+
+AudioDecoderFanOut::~AudioDecoderFanOut()
+{
+}
+
+AudioDecoderFanOutCursor *AudioDecoderFanOut::createCursor()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    AudioDecoderFanOutCursor *cursor = new AudioDecoderFanOutCursor(this, m_iWindowStart);
+    m_cursors.push_back(cursor);
+    return cursor;
+}
+
+void AudioDecoderFanOut::setBackpressure(Backpressure backpressure)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_backpressure = backpressure;
+    m_changed.notify_all();
+}
+
+void AudioDecoderFanOut::bufferedRange(int *firstSample, int *endSample) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    *firstSample = m_iWindowStart;
+    *endSample = m_iWindowEnd;
+}
+
+void AudioDecoderFanOut::removeCursor(AudioDecoderFanOutCursor *cursor)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cursors.erase(std::remove(m_cursors.begin(), m_cursors.end(), cursor), m_cursors.end());
+    m_changed.notify_all(); // it may have been the one holding everybody up
+}
+
+int AudioDecoderFanOut::read(AudioDecoderFanOutCursor *cursor, int size, SAMPLE *buffer)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    int samplesRead = 0;
+    while (samplesRead < size && !cursor->m_detached) {
+        const int position = cursor->m_iPosition;
+        if (position < m_iWindowEnd) {
+            //Buffered: copy as much of this block as we can.
+            const int offset = position - m_iWindowStart;
+            const int block = (m_iFirstBlock + offset / m_iBlockSamples) % m_iNumBlocks;
+            const int inBlock = offset % m_iBlockSamples;
+            int count = std::min(m_iBlockSamples - inBlock, m_iWindowEnd - position);
+            count = std::min(count, size - samplesRead);
+            memcpy(buffer + samplesRead,
+                   &m_samples[static_cast<size_t>(block) * m_iBlockSamples + inBlock],
+                   count * sizeof(SAMPLE));
+            samplesRead += count;
+            cursor->m_iPosition += count;
+            if ((cursor->m_iPosition - m_iWindowStart) % m_iBlockSamples == 0) {
+                m_changed.notify_all(); // passed a block, which may free it up
+            }
+        } else if (m_eof) {
+            break;
+        } else if (m_decoding) {
+            //Someone else is decoding the block we want.
+            m_changed.wait(lock);
+        } else if (makeRoom(lock)) {
+            decodeBlock(lock);
+        }
+    }
+    return samplesRead;
+}
+
+/** Makes sure there's a free block at the end of the ring, by recycling the
+    oldest one if every cursor is past it. Returns false if it had to wait, in
+    which case everything may have changed and the caller should look again. */
+bool AudioDecoderFanOut::makeRoom(std::unique_lock<std::mutex>& lock)
+{
+    if (m_iNumFilled < m_iNumBlocks) {
+        return true;
+    }
+    const int oldestEnd = m_iWindowStart + m_iBlockSamples;
+    bool pinned = false;
+    for (size_t i = 0; i < m_cursors.size(); i++) {
+        AudioDecoderFanOutCursor *cursor = m_cursors[i];
+        if (!cursor->m_detached && cursor->m_iPosition < oldestEnd) {
+            if (m_backpressure == BACKPRESSURE_DETACH) {
+                cursor->m_detached = true;
+            } else {
+                pinned = true;
+            }
+        }
+    }
+    if (pinned) {
+        m_changed.wait(lock);
+        return false;
+    }
+    m_iFirstBlock = (m_iFirstBlock + 1) % m_iNumBlocks;
+    m_iNumFilled--;
+    m_iWindowStart = oldestEnd;
+    return true;
+}
+
+/** Decodes the next block into the free slot at the end of the ring. The lock
+    is let go meanwhile, so the other cursors can go on reading what's buffered. */
+void AudioDecoderFanOut::decodeBlock(std::unique_lock<std::mutex>& lock)
+{
+    const int block = (m_iFirstBlock + m_iNumFilled) % m_iNumBlocks;
+    SAMPLE *destination = &m_samples[static_cast<size_t>(block) * m_iBlockSamples];
+    m_decoding = true;
+    lock.unlock();
+    int samplesDecoded = m_pDecoder->read(m_iBlockSamples, destination);
+    lock.lock();
+    m_decoding = false;
+    if (samplesDecoded > 0) {
+        m_iNumFilled++;
+        m_iWindowEnd += samplesDecoded;
+    }
+    if (samplesDecoded < m_iBlockSamples) {
+        m_eof = true;
+    }
+    m_changed.notify_all();
+}
+
+int AudioDecoderFanOut::seek(AudioDecoderFanOutCursor *cursor, int sampleIdx)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const int channels = m_pDecoder->channels() > 0 ? m_pDecoder->channels() : 1;
+    sampleIdx -= sampleIdx % channels;
+    cursor->m_detached = false;
+    if (sampleIdx >= m_iWindowStart && sampleIdx <= m_iWindowEnd) {
+        //Still buffered (or next up): the other cursors don't notice a thing.
+        cursor->m_iPosition = sampleIdx;
+        m_changed.notify_all();
+        return sampleIdx;
+    }
+
+    //Start the ring over from the new position.
+    while (m_decoding) {
+        m_changed.wait(lock);
+    }
+    const int position = m_pDecoder->seek(sampleIdx);
+    m_iFirstBlock = 0;
+    m_iNumFilled = 0;
+    m_iWindowStart = position;
+    m_iWindowEnd = position;
+    m_eof = false;
+    cursor->m_iPosition = position;
+    for (size_t i = 0; i < m_cursors.size(); i++) {
+        if (m_cursors[i]->m_iPosition != position) {
+            m_cursors[i]->m_detached = true;
+        }
+    }
+    m_changed.notify_all();
+    return position;
+}
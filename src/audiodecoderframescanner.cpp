@@ -0,0 +1,361 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+
+#include <string.h>
+#include <algorithm>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FRAMESCANNER_USE_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define FRAMESCANNER_USE_NEON
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include "audiodecoderframescanner.h"
+#include "audiodecodersource.h"
+
+namespace {
+
+const long long kChunkSize = 1024 * 1024;
+const long long kBacktrack = 64 * 1024; // kept behind when a chain check needs a new chunk
+
+inline int lowestBit(unsigned int bits)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, bits);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(bits);
+#endif
+}
+
+/** The bytes of a source between begin and end: straight from its mapping
+    if it has one, otherwise through a buffer that's loaded a chunk at a time. */
+class Window
+{
+    public:
+        Window(AudioDecoderSource *source, long long begin, long long end)
+        : m_pSource(source)
+        , m_pMapped(static_cast<const unsigned char*>(source->mapView()))
+        , m_begin(begin)
+        , m_end(end)
+        , m_chunkStart(0)
+        , m_chunkEnd(0)
+        {
+        }
+
+        /** len bytes at offset, or NULL if they aren't all there. Invalidates
+            earlier pointers if it has to load. */
+        const unsigned char *at(long long offset, size_t len)
+        {
+            return get(offset, len, offset);
+        }
+
+        /** The same for looking ahead of the scan, so the chunk is loaded a
+            little before offset and the scan's own position stays in it. */
+        const unsigned char *ahead(long long offset, size_t len)
+        {
+            return get(offset, len, std::max(m_begin, offset - kBacktrack));
+        }
+
+        /** Everything contiguous from offset, at least one byte. */
+        const unsigned char *span(long long offset, size_t *available)
+        {
+            const unsigned char *p = at(offset, 1);
+            if (p) {
+                *available = static_cast<size_t>((m_pMapped ? m_end : m_chunkEnd) - offset);
+            }
+            return p;
+        }
+
+    private:
+        const unsigned char *get(long long offset, size_t len, long long loadFrom)
+        {
+            if (offset < m_begin || offset + static_cast<long long>(len) > m_end) {
+                return NULL;
+            }
+            if (m_pMapped) {
+                return m_pMapped + offset;
+            }
+            if (offset < m_chunkStart || offset + static_cast<long long>(len) > m_chunkEnd) {
+                const long long size = std::min(kChunkSize, m_end - loadFrom);
+                m_chunk.resize(static_cast<size_t>(kChunkSize));
+                if (m_pSource->pread(&m_chunk[0], size, loadFrom) != size) {
+                    m_chunkStart = m_chunkEnd = 0;
+                    return NULL;
+                }
+                m_chunkStart = loadFrom;
+                m_chunkEnd = loadFrom + size;
+            }
+            return &m_chunk[static_cast<size_t>(offset - m_chunkStart)];
+        }
+
+        AudioDecoderSource *m_pSource;
+        const unsigned char *m_pMapped;
+        long long m_begin;
+        long long m_end;
+        std::vector<unsigned char> m_chunk;
+        long long m_chunkStart;
+        long long m_chunkEnd;
+};
+
+typedef bool (*ParseFn)(const unsigned char *h, AudioDecoderFrameHeader *header);
+
+inline bool sameStream(const AudioDecoderFrameHeader& a, const AudioDecoderFrameHeader& b)
+{
+    return a.sampleRate == b.sampleRate && a.version == b.version && a.layer == b.layer;
+}
+
+/** True if kChainFrames frames in a row start at pos (or the stream ends cleanly first). */
+bool followsOn(Window& window, long long pos, const AudioDecoderFrameHeader& header,
+               long long end, size_t headerBytes, ParseFn parse)
+{
+    long long next = pos + header.frameLength;
+    for (int n = 1; n < AudioDecoderFrameScanner::kChainFrames; n++) {
+        if (next == end) {
+            return true;
+        }
+        const unsigned char *h = window.ahead(next, headerBytes);
+        AudioDecoderFrameHeader following;
+        if (!h || !parse(h, &following) || !sameStream(following, header)) {
+            return false;
+        }
+        next += following.frameLength;
+    }
+    return next <= end;
+}
+
+void addFrame(AudioDecoderFrameIndex *index, long long pos, const AudioDecoderFrameHeader& header,
+              bool keepOffsets)
+{
+    if (index->frames == 0) {
+        index->first = header;
+    }
+    index->frames++;
+    index->samples += header.samplesPerFrame;
+    index->bytes += header.frameLength;
+    index->constantBitrate = index->constantBitrate && header.bitrate == index->first.bitrate;
+    if (keepOffsets) {
+        index->offsets.push_back(pos);
+    }
+}
+
+} // namespace
+
+int AudioDecoderFrameScanner::scan(AudioDecoderSource *source, long long start, long long end, Format format,
+                                   AudioDecoderFrameIndex *index, bool keepOffsets)
+{
+    index->offsets.clear();
+    index->frames = 0;
+    index->samples = 0;
+    index->bytes = 0;
+    memset(&index->first, 0, sizeof(index->first));
+    index->constantBitrate = true;
+    if (!source || start < 0) {
+        return AUDIODECODER_ERROR;
+    }
+    end = std::min(end, source->size());
+
+    const ParseFn parse = format == FORMAT_ADTS ? &parseAdtsHeader : &parseMpegHeader;
+    const size_t headerBytes = format == FORMAT_ADTS ? 7 : 4;
+    Window window(source, start, end);
+    AudioDecoderFrameHeader reference = AudioDecoderFrameHeader();
+    bool locked = false;
+    long long pos = start;
+    while (pos + static_cast<long long>(headerBytes) <= end) {
+        AudioDecoderFrameHeader header;
+        if (locked) {
+            //In sync: straight from one header to the next.
+            const unsigned char *h = window.at(pos, headerBytes);
+            if (h && parse(h, &header) && sameStream(header, reference) &&
+                pos + header.frameLength <= end) {
+                addFrame(index, pos, header, keepOffsets);
+                pos += header.frameLength;
+                continue;
+            }
+            locked = false; // a tag, junk or damage; search from the next byte
+            pos++;
+            continue;
+        }
+
+        size_t available = 0;
+        const unsigned char *p = window.span(pos, &available);
+        if (!p) {
+            break;
+        }
+        const size_t i = findSync(p, available, format);
+        if (i == available) {
+            //Nothing here, but the last byte could begin a sync word.
+            pos += available > 1 ? available - 1 : 1;
+            continue;
+        }
+        pos += i;
+        const unsigned char *h = window.at(pos, headerBytes);
+        if (!h) {
+            break;
+        }
+        if (parse(h, &header) && followsOn(window, pos, header, end, headerBytes, parse)) {
+            locked = true;
+            reference = header;
+            addFrame(index, pos, header, keepOffsets);
+            pos += header.frameLength;
+        } else {
+            pos++;
+        }
+    }
+    return index->frames > 0 ? AUDIODECODER_OK : AUDIODECODER_ERROR;
+}
+
+size_t AudioDecoderFrameScanner::findSync(const unsigned char *data, size_t size, Format format)
+{
+    //0xFF, then a byte with the rest of the sync bits set: 11 in all for
+    //MPEG (with 2.5's extension), 12 for ADTS.
+    const unsigned char mask = format == FORMAT_ADTS ? 0xF0 : 0xE0;
+    size_t i = 0;
+#if defined(FRAMESCANNER_USE_SSE2)
+    const __m128i ff = _mm_set1_epi8(static_cast<char>(0xFF));
+    const __m128i m = _mm_set1_epi8(static_cast<char>(mask));
+    for (; i + 33 <= size; i += 32) {
+        const __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        const __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 16));
+        const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 1));
+        const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 17));
+        const __m128i c0 = _mm_and_si128(_mm_cmpeq_epi8(a0, ff), _mm_cmpeq_epi8(_mm_and_si128(b0, m), m));
+        const __m128i c1 = _mm_and_si128(_mm_cmpeq_epi8(a1, ff), _mm_cmpeq_epi8(_mm_and_si128(b1, m), m));
+        const unsigned int bits = static_cast<unsigned int>(_mm_movemask_epi8(c0)) |
+                                  (static_cast<unsigned int>(_mm_movemask_epi8(c1)) << 16);
+        if (bits) {
+            return i + lowestBit(bits);
+        }
+    }
+#elif defined(FRAMESCANNER_USE_NEON)
+    const uint8x16_t ff = vdupq_n_u8(0xFF);
+    const uint8x16_t m = vdupq_n_u8(mask);
+    for (; i + 33 <= size; i += 32) {
+        const uint8x16_t c0 = vandq_u8(vceqq_u8(vld1q_u8(data + i), ff),
+                                       vceqq_u8(vandq_u8(vld1q_u8(data + i + 1), m), m));
+        const uint8x16_t c1 = vandq_u8(vceqq_u8(vld1q_u8(data + i + 16), ff),
+                                       vceqq_u8(vandq_u8(vld1q_u8(data + i + 17), m), m));
+        if (vmaxvq_u8(vorrq_u8(c0, c1))) {
+            break; // it's in these 32 bytes; the loop below finds where
+        }
+    }
+#endif
+    for (; i + 1 < size; i++) {
+        if (data[i] == 0xFF && (data[i + 1] & mask) == mask) {
+            return i;
+        }
+    }
+    return size;
+}
+
+bool AudioDecoderFrameScanner::parseMpegHeader(const unsigned char *h, AudioDecoderFrameHeader *header)
+{
+    static const short kBitrates[2][3][15] = {
+        { { 0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448 },
+          { 0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384 },
+          { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320 } },
+        { { 0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256 },
+          { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 },
+          { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 } } };
+    static const int kSampleRates[3] = { 44100, 48000, 32000 };
+
+    if (h[0] != 0xFF || (h[1] & 0xE0) != 0xE0) {
+        return false;
+    }
+    const int versionBits = (h[1] >> 3) & 3;
+    const int layerBits = (h[1] >> 1) & 3;
+    const int bitrateIndex = h[2] >> 4;
+    const int rateIndex = (h[2] >> 2) & 3;
+    if (versionBits == 1 || layerBits == 0 || bitrateIndex == 0 ||
+        bitrateIndex == 15 || rateIndex == 3) {
+        return false; // reserved values, or free format which we don't do
+    }
+
+    header->version = versionBits == 3 ? 1 : (versionBits == 2 ? 2 : 25);
+    header->layer = 4 - layerBits;
+    header->bitrate = kBitrates[header->version == 1 ? 0 : 1][header->layer - 1][bitrateIndex] * 1000;
+    header->sampleRate = kSampleRates[rateIndex] >> (header->version == 1 ? 0 : (header->version == 2 ? 1 : 2));
+    header->channels = (h[3] >> 6) == 3 ? 1 : 2;
+    if (header->layer == 1) {
+        header->samplesPerFrame = 384;
+    } else if (header->layer == 3 && header->version != 1) {
+        header->samplesPerFrame = 576;
+    } else {
+        header->samplesPerFrame = 1152;
+    }
+    const int padding = (h[2] >> 1) & 1;
+    if (header->layer == 1) {
+        //Layer I counts in 4-byte slots, and rounds down to whole slots.
+        header->frameLength = (12 * header->bitrate / header->sampleRate + padding) * 4;
+    } else {
+        header->frameLength = header->samplesPerFrame / 8 * header->bitrate / header->sampleRate + padding;
+    }
+    return true;
+}
+
+bool AudioDecoderFrameScanner::parseAdtsHeader(const unsigned char *h, AudioDecoderFrameHeader *header)
+{
+    static const int kSampleRates[13] = { 96000, 88200, 64000, 48000, 44100, 32000, 24000,
+                                          22050, 16000, 12000, 11025, 8000, 7350 };
+
+    //12 sync bits, then the layer, which is always 0.
+    if (h[0] != 0xFF || (h[1] & 0xF6) != 0xF0) {
+        return false;
+    }
+    const int rateIndex = (h[2] >> 2) & 0xF;
+    const int channelConfig = ((h[2] & 1) << 2) | (h[3] >> 6);
+    const int frameLength = ((h[3] & 3) << 11) | (h[4] << 3) | (h[5] >> 5);
+    const int headerLength = (h[1] & 1) ? 7 : 9; // 9 with a CRC
+    if (rateIndex >= 13 || frameLength <= headerLength) {
+        return false;
+    }
+
+    header->version = (h[1] & 0x08) ? 2 : 4;
+    header->layer = 0;
+    header->bitrate = 0;
+    header->sampleRate = kSampleRates[rateIndex];
+    header->channels = channelConfig == 7 ? 8 : channelConfig;
+    header->samplesPerFrame = 1024 * ((h[6] & 3) + 1);
+    header->frameLength = frameLength;
+    return true;
+}
@@ -0,0 +1,744 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET SocketHandle;
+#define closeSocket closesocket
+#else
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int SocketHandle;
+#define INVALID_SOCKET -1
+#define closeSocket close
+#endif
+#include "audiodecoderhttpsource.h"
+#include "audiodecodertrace.h"
+
+#if defined(MSG_NOSIGNAL)
+const int kSendFlags = MSG_NOSIGNAL; // a dead peer shouldn't SIGPIPE the host app
+#else
+const int kSendFlags = 0;
+#endif
+
+/** Winsock needs initializing once per process; everyone else is ready to go. */
+static bool socketsReady()
+{
+#ifdef _WIN32
+    static bool ready = false;
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!ready) {
+        WSADATA wsaData;
+        ready = WSAStartup(MAKEWORD(2, 2), &wsaData) == 0;
+    }
+    return ready;
+#else
+    return true;
+#endif
+}
+
+static void configureSocket(SocketHandle socket)
+{
+    int one = 1;
+    setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&one), sizeof(one));
+#if defined(SO_NOSIGPIPE)
+    setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+}
+
+/** Makes send() and recv() give up after timeoutMs instead of blocking forever. */
+static void setSocketTimeout(SocketHandle socket, int timeoutMs)
+{
+#ifdef _WIN32
+    DWORD timeout = timeoutMs;
+#else
+    struct timeval timeout;
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_usec = (timeoutMs % 1000) * 1000;
+#endif
+    setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+    setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+}
+
+static bool sendOnSocket(SocketHandle socket, const char *data, size_t size)
+{
+    while (size > 0) {
+        int sent = send(socket, data, static_cast<int>(size), kSendFlags);
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        size -= sent;
+    }
+    return true;
+}
+
+/** Receives until buffer holds a complete header block; returns its length
+    (including the blank line), leaving any body bytes after it in buffer. */
+static size_t recvHeaders(SocketHandle socket, std::string *buffer)
+{
+    const size_t kMaxHeaderSize = 64 * 1024;
+    size_t end;
+    while ((end = buffer->find("\r\n\r\n")) == std::string::npos) {
+        if (buffer->size() > kMaxHeaderSize) {
+            return 0;
+        }
+        char chunk[4096];
+        int received = recv(socket, chunk, sizeof(chunk), 0);
+        if (received <= 0) {
+            return 0;
+        }
+        buffer->append(chunk, received);
+    }
+    return end + 4;
+}
+
+/** Finds a header (case-insensitively) and returns its value, or "". */
+static std::string headerValue(const std::string& headers, const char *name)
+{
+    const size_t nameLength = strlen(name);
+    size_t lineStart = headers.find("\r\n");
+    while (lineStart != std::string::npos && lineStart + 2 < headers.size()) {
+        lineStart += 2;
+        size_t lineEnd = headers.find("\r\n", lineStart);
+        if (lineEnd == std::string::npos) {
+            break;
+        }
+        if (lineEnd - lineStart > nameLength && headers[lineStart + nameLength] == ':' &&
+#ifdef _WIN32
+            _strnicmp(headers.c_str() + lineStart, name, nameLength) == 0) {
+#else
+            strncasecmp(headers.c_str() + lineStart, name, nameLength) == 0) {
+#endif
+            size_t valueStart = headers.find_first_not_of(' ', lineStart + nameLength + 1);
+            return headers.substr(valueStart, lineEnd - valueStart);
+        }
+        lineStart = lineEnd;
+    }
+    return std::string();
+}
+
+//-------------------------------------------------------------------
+// AudioDecoderHttpSource
+//-------------------------------------------------------------------
+
+AudioDecoderHttpSource::AudioDecoderHttpSource(const std::string url, int blockSize,
+                                               int cacheBlocks, int maxReadAheadBlocks,
+                                               int timeoutMs)
+: m_port("80")
+, m_path("/")
+, m_socket(-1)
+, m_size(-1)
+, m_iBlockSize(blockSize > 0 ? blockSize : 64 * 1024)
+, m_iCacheBlocks(cacheBlocks)
+, m_iMaxReadAhead(maxReadAheadBlocks > 0 ? maxReadAheadBlocks : 1)
+, m_iTimeoutMs(timeoutMs > 0 ? timeoutMs : 10000)
+, m_iReadAhead(1)
+, m_nextSequentialBlock(0)
+, m_useClock(0)
+, m_iRequests(0)
+, m_bytesFetched(0)
+{
+    //A fetch has to fit in the cache along with the block being read.
+    if (m_iCacheBlocks < m_iMaxReadAhead + 1) {
+        m_iCacheBlocks = m_iMaxReadAhead + 1;
+    }
+
+    const std::string scheme("http://");
+    if (url.compare(0, scheme.size(), scheme) != 0) {
+        return;
+    }
+    size_t hostStart = scheme.size();
+    size_t pathStart = url.find('/', hostStart);
+    std::string authority = url.substr(hostStart, pathStart == std::string::npos ?
+                                                  std::string::npos : pathStart - hostStart);
+    if (pathStart != std::string::npos) {
+        m_path = url.substr(pathStart);
+    }
+    size_t colon = authority.rfind(':');
+    if (colon != std::string::npos && authority.find(']', colon) == std::string::npos) {
+        m_port = authority.substr(colon + 1);
+        authority = authority.substr(0, colon);
+    }
+    if (authority.size() > 2 && authority[0] == '[') {
+        authority = authority.substr(1, authority.size() - 2); // [::1]
+    }
+    m_host = authority;
+
+    //The first block is what open() reads anyway, and its response tells us the size.
+    std::lock_guard<std::mutex> lock(m_mutex);
+    fetch(0, 1);
+}
+
+AudioDecoderHttpSource::~AudioDecoderHttpSource()
+{
+    disconnect();
+}
+
+long long AudioDecoderHttpSource::pread(void *buffer, long long size, long long offset)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_size < 0 || offset < 0 || size < 0) {
+        return -1;
+    }
+    if (offset >= m_size) {
+        return 0;
+    }
+    if (size > m_size - offset) {
+        size = m_size - offset;
+    }
+
+    long long total = 0;
+    while (total < size) {
+        const long long position = offset + total;
+        const long long index = position / m_iBlockSize;
+        Block *block = findBlock(index);
+        if (!block) {
+            //Grow the read-ahead while the decoder is streaming; a jump
+            //anywhere else means a seek, so only fetch what's needed.
+            if (index == m_nextSequentialBlock) {
+                m_iReadAhead = m_iReadAhead * 2 > m_iMaxReadAhead ? m_iMaxReadAhead : m_iReadAhead * 2;
+            } else {
+                m_iReadAhead = 1;
+            }
+            const long long lastBlock = (m_size - 1) / m_iBlockSize;
+            int numBlocks = 1;
+            while (numBlocks < m_iReadAhead && index + numBlocks <= lastBlock &&
+                   !findBlock(index + numBlocks)) {
+                numBlocks++;
+            }
+            if (!fetch(index, numBlocks) || !(block = findBlock(index))) {
+                return total > 0 ? total : -1;
+            }
+            m_nextSequentialBlock = index + numBlocks;
+        }
+        block->lastUsed = ++m_useClock;
+
+        long long inBlock = position - index * m_iBlockSize;
+        long long available = static_cast<long long>(block->data.size()) - inBlock;
+        if (available <= 0) {
+            break;
+        }
+        long long chunk = size - total < available ? size - total : available;
+        memcpy(static_cast<char*>(buffer) + total, &block->data[0] + inBlock,
+               static_cast<size_t>(chunk));
+        total += chunk;
+    }
+    return total;
+}
+
+AudioDecoderHttpSource::Block *AudioDecoderHttpSource::findBlock(long long index)
+{
+    for (size_t i = 0; i < m_cache.size(); i++) {
+        if (m_cache[i].index == index) {
+            return &m_cache[i];
+        }
+    }
+    return NULL;
+}
+
+AudioDecoderHttpSource::Block *AudioDecoderHttpSource::allocateBlock(long long index)
+{
+    Block *block = NULL;
+    if (static_cast<int>(m_cache.size()) < m_iCacheBlocks) {
+        m_cache.push_back(Block());
+        block = &m_cache.back();
+        block->data.reserve(m_iBlockSize);
+    } else {
+        //Evict the least recently used block.
+        block = &m_cache[0];
+        for (size_t i = 1; i < m_cache.size(); i++) {
+            if (m_cache[i].lastUsed < block->lastUsed) {
+                block = &m_cache[i];
+            }
+        }
+    }
+    block->index = index;
+    block->data.clear();
+    block->lastUsed = ++m_useClock;
+    return block;
+}
+
+bool AudioDecoderHttpSource::fetch(long long firstBlock, int numBlocks)
+{
+    AUDIODECODER_TRACE_SCOPE_ARG("io", "HttpSource::fetch", "blocks", numBlocks);
+    const long long first = firstBlock * m_iBlockSize;
+    long long last = first + static_cast<long long>(numBlocks) * m_iBlockSize - 1;
+    if (m_size >= 0 && last >= m_size) {
+        last = m_size - 1;
+    }
+
+    Response response;
+    //A keep-alive connection the server has since closed fails the first
+    //time round; try once more on a fresh one.
+    if (!request(first, last, &response)) {
+        disconnect();
+        if (!request(first, last, &response)) {
+            disconnect();
+            return false;
+        }
+    }
+    m_iRequests++;
+
+    const long long contentLength = response.contentLength;
+    bool keepAlive = response.keepAlive;
+    long long bodyOffset = 0;
+    if (response.status == 206) {
+        //The body starts where Content-Range says, which may be before what
+        //we asked for (a server rounding to its own chunks; the extra is
+        //skipped) but mustn't be after it, or stop short of it before the
+        //end of the file.
+        const long long rangeEnd = response.rangeFirst + contentLength;
+        if (response.rangeFirst < 0 || response.rangeFirst > first ||
+            response.rangeLast != rangeEnd - 1 ||
+            (response.rangeLast < last && response.rangeLast != response.totalSize - 1)) {
+            disconnect();
+            return false;
+        }
+        bodyOffset = response.rangeFirst;
+        if (response.totalSize >= 0) {
+            m_size = response.totalSize;
+        }
+    } else if (response.status == 200) {
+        //The server ignored the Range header and is sending everything.
+        //Keep what we asked for and hang up on the rest.
+        m_size = contentLength;
+        keepAlive = false;
+    } else {
+        disconnect();
+        return false;
+    }
+    if (contentLength < 0 || m_size < 0) {
+        disconnect();
+        return false;
+    }
+
+    //Stream the body into cache blocks.
+    const long long bodyEnd = bodyOffset + contentLength;
+    long long position = bodyOffset;
+    std::vector<char> discard;
+    while (position < bodyEnd && position <= last) {
+        const long long index = position / m_iBlockSize;
+        long long blockEnd = (index + 1) * m_iBlockSize;
+        if (blockEnd > bodyEnd) {
+            blockEnd = bodyEnd;
+        }
+        const size_t length = static_cast<size_t>(blockEnd - position);
+        if (index < firstBlock) {
+            discard.resize(length);
+            if (!recvExact(&discard[0], length)) {
+                disconnect();
+                return false;
+            }
+        } else {
+            Block *block = findBlock(index);
+            if (!block) {
+                block = allocateBlock(index);
+            }
+            block->data.resize(length);
+            if (!recvExact(&block->data[0], length)) {
+                block->index = -1;
+                disconnect();
+                return false;
+            }
+        }
+        m_bytesFetched += length;
+        position = blockEnd;
+    }
+    if (!keepAlive || position < bodyEnd) {
+        disconnect();
+    }
+    return true;
+}
+
+bool AudioDecoderHttpSource::request(long long first, long long last, Response *response)
+{
+    if (m_socket < 0 && !connectToServer()) {
+        return false;
+    }
+    char range[64];
+    snprintf(range, sizeof(range), "bytes=%lld-%lld", first, last);
+    //An IPv6 literal goes back in its brackets.
+    const std::string host = m_host.find(':') == std::string::npos ? m_host : "[" + m_host + "]";
+    std::string request = "GET " + m_path + " HTTP/1.1\r\n"
+                          "Host: " + host + ":" + m_port + "\r\n"
+                          "Range: " + range + "\r\n"
+                          "Connection: keep-alive\r\n\r\n";
+    if (!sendAll(request.data(), request.size())) {
+        return false;
+    }
+
+    size_t headerLength = recvHeaders(static_cast<SocketHandle>(m_socket), &m_recvBuffer);
+    if (headerLength == 0) {
+        return false;
+    }
+    std::string headers = m_recvBuffer.substr(0, headerLength);
+    m_recvBuffer.erase(0, headerLength);
+
+    if (sscanf(headers.c_str(), "HTTP/%*d.%*d %d", &response->status) != 1) {
+        return false;
+    }
+    std::string value = headerValue(headers, "Content-Length");
+    response->contentLength = value.empty() ? -1 : atoll(value.c_str());
+    value = headerValue(headers, "Content-Range");
+    if (sscanf(value.c_str(), "bytes %lld-%lld", &response->rangeFirst, &response->rangeLast) != 2) {
+        response->rangeFirst = response->rangeLast = -1;
+    }
+    size_t slash = value.find('/');
+    response->totalSize = (slash == std::string::npos || value[slash + 1] == '*') ? -1 :
+                          atoll(value.c_str() + slash + 1);
+    value = headerValue(headers, "Connection");
+    response->keepAlive = value != "close" && value != "Close";
+    return true;
+}
+
+bool AudioDecoderHttpSource::connectToServer()
+{
+    if (m_host.empty() || !socketsReady()) {
+        return false;
+    }
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo *addresses = NULL;
+    if (getaddrinfo(m_host.c_str(), m_port.c_str(), &hints, &addresses) != 0) {
+        return false;
+    }
+    SocketHandle socket = INVALID_SOCKET;
+    for (struct addrinfo *address = addresses; address; address = address->ai_next) {
+        socket = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (socket == INVALID_SOCKET) {
+            continue;
+        }
+        if (connect(socket, address->ai_addr, static_cast<int>(address->ai_addrlen)) == 0) {
+            break;
+        }
+        closeSocket(socket);
+        socket = INVALID_SOCKET;
+    }
+    freeaddrinfo(addresses);
+    if (socket == INVALID_SOCKET) {
+        return false;
+    }
+    configureSocket(socket);
+    setSocketTimeout(socket, m_iTimeoutMs);
+    m_socket = static_cast<long long>(socket);
+    m_recvBuffer.clear();
+    return true;
+}
+
+void AudioDecoderHttpSource::disconnect()
+{
+    if (m_socket >= 0) {
+        closeSocket(static_cast<SocketHandle>(m_socket));
+        m_socket = -1;
+    }
+    m_recvBuffer.clear();
+}
+
+bool AudioDecoderHttpSource::sendAll(const char *data, size_t size)
+{
+    return sendOnSocket(static_cast<SocketHandle>(m_socket), data, size);
+}
+
+bool AudioDecoderHttpSource::recvExact(char *data, size_t size)
+{
+    size_t buffered = m_recvBuffer.size() < size ? m_recvBuffer.size() : size;
+    memcpy(data, m_recvBuffer.data(), buffered);
+    m_recvBuffer.erase(0, buffered);
+    while (buffered < size) {
+        int received = recv(static_cast<SocketHandle>(m_socket), data + buffered,
+                            static_cast<int>(size - buffered), 0);
+        if (received <= 0) {
+            return false;
+        }
+        buffered += received;
+    }
+    return true;
+}
+
+//-------------------------------------------------------------------
+// AudioDecoderLoopbackHttpServer
+//-------------------------------------------------------------------
+
+enum RangeResult { RANGE_IGNORED, RANGE_SATISFIABLE, RANGE_UNSATISFIABLE };
+
+/** Parses the value of a Range header (RFC 7233) against a body of size
+    bytes. Only the first range of a list is served. A header that doesn't
+    parse is ignored and the whole body is sent, as the RFC says. */
+static RangeResult parseRange(const std::string& value, long long size, long long *first, long long *last)
+{
+    if (value.compare(0, 6, "bytes=") != 0) {
+        return RANGE_IGNORED;
+    }
+    const char *spec = value.c_str() + 6;
+    char *end = NULL;
+    if (*spec == '-') {
+        //bytes=-N is the last N bytes.
+        if (spec[1] < '0' || spec[1] > '9') {
+            return RANGE_IGNORED;
+        }
+        const long long suffix = strtoll(spec + 1, &end, 10);
+        if (suffix <= 0 || size <= 0) {
+            return RANGE_UNSATISFIABLE;
+        }
+        *first = suffix < size ? size - suffix : 0;
+        *last = size - 1;
+        return RANGE_SATISFIABLE;
+    }
+    if (*spec < '0' || *spec > '9') {
+        return RANGE_IGNORED;
+    }
+    *first = strtoll(spec, &end, 10);
+    if (*end != '-' || *first < 0) {
+        return RANGE_IGNORED;
+    }
+    *last = size - 1;
+    if (end[1] >= '0' && end[1] <= '9') {
+        *last = strtoll(end + 1, NULL, 10);
+        if (*last < *first) {
+            return RANGE_IGNORED;
+        }
+    }
+    if (*first >= size) {
+        return RANGE_UNSATISFIABLE;
+    }
+    if (*last >= size) {
+        *last = size - 1;
+    }
+    return RANGE_SATISFIABLE;
+}
+
+AudioDecoderLoopbackHttpServer::AudioDecoderLoopbackHttpServer(const void *data, long long size)
+: m_pData(static_cast<const char*>(data))
+, m_size(size)
+, m_listenSocket(-1)
+, m_iPort(0)
+{
+    m_running = false;
+    m_iRequests = 0;
+    m_iConnections = 0;
+    m_bytesServed = 0;
+    m_rangesSupported = true;
+    m_iMaxRequestsPerConnection = 0;
+    m_stalled = false;
+    m_rangeShift = 0;
+}
+
+AudioDecoderLoopbackHttpServer::~AudioDecoderLoopbackHttpServer()
+{
+    stop();
+}
+
+int AudioDecoderLoopbackHttpServer::start()
+{
+    if (m_running || !socketsReady()) {
+        return AUDIODECODER_ERROR;
+    }
+    SocketHandle listenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listenSocket == INVALID_SOCKET) {
+        return AUDIODECODER_ERROR;
+    }
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    socklen_t addressLength = sizeof(address);
+    if (bind(listenSocket, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listenSocket, 16) != 0 ||
+        getsockname(listenSocket, reinterpret_cast<struct sockaddr*>(&address), &addressLength) != 0) {
+        closeSocket(listenSocket);
+        return AUDIODECODER_ERROR;
+    }
+    m_iPort = ntohs(address.sin_port);
+    m_listenSocket = static_cast<long long>(listenSocket);
+    m_running = true;
+    m_acceptThread = std::thread(&AudioDecoderLoopbackHttpServer::acceptLoop, this);
+    return AUDIODECODER_OK;
+}
+
+void AudioDecoderLoopbackHttpServer::stop()
+{
+    if (!m_running) {
+        return;
+    }
+    m_running = false;
+    m_acceptThread.join();
+    closeSocket(static_cast<SocketHandle>(m_listenSocket));
+    m_listenSocket = -1;
+
+    //Kick the connection threads out of recv().
+    std::vector<std::thread> threads;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (size_t i = 0; i < m_connectionSockets.size(); i++) {
+            shutdown(static_cast<SocketHandle>(m_connectionSockets[i]), 2 /* both directions */);
+        }
+        threads.swap(m_connectionThreads);
+    }
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+}
+
+std::string AudioDecoderLoopbackHttpServer::url() const
+{
+    char url[64];
+    snprintf(url, sizeof(url), "http://127.0.0.1:%d/audio", m_iPort);
+    return url;
+}
+
+void AudioDecoderLoopbackHttpServer::acceptLoop()
+{
+    const SocketHandle listenSocket = static_cast<SocketHandle>(m_listenSocket);
+    while (m_running) {
+        //Poll so that stop() doesn't depend on closing a socket under accept().
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(listenSocket, &readable);
+        struct timeval timeout = { 0, 50 * 1000 };
+        if (select(static_cast<int>(listenSocket) + 1, &readable, NULL, NULL, &timeout) <= 0) {
+            continue;
+        }
+        SocketHandle connection = accept(listenSocket, NULL, NULL);
+        if (connection == INVALID_SOCKET) {
+            continue;
+        }
+        configureSocket(connection);
+        m_iConnections++;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_connectionSockets.push_back(static_cast<long long>(connection));
+        m_connectionThreads.push_back(std::thread(&AudioDecoderLoopbackHttpServer::serveConnection,
+                                                  this, static_cast<long long>(connection)));
+    }
+}
+
+void AudioDecoderLoopbackHttpServer::serveConnection(long long socketValue)
+{
+    const SocketHandle socket = static_cast<SocketHandle>(socketValue);
+    std::string buffer;
+    int responses = 0;
+    while (m_running) {
+        size_t headerLength = recvHeaders(socket, &buffer);
+        if (headerLength == 0) {
+            break;
+        }
+        std::string headers = buffer.substr(0, headerLength);
+        buffer.erase(0, headerLength);
+        m_iRequests++;
+        if (m_stalled) {
+            while (m_running) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            break;
+        }
+
+        const bool isHead = headers.compare(0, 5, "HEAD ") == 0;
+        long long first = 0;
+        long long last = m_size - 1;
+        RangeResult range = RANGE_IGNORED;
+        if (m_rangesSupported) {
+            range = parseRange(headerValue(headers, "Range"), m_size, &first, &last);
+            if (range == RANGE_IGNORED) {
+                first = 0;
+                last = m_size - 1;
+            }
+        }
+        const bool isRange = range == RANGE_SATISFIABLE;
+        if (isRange) {
+            first = std::max(0LL, std::min(last, first + m_rangeShift.load()));
+        }
+
+        char header[256];
+        if (range == RANGE_UNSATISFIABLE) {
+            snprintf(header, sizeof(header),
+                     "HTTP/1.1 416 Range Not Satisfiable\r\nContent-Range: bytes */%lld\r\n"
+                     "Content-Length: 0\r\n\r\n", m_size);
+            first = 0;
+            last = -1;
+        } else if (isRange) {
+            snprintf(header, sizeof(header),
+                     "HTTP/1.1 206 Partial Content\r\nContent-Range: bytes %lld-%lld/%lld\r\n"
+                     "Content-Length: %lld\r\nAccept-Ranges: bytes\r\n\r\n",
+                     first, last, m_size, last - first + 1);
+        } else {
+            snprintf(header, sizeof(header),
+                     "HTTP/1.1 200 OK\r\nContent-Length: %lld\r\nAccept-Ranges: bytes\r\n\r\n",
+                     m_size);
+        }
+        if (!sendOnSocket(socket, header, strlen(header))) {
+            break;
+        }
+        if (!isHead && last >= first) {
+            if (!sendOnSocket(socket, m_pData + first, static_cast<size_t>(last - first + 1))) {
+                break;
+            }
+            m_bytesServed += last - first + 1;
+        }
+        std::string connection = headerValue(headers, "Connection");
+        if (connection == "close" || connection == "Close") {
+            break;
+        }
+        if (++responses == m_iMaxRequestsPerConnection) {
+            break;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t i = 0; i < m_connectionSockets.size(); i++) {
+        if (m_connectionSockets[i] == socketValue) {
+            m_connectionSockets.erase(m_connectionSockets.begin() + i);
+            break;
+        }
+    }
+    closeSocket(socket);
+}
@@ -0,0 +1,220 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+
+#include <algorithm>
+#include <cstring>
+#include "audiodecoder.h"
+#include "audiodecoderasync.h"
+#include "audiodecoderinstantstart.h"
+
+AudioDecoderInstantStart::AudioDecoderInstantStart(AudioDecoder *decoder,
+                                                   AudioDecoderExecutor *executor,
+                                                   int firstBlockFrames)
+: m_pDecoder(decoder)
+, m_pExecutor(executor ? executor : AudioDecoderExecutor::defaultExecutor())
+, m_iFirstBlockFrames(firstBlockFrames > 0 ? firstBlockFrames : 1)
+, m_started(false)
+, m_opened(false)
+, m_firstBlockDone(false)
+, m_iOpenResult(AUDIODECODER_ERROR)
+, m_iNumSamples(0)
+, m_iChannels(0)
+, m_iSampleRate(0)
+, m_fDuration(0)
+, m_firstBlockOffset(0)
+, m_iPosition(0)
+{
+}
+
+AudioDecoderInstantStart::~AudioDecoderInstantStart()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_started) {
+        waitForFirstBlock(lock);
+    }
+}
+
+void AudioDecoderInstantStart::open(Callback propertiesReady)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_started) {
+            return;
+        }
+        m_started = true;
+        m_propertiesReady = propertiesReady;
+    }
+    m_pExecutor->execute(std::bind(&AudioDecoderInstantStart::run, this));
+}
+
+void AudioDecoderInstantStart::run()
+{
+    //Nothing else touches the decoder until m_firstBlockDone is set.
+    const int result = m_pDecoder->open();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_iOpenResult = result;
+        m_opened = true;
+        if (result == AUDIODECODER_OK) {
+            m_iNumSamples = m_pDecoder->numSamples();
+            m_iChannels = m_pDecoder->channels();
+            m_iSampleRate = m_pDecoder->sampleRate();
+            m_fDuration = m_pDecoder->duration();
+        }
+    }
+    m_changed.notify_all();
+    if (m_propertiesReady) {
+        m_propertiesReady(result);
+    }
+
+    std::vector<SAMPLE> block;
+    if (result == AUDIODECODER_OK) {
+        block.resize(static_cast<size_t>(m_iFirstBlockFrames) * m_pDecoder->channels());
+        const int got = m_pDecoder->read(static_cast<int>(block.size()), &block[0]);
+        block.resize(got > 0 ? got : 0);
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_firstBlock.swap(block);
+        m_firstBlockDone = true;
+        //Under the lock, because the destructor may run as soon as it's released.
+        m_changed.notify_all();
+    }
+}
+
+void AudioDecoderInstantStart::waitForFirstBlock(std::unique_lock<std::mutex>& lock)
+{
+    m_changed.wait(lock, [this] { return m_firstBlockDone; });
+}
+
+int AudioDecoderInstantStart::waitForOpen()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_started) {
+        return AUDIODECODER_ERROR;
+    }
+    m_changed.wait(lock, [this] { return m_opened; });
+    return m_iOpenResult;
+}
+
+bool AudioDecoderInstantStart::isOpen() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_opened;
+}
+
+int AudioDecoderInstantStart::read(int size, const SAMPLE *buffer)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_started) {
+        return 0;
+    }
+    waitForFirstBlock(lock);
+    if (m_iOpenResult != AUDIODECODER_OK || size <= 0) {
+        return 0;
+    }
+    //The background work is over, so the decoder is ours from here on.
+    lock.unlock();
+
+    SAMPLE *out = const_cast<SAMPLE*>(buffer);
+    int done = 0;
+    if (m_firstBlockOffset < m_firstBlock.size()) {
+        done = static_cast<int>(std::min(m_firstBlock.size() - m_firstBlockOffset,
+                                         static_cast<size_t>(size)));
+        memcpy(out, &m_firstBlock[m_firstBlockOffset], done * sizeof(SAMPLE));
+        m_firstBlockOffset += done;
+        if (m_firstBlockOffset == m_firstBlock.size()) {
+            std::vector<SAMPLE>().swap(m_firstBlock);
+            m_firstBlockOffset = 0;
+        }
+    }
+    if (done < size) {
+        done += m_pDecoder->read(size - done, out + done);
+    }
+    m_iPosition += done;
+    return done;
+}
+
+int AudioDecoderInstantStart::seek(int sampleIdx)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_started) {
+        return AUDIODECODER_ERROR;
+    }
+    waitForFirstBlock(lock);
+    if (m_iOpenResult != AUDIODECODER_OK) {
+        return AUDIODECODER_ERROR;
+    }
+    lock.unlock();
+
+    std::vector<SAMPLE>().swap(m_firstBlock);
+    m_firstBlockOffset = 0;
+    const int result = m_pDecoder->seek(sampleIdx);
+    m_iPosition = m_pDecoder->positionInSamples();
+    return result;
+}
+
+int AudioDecoderInstantStart::numSamples() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_iNumSamples;
+}
+
+int AudioDecoderInstantStart::channels() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_iChannels;
+}
+
+int AudioDecoderInstantStart::sampleRate() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_iSampleRate;
+}
+
+float AudioDecoderInstantStart::duration() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_fDuration;
+}
+
+int AudioDecoderInstantStart::positionInSamples() const
+{
+    return m_iPosition;
+}
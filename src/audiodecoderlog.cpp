@@ -0,0 +1,148 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <chrono>
+#include "audiodecoderlog.h"
+
+namespace {
+
+struct SinkEntry
+{
+    AudioDecoderLog::Sink sink;
+    void *userData;
+};
+
+void logToStderr(AudioDecoderLog::Level level, const char *message, void *)
+{
+    //One call per line, so lines from different threads don't interleave.
+    fprintf(stderr, "libaudiodecoder %s: %s\n", AudioDecoderLog::levelName(level), message);
+}
+
+const SinkEntry s_stderrSink = { logToStderr, NULL };
+
+//setSink() swaps in a new entry rather than changing two fields, so a
+//concurrent write() sees a sink and the userData that goes with it. The old
+//entries are never freed: it's rare, and a writer may still be using one.
+std::atomic<const SinkEntry*> s_sink(&s_stderrSink);
+std::atomic<int> s_rateLimit(10);
+
+long long nowMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+std::atomic<int> AudioDecoderLog::s_level(AudioDecoderLog::LEVEL_WARNING);
+
+void AudioDecoderLog::setLevel(Level level)
+{
+    s_level.store(level, std::memory_order_relaxed);
+}
+
+AudioDecoderLog::Level AudioDecoderLog::level()
+{
+    return static_cast<Level>(s_level.load(std::memory_order_relaxed));
+}
+
+void AudioDecoderLog::setSink(Sink sink, void *userData)
+{
+    const SinkEntry *entry = &s_stderrSink;
+    if (sink) {
+        SinkEntry *custom = new SinkEntry;
+        custom->sink = sink;
+        custom->userData = userData;
+        entry = custom;
+    }
+    s_sink.store(entry, std::memory_order_release);
+}
+
+void AudioDecoderLog::setRateLimit(int messagesPerSecond)
+{
+    s_rateLimit.store(messagesPerSecond > 0 ? messagesPerSecond : 0, std::memory_order_relaxed);
+}
+
+void AudioDecoderLog::write(AudioDecoderLogSite *site, Level level, const char *format, ...)
+{
+    //Decide whether it's dropped before formatting anything.
+    const int limit = s_rateLimit.load(std::memory_order_relaxed);
+    if (limit > 0) {
+        const long long now = nowMs();
+        long long windowStart = site->windowStart.load(std::memory_order_relaxed);
+        if (now - windowStart >= 1000 &&
+            site->windowStart.compare_exchange_strong(windowStart, now, std::memory_order_relaxed)) {
+            site->count.store(0, std::memory_order_relaxed);
+        }
+        if (site->count.fetch_add(1, std::memory_order_relaxed) >= limit) {
+            site->suppressed.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    char message[1024];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+    if (length < 0) {
+        return;
+    }
+    const int suppressed = site->suppressed.exchange(0, std::memory_order_relaxed);
+    if (suppressed > 0 && static_cast<size_t>(length) < sizeof(message)) {
+        snprintf(message + length, sizeof(message) - length,
+                 " (%d more like this were dropped)", suppressed);
+    }
+
+    const SinkEntry *entry = s_sink.load(std::memory_order_acquire);
+    entry->sink(level, message, entry->userData);
+}
+
+const char *AudioDecoderLog::levelName(Level level)
+{
+    switch (level) {
+        case LEVEL_DEBUG:   return "debug";
+        case LEVEL_INFO:    return "info";
+        case LEVEL_WARNING: return "warning";
+        case LEVEL_ERROR:   return "error";
+        default:            return "none";
+    }
+}
@@ -49,8 +49,8 @@
  * the Microsoft-provided AAC decoder. XP does not include Media Foundation.
  */
 
-#include <iostream>
 #include <string.h>
+#include <new>
 #include <windows.h>
 #include <mfapi.h>
 #include <mfidl.h>
@@ -60,14 +60,47 @@
 #include <assert.h>
 
 #include "audiodecodermediafoundation.h"
+#include "audiodecoderallocator.h"
+#include "audiodecoderprobe.h"
+#include "audiodecoderlog.h"
+#include "audiodecodersource.h"
+#include "audiodecodertrace.h"
 
 const int kBitsPerSample = 16;
 const int kNumChannels = 2;
 const int kSampleRate = 44100;
 const int kLeftoverSize = 4096; // in int16's, this seems to be the size MF AAC
 // decoder likes to give
+const int kViewFrames = 4096; // what readView() converts at a time when it has to
+
+/** COM has to be initialized on every thread that calls into Media
+    Foundation, and uninitialized on that same thread. Decoders move between
+    threads (AudioDecoderPool, AudioDecoderAsync, AudioDecoderScheduler...),
+    so each thread that uses one initializes COM the first time, and
+    uninitializes it when the thread exits. */
+class ComThreadScope
+{
+public:
+    ComThreadScope() : m_hr(CoInitializeEx(NULL, COINIT_APARTMENTTHREADED | COINIT_DISABLE_OLE1DDE)) {}
+    ~ComThreadScope()
+    {
+        // S_FALSE (already initialized on this thread) still needs
+        // balancing; RPC_E_CHANGED_MODE (the host chose another threading
+        // model) didn't initialize anything, but COM is usable anyway.
+        if (SUCCEEDED(m_hr)) {
+            CoUninitialize();
+        }
+    }
+    bool ready() const { return SUCCEEDED(m_hr) || m_hr == RPC_E_CHANGED_MODE; }
+private:
+    HRESULT m_hr;
+};
 
-const static bool sDebug = false;
+static bool comReadyOnThisThread()
+{
+    static thread_local ComThreadScope s_com;
+    return s_com.ready();
+}
 
 /** Microsoft examples use this snippet often. */
 template<class T> static void safeRelease(T **ppT)
@@ -78,128 +111,463 @@ template<class T> static void safeRelease(T **ppT)
     }
 }
 
-std::wstring s2ws(const std::string& s)
+/** Exposes an AudioDecoderSource to Media Foundation as an IMFByteStream.
+    There's no file name for the source resolver to guess the format from,
+    so it also answers for IMFAttributes (delegating to a real attribute
+    store) to hand over MF_BYTESTREAM_CONTENT_TYPE. Reads are synchronous
+    pread()s on the source; BeginRead() completes straight away through the
+    MF work queue. The objects that carry each read's byte count come from
+    the decoder's allocator and are recycled, so steady-state reads don't
+    allocate on our side. */
+class SourceByteStream : public IMFByteStream, public IMFAttributes
 {
- int len;
- int slength = (int)s.length() + 1;
- len = MultiByteToWideChar(CP_ACP, 0, s.c_str(), slength, 0, 0); 
- wchar_t* buf = new wchar_t[len];
- MultiByteToWideChar(CP_ACP, 0, s.c_str(), slength, buf, len);
- std::wstring r(buf);
- delete[] buf;
- return r;
-}
+public:
+    static HRESULT create(AudioDecoderSource *source, AudioDecoderAllocator *allocator,
+                          AudioDecoderMetrics *metrics, SourceByteStream **ppStream)
+    {
+        SourceByteStream *pStream = new SourceByteStream(source, allocator, metrics);
+        //Room for the one read in flight, so reading never allocates.
+        pStream->m_pSpareResult = allocator->allocate(sizeof(ReadResult));
+        HRESULT hr = MFCreateAttributes(&pStream->m_pAttributes, 1);
+        if (SUCCEEDED(hr)) {
+            //Only the magic bytes; readProperties() probes the headers.
+            const wchar_t *contentType = NULL;
+            switch (AudioDecoderProbe::sniff(source)) {
+                case AudioStreamInfo::FORMAT_WAV:  contentType = L"audio/wav"; break;
+                case AudioStreamInfo::FORMAT_AIFF: contentType = L"audio/aiff"; break;
+                case AudioStreamInfo::FORMAT_MP3:  contentType = L"audio/mpeg"; break;
+                case AudioStreamInfo::FORMAT_MP4:  contentType = L"audio/mp4"; break;
+                case AudioStreamInfo::FORMAT_WMA:  contentType = L"audio/x-ms-wma"; break;
+                default: break;
+            }
+            if (contentType) {
+                hr = pStream->m_pAttributes->SetString(MF_BYTESTREAM_CONTENT_TYPE, contentType);
+            }
+        }
+        if (FAILED(hr)) {
+            pStream->Release();
+            return hr;
+        }
+        *ppStream = pStream;
+        return S_OK;
+    }
+
+    // IUnknown
+    STDMETHODIMP QueryInterface(REFIID riid, void **ppv)
+    {
+        if (!ppv) {
+            return E_POINTER;
+        }
+        if (riid == IID_IUnknown || riid == IID_IMFByteStream) {
+            *ppv = static_cast<IMFByteStream*>(this);
+        } else if (riid == IID_IMFAttributes) {
+            *ppv = static_cast<IMFAttributes*>(this);
+        } else {
+            *ppv = NULL;
+            return E_NOINTERFACE;
+        }
+        AddRef();
+        return S_OK;
+    }
+    STDMETHODIMP_(ULONG) AddRef() { return InterlockedIncrement(&m_refCount); }
+    STDMETHODIMP_(ULONG) Release()
+    {
+        ULONG count = InterlockedDecrement(&m_refCount);
+        if (count == 0) {
+            delete this;
+        }
+        return count;
+    }
+
+    // IMFByteStream
+    STDMETHODIMP GetCapabilities(DWORD *pdwCapabilities)
+    {
+        *pdwCapabilities = MFBYTESTREAM_IS_READABLE | MFBYTESTREAM_IS_SEEKABLE;
+        return S_OK;
+    }
+    STDMETHODIMP GetLength(QWORD *pqwLength)
+    {
+        *pqwLength = m_pSource->size();
+        return S_OK;
+    }
+    STDMETHODIMP SetLength(QWORD) { return E_NOTIMPL; }
+    STDMETHODIMP GetCurrentPosition(QWORD *pqwPosition)
+    {
+        EnterCriticalSection(&m_lock);
+        *pqwPosition = m_position;
+        LeaveCriticalSection(&m_lock);
+        return S_OK;
+    }
+    STDMETHODIMP SetCurrentPosition(QWORD qwPosition)
+    {
+        EnterCriticalSection(&m_lock);
+        m_position = qwPosition;
+        LeaveCriticalSection(&m_lock);
+        return S_OK;
+    }
+    STDMETHODIMP IsEndOfStream(BOOL *pfEndOfStream)
+    {
+        EnterCriticalSection(&m_lock);
+        *pfEndOfStream = m_position >= static_cast<QWORD>(m_pSource->size());
+        LeaveCriticalSection(&m_lock);
+        return S_OK;
+    }
+    STDMETHODIMP Read(BYTE *pb, ULONG cb, ULONG *pcbRead)
+    {
+        AUDIODECODER_TRACE_SCOPE_ARG("io", "SourceByteStream::Read", "bytes", cb);
+        EnterCriticalSection(&m_lock);
+        long long bytesRead = m_pSource->pread(pb, cb, m_position);
+        if (bytesRead > 0) {
+            m_position += bytesRead;
+            m_pMetrics->bytesRead += bytesRead;
+        }
+        LeaveCriticalSection(&m_lock);
+        if (bytesRead < 0) {
+            *pcbRead = 0;
+            return E_FAIL;
+        }
+        *pcbRead = static_cast<ULONG>(bytesRead);
+        return S_OK;
+    }
+    STDMETHODIMP BeginRead(BYTE *pb, ULONG cb, IMFAsyncCallback *pCallback, IUnknown *punkState)
+    {
+        ULONG bytesRead = 0;
+        HRESULT hrRead = Read(pb, cb, &bytesRead);
+        ReadResult *pReadResult = createReadResult(bytesRead);
+        if (!pReadResult) {
+            return E_OUTOFMEMORY;
+        }
+        IMFAsyncResult *pResult = NULL;
+        HRESULT hr = MFCreateAsyncResult(pReadResult, pCallback, punkState, &pResult);
+        pReadResult->Release();
+        if (FAILED(hr)) {
+            return hr;
+        }
+        pResult->SetStatus(hrRead);
+        hr = MFInvokeCallback(pResult);
+        pResult->Release();
+        return hr;
+    }
+    STDMETHODIMP EndRead(IMFAsyncResult *pResult, ULONG *pcbRead)
+    {
+        if (!pResult || !pcbRead) {
+            return E_INVALIDARG;
+        }
+        IUnknown *pObject = NULL;
+        HRESULT hr = pResult->GetObject(&pObject);
+        if (FAILED(hr)) {
+            return hr;
+        }
+        *pcbRead = static_cast<ReadResult*>(pObject)->m_bytesRead;
+        pObject->Release();
+        return pResult->GetStatus();
+    }
+    STDMETHODIMP Write(const BYTE *, ULONG, ULONG *) { return E_NOTIMPL; }
+    STDMETHODIMP BeginWrite(const BYTE *, ULONG, IMFAsyncCallback *, IUnknown *) { return E_NOTIMPL; }
+    STDMETHODIMP EndWrite(IMFAsyncResult *, ULONG *) { return E_NOTIMPL; }
+    STDMETHODIMP Seek(MFBYTESTREAM_SEEK_ORIGIN SeekOrigin, LONGLONG llSeekOffset,
+                      DWORD, QWORD *pqwCurrentPosition)
+    {
+        EnterCriticalSection(&m_lock);
+        LONGLONG position = SeekOrigin == msoCurrent ? m_position + llSeekOffset : llSeekOffset;
+        m_position = position < 0 ? 0 : position;
+        if (pqwCurrentPosition) {
+            *pqwCurrentPosition = m_position;
+        }
+        LeaveCriticalSection(&m_lock);
+        return S_OK;
+    }
+    STDMETHODIMP Flush() { return S_OK; }
+    STDMETHODIMP Close() { return S_OK; }
+
+    // IMFAttributes, all handed to m_pAttributes
+    STDMETHODIMP GetItem(REFGUID guidKey, PROPVARIANT *pValue) { return m_pAttributes->GetItem(guidKey, pValue); }
+    STDMETHODIMP GetItemType(REFGUID guidKey, MF_ATTRIBUTE_TYPE *pType) { return m_pAttributes->GetItemType(guidKey, pType); }
+    STDMETHODIMP CompareItem(REFGUID guidKey, REFPROPVARIANT Value, BOOL *pbResult) { return m_pAttributes->CompareItem(guidKey, Value, pbResult); }
+    STDMETHODIMP Compare(IMFAttributes *pTheirs, MF_ATTRIBUTES_MATCH_TYPE MatchType, BOOL *pbResult) { return m_pAttributes->Compare(pTheirs, MatchType, pbResult); }
+    STDMETHODIMP GetUINT32(REFGUID guidKey, UINT32 *punValue) { return m_pAttributes->GetUINT32(guidKey, punValue); }
+    STDMETHODIMP GetUINT64(REFGUID guidKey, UINT64 *punValue) { return m_pAttributes->GetUINT64(guidKey, punValue); }
+    STDMETHODIMP GetDouble(REFGUID guidKey, double *pfValue) { return m_pAttributes->GetDouble(guidKey, pfValue); }
+    STDMETHODIMP GetGUID(REFGUID guidKey, GUID *pguidValue) { return m_pAttributes->GetGUID(guidKey, pguidValue); }
+    STDMETHODIMP GetStringLength(REFGUID guidKey, UINT32 *pcchLength) { return m_pAttributes->GetStringLength(guidKey, pcchLength); }
+    STDMETHODIMP GetString(REFGUID guidKey, LPWSTR pwszValue, UINT32 cchBufSize, UINT32 *pcchLength) { return m_pAttributes->GetString(guidKey, pwszValue, cchBufSize, pcchLength); }
+    STDMETHODIMP GetAllocatedString(REFGUID guidKey, LPWSTR *ppwszValue, UINT32 *pcchLength) { return m_pAttributes->GetAllocatedString(guidKey, ppwszValue, pcchLength); }
+    STDMETHODIMP GetBlobSize(REFGUID guidKey, UINT32 *pcbBlobSize) { return m_pAttributes->GetBlobSize(guidKey, pcbBlobSize); }
+    STDMETHODIMP GetBlob(REFGUID guidKey, UINT8 *pBuf, UINT32 cbBufSize, UINT32 *pcbBlobSize) { return m_pAttributes->GetBlob(guidKey, pBuf, cbBufSize, pcbBlobSize); }
+    STDMETHODIMP GetAllocatedBlob(REFGUID guidKey, UINT8 **ppBuf, UINT32 *pcbSize) { return m_pAttributes->GetAllocatedBlob(guidKey, ppBuf, pcbSize); }
+    STDMETHODIMP GetUnknown(REFGUID guidKey, REFIID riid, LPVOID *ppv) { return m_pAttributes->GetUnknown(guidKey, riid, ppv); }
+    STDMETHODIMP SetItem(REFGUID guidKey, REFPROPVARIANT Value) { return m_pAttributes->SetItem(guidKey, Value); }
+    STDMETHODIMP DeleteItem(REFGUID guidKey) { return m_pAttributes->DeleteItem(guidKey); }
+    STDMETHODIMP DeleteAllItems() { return m_pAttributes->DeleteAllItems(); }
+    STDMETHODIMP SetUINT32(REFGUID guidKey, UINT32 unValue) { return m_pAttributes->SetUINT32(guidKey, unValue); }
+    STDMETHODIMP SetUINT64(REFGUID guidKey, UINT64 unValue) { return m_pAttributes->SetUINT64(guidKey, unValue); }
+    STDMETHODIMP SetDouble(REFGUID guidKey, double fValue) { return m_pAttributes->SetDouble(guidKey, fValue); }
+    STDMETHODIMP SetGUID(REFGUID guidKey, REFGUID guidValue) { return m_pAttributes->SetGUID(guidKey, guidValue); }
+    STDMETHODIMP SetString(REFGUID guidKey, LPCWSTR wszValue) { return m_pAttributes->SetString(guidKey, wszValue); }
+    STDMETHODIMP SetBlob(REFGUID guidKey, const UINT8 *pBuf, UINT32 cbBufSize) { return m_pAttributes->SetBlob(guidKey, pBuf, cbBufSize); }
+    STDMETHODIMP SetUnknown(REFGUID guidKey, IUnknown *pUnknown) { return m_pAttributes->SetUnknown(guidKey, pUnknown); }
+    STDMETHODIMP LockStore() { return m_pAttributes->LockStore(); }
+    STDMETHODIMP UnlockStore() { return m_pAttributes->UnlockStore(); }
+    STDMETHODIMP GetCount(UINT32 *pcItems) { return m_pAttributes->GetCount(pcItems); }
+    STDMETHODIMP GetItemByIndex(UINT32 unIndex, GUID *pguidKey, PROPVARIANT *pValue) { return m_pAttributes->GetItemByIndex(unIndex, pguidKey, pValue); }
+    STDMETHODIMP CopyAllItems(IMFAttributes *pDest) { return m_pAttributes->CopyAllItems(pDest); }
+
+private:
+    /** Carries the byte count of a BeginRead() over to EndRead(). Holds a
+        reference to the stream, which takes it back once it's released. */
+    class ReadResult : public IUnknown
+    {
+    public:
+        ReadResult(SourceByteStream *pOwner, ULONG bytesRead)
+        : m_bytesRead(bytesRead), m_pOwner(pOwner), m_refCount(1)
+        {
+            m_pOwner->AddRef();
+        }
+        STDMETHODIMP QueryInterface(REFIID riid, void **ppv)
+        {
+            if (riid != IID_IUnknown) {
+                *ppv = NULL;
+                return E_NOINTERFACE;
+            }
+            *ppv = this;
+            AddRef();
+            return S_OK;
+        }
+        STDMETHODIMP_(ULONG) AddRef() { return InterlockedIncrement(&m_refCount); }
+        STDMETHODIMP_(ULONG) Release()
+        {
+            ULONG count = InterlockedDecrement(&m_refCount);
+            if (count == 0) {
+                SourceByteStream *pOwner = m_pOwner;
+                pOwner->recycleReadResult(this);
+                pOwner->Release();
+            }
+            return count;
+        }
+        ULONG m_bytesRead;
+        SourceByteStream *m_pOwner;
+        long m_refCount;
+    };
+
+    SourceByteStream(AudioDecoderSource *source, AudioDecoderAllocator *allocator,
+                     AudioDecoderMetrics *metrics)
+    : m_refCount(1)
+    , m_pSource(source)
+    , m_position(0)
+    , m_pAttributes(NULL)
+    , m_pAllocator(allocator)
+    , m_pSpareResult(NULL)
+    , m_pMetrics(metrics)
+    {
+        InitializeCriticalSection(&m_lock);
+    }
+    ~SourceByteStream()
+    {
+        if (m_pSpareResult) {
+            m_pAllocator->deallocate(m_pSpareResult, sizeof(ReadResult));
+        }
+        safeRelease(&m_pAttributes);
+        DeleteCriticalSection(&m_lock);
+    }
+
+    ReadResult *createReadResult(ULONG bytesRead)
+    {
+        EnterCriticalSection(&m_lock);
+        void *memory = m_pSpareResult;
+        m_pSpareResult = NULL;
+        LeaveCriticalSection(&m_lock);
+        if (!memory) {
+            memory = m_pAllocator->allocate(sizeof(ReadResult));
+            if (!memory) {
+                return NULL;
+            }
+        }
+        return new (memory) ReadResult(this, bytesRead);
+    }
+    /** The source reader has one read in flight at a time, so a single
+        spare, allocated up front in create(), is all reading needs. */
+    void recycleReadResult(ReadResult *pResult)
+    {
+        pResult->~ReadResult();
+        void *memory = pResult;
+        EnterCriticalSection(&m_lock);
+        if (!m_pSpareResult) {
+            m_pSpareResult = memory;
+            memory = NULL;
+        }
+        LeaveCriticalSection(&m_lock);
+        if (memory) {
+            m_pAllocator->deallocate(memory, sizeof(ReadResult));
+        }
+    }
+
+    long m_refCount;
+    AudioDecoderSource *m_pSource;
+    QWORD m_position;
+    IMFAttributes *m_pAttributes;
+    AudioDecoderAllocator *m_pAllocator;
+    void *m_pSpareResult; // memory for a ReadResult, not constructed
+    AudioDecoderMetrics *m_pMetrics;
+    CRITICAL_SECTION m_lock;
+};
 
 
 AudioDecoderMediaFoundation::AudioDecoderMediaFoundation(const std::string filename)
     : AudioDecoderBase(filename)
     , m_pReader(NULL)
     , m_pAudioType(NULL)
-    , m_wcFilename(NULL)
     , m_nextFrame(0)
-    , m_leftoverBuffer(NULL)
-    , m_leftoverBufferSize(0)
-    , m_leftoverBufferLength(0)
-    , m_leftoverBufferPosition(0)
+    , m_pSample(NULL)
+    , m_pMBuffer(NULL)
+    , m_pBlock(NULL)
+    , m_blockFrames(0)
+    , m_blockOffset(0)
     , m_mfDuration(0)
-    , m_iCurrentPosition(0)
     , m_dead(false)
     , m_seeking(false)
+    , m_pViewBuffer(NULL)
+    , m_viewBufferSize(0)
+    , m_mfStarted(false)
+{
+    init();
+}
+
+AudioDecoderMediaFoundation::AudioDecoderMediaFoundation(AudioDecoderSource *source)
+    : AudioDecoderBase(source)
+    , m_pReader(NULL)
+    , m_pAudioType(NULL)
+    , m_nextFrame(0)
+    , m_pSample(NULL)
+    , m_pMBuffer(NULL)
+    , m_pBlock(NULL)
+    , m_blockFrames(0)
+    , m_blockOffset(0)
+    , m_mfDuration(0)
+    , m_dead(false)
+    , m_seeking(false)
+    , m_pViewBuffer(NULL)
+    , m_viewBufferSize(0)
+    , m_mfStarted(false)
+{
+    init();
+}
+
+void AudioDecoderMediaFoundation::init()
 {
     //Defaults
+    m_nextFrame = 0;
+    m_mfDuration = 0;
+    m_iPositionInSamples = 0;
+    m_dead = false;
+    m_seeking = false;
     m_iChannels = kNumChannels;
     m_iSampleRate = kSampleRate;
         m_iBitsPerSample = kBitsPerSample;
+    m_sampleFormat = AudioDecoderConvert::FORMAT_S16;
+    m_pConvert = AudioDecoderConvert::select(m_sampleFormat, m_iChannels);
+    m_bytesPerFrame = AudioDecoderConvert::bytesPerSample(m_sampleFormat) * m_iChannels;
 
     // http://social.msdn.microsoft.com/Forums/en/netfxbcl/thread/35c6a451-3507-40c8-9d1c-8d4edde7c0cc
-    // gives maximum path + file length as 248 + 260, using that -bkgood
-    m_wcFilename = new wchar_t[248 + 260];
+    // gives maximum path + file length as 248 + 260, hence m_wcFilename's size -bkgood
+    m_wcFilename[0] = 0;
 }
 
 AudioDecoderMediaFoundation::~AudioDecoderMediaFoundation()
 {
-    delete [] m_wcFilename;
-    delete [] m_leftoverBuffer;
+    close();
+    if (m_pViewBuffer) {
+        allocator()->deallocate(m_pViewBuffer, m_viewBufferSize * sizeof(SAMPLE));
+    }
+    if (m_mfStarted) {
+        MFShutdown();
+    }
+}
 
+void AudioDecoderMediaFoundation::close()
+{
+    comReadyOnThisThread(); // releasing the reader calls into it
+    releaseBlock();
     safeRelease(&m_pReader);
     safeRelease(&m_pAudioType);
-    MFShutdown();
-    if (!m_com_preinitialized) {
-        CoUninitialize();
-    }
 }
 
-int AudioDecoderMediaFoundation::open()
+/** Only the source reader is per file: Media Foundation and the
+    allocator's ReadResult recycling carry over to the next one. */
+int AudioDecoderMediaFoundation::reset(const std::string filename)
 {
-    if (sDebug) {
-        std::cout << "open() " << m_filename << std::endl;
-    }
+    close();
+    setInput(filename, NULL);
+    init();
+    return open();
+}
 
-    //Assumes m_filename is ASCII and converts it to UTF-16 (wide char).
-    /*
-        int wcFilenameLength = m_filename.size();
-        for(std::wstring::size_type i=0; i < m_filename.size(); ++i)
-        {
-                m_wcFilename[i] = m_filename[i];
-        }
-        m_wcFilename[wcFilenameLength] = (wchar_t)'\0';
+int AudioDecoderMediaFoundation::reset(AudioDecoderSource *source)
+{
+    close();
+    setInput(std::string(), source);
+    init();
+    return open();
+}
 
-        std::string s;
+int AudioDecoderMediaFoundation::open()
+{
+    AudioDecoderMetrics::Timer timer(m_metrics.openLatency);
+    AUDIODECODER_TRACE_SCOPE("decoder", "open");
+    AUDIODECODER_LOG(DEBUG, "open() %s", m_filename.c_str());
 
-        std::wstring stemp = s2ws(m_filename); // Temporary buffer is required
-        LPCWSTR result = (LPCWSTR)stemp.c_str();
-    */
-   
-    //LPCWSTR result; 
+    //Converts m_filename from UTF-8 to UTF-16 (wide char) in place, without
+    //going through a temporary std::wstring.
     const char* utf8Str = m_filename.c_str();
     MultiByteToWideChar(CP_UTF8, 
                         0, 
                         utf8Str, 
                         -1, //assume utf8Str is NULL terminated and give us back a NULL terminated string
                         (LPWSTR)m_wcFilename,
-                        512);
+                        sizeof(m_wcFilename) / sizeof(m_wcFilename[0]));
     
     LPCWSTR result = m_wcFilename;
 
     HRESULT hr(S_OK);
-    // Initialize the COM library.
-    /*
-    If COM is already initialized CoInitialize will either return
-    FALSE, or RPC_E_CHANGED_MODE if it was initialized in a different
-    threading mode. In either case we shouldn't consider it an error
-    but we need to be careful to not call CoUninitialize() if
-    RPC_E_CHANGED_MODE was returned.
-    */
-    hr = CoInitializeEx(NULL, COINIT_APARTMENTTHREADED | COINIT_DISABLE_OLE1DDE);
-    if (FAILED(hr) && (hr != RPC_E_CHANGED_MODE)) {
-        std::cerr << "SSMF: failed to initialize COM" << std::endl;
+    // COM per calling thread, which may not be the one that opened the last file.
+    if (!comReadyOnThisThread()) {
+        AUDIODECODER_LOG(ERROR, "SSMF: failed to initialize COM");
         return AUDIODECODER_ERROR;
     }
-    if (hr != RPC_E_CHANGED_MODE) {
-        m_com_preinitialized = true;
+    //Media Foundation is reference counted process-wide, so once per
+    //decoder, however many files reset() takes it through.
+    if (!m_mfStarted) {
+        hr = MFStartup(MF_VERSION);
+        if (FAILED(hr)) {
+            AUDIODECODER_LOG(ERROR, "SSMF: failed to initialize Media Foundation");
+            return AUDIODECODER_ERROR;
+        }
+        m_mfStarted = true;
     }
 
-    // Initialize the Media Foundation platform.
-    hr = MFStartup(MF_VERSION);
-    if (FAILED(hr)) {
-        std::cerr << "SSMF: failed to initialize Media Foundation" << std::endl;
-        return AUDIODECODER_ERROR;
+    // Create the source reader to read the input file, or our source.
+    if (m_pSource) {
+        SourceByteStream *pStream = NULL;
+        hr = SourceByteStream::create(m_pSource, allocator(), &m_metrics, &pStream);
+        if (SUCCEEDED(hr)) {
+            hr = MFCreateSourceReaderFromByteStream(pStream, NULL, &m_pReader);
+            pStream->Release(); // the reader holds its own reference
+        }
+    } else {
+        hr = MFCreateSourceReaderFromURL(/*m_wcFilename*/result, NULL, &m_pReader);
     }
-
-    // Create the source reader to read the input file.
-    hr = MFCreateSourceReaderFromURL(/*m_wcFilename*/result, NULL, &m_pReader);
     if (FAILED(hr)) {
-        std::cerr << "SSMF: Error opening input file:" << m_filename << ", with error: " << HRESULT_CODE(hr) << std::endl;
+        AUDIODECODER_LOG(ERROR, "SSMF: Error opening input file: %s, with error: %d",
+                         m_filename.c_str(), HRESULT_CODE(hr));
         return AUDIODECODER_ERROR;
     }
 
     if (!configureAudioStream()) {
-        std::cerr << "SSMF: Error configuring audio stream." << std::endl;
+        AUDIODECODER_LOG(ERROR, "SSMF: Error configuring audio stream.");
         return AUDIODECODER_ERROR;
     }
 
     if (!readProperties()) {
-        std::cerr << "SSMF::readProperties failed" << std::endl;
+        AUDIODECODER_LOG(ERROR, "SSMF::readProperties failed");
         return AUDIODECODER_ERROR;
     }
 
@@ -208,12 +576,29 @@ int AudioDecoderMediaFoundation::open()
     //get the number of samples it expects (ie. no header frames).
     seek(0);
 
+    //readView() converts 8, 24 and 32-bit blocks to float, a piece at a
+    //time. Get its buffer now so reading doesn't allocate.
+    const size_t viewSize = kViewFrames * m_iChannels;
+    if (m_sampleFormat != AudioDecoderConvert::FORMAT_S16 &&
+        m_sampleFormat != AudioDecoderConvert::FORMAT_F32 && m_viewBufferSize < viewSize) {
+        if (m_pViewBuffer) {
+            allocator()->deallocate(m_pViewBuffer, m_viewBufferSize * sizeof(SAMPLE));
+        }
+        m_pViewBuffer = static_cast<SAMPLE*>(allocator()->allocate(viewSize * sizeof(SAMPLE)));
+        m_viewBufferSize = m_pViewBuffer ? viewSize : 0;
+    }
+    beginSinks();
+
     return AUDIODECODER_OK;
 }
 
 int AudioDecoderMediaFoundation::seek(int sampleIdx)
 {
-    if (sDebug) { std::cout << "seek() " << sampleIdx << std::endl; }
+    AudioDecoderMetrics::Timer timer(m_metrics.seekLatency);
+    AUDIODECODER_TRACE_SCOPE("decoder", "seek");
+    comReadyOnThisThread();
+    m_metrics.seeks++;
+    AUDIODECODER_LOG(DEBUG, "seek() %d", sampleIdx);
     PROPVARIANT prop;
     HRESULT hr(S_OK);
     __int64 seekTarget(sampleIdx / m_iChannels);
@@ -223,7 +608,7 @@ int AudioDecoderMediaFoundation::seek(int sampleIdx)
     // enough for our calculatedFrameFromMF <= nextFrame assertion in ::read).
     // Has something to do with 100ns MF units being much smaller than most
     // frame offsets (in seconds) -bkgood
-    long result = m_iCurrentPosition;
+    long result = m_iPositionInSamples;
     if (m_dead) {
         return result;
     }
@@ -234,16 +619,17 @@ int AudioDecoderMediaFoundation::seek(int sampleIdx)
 
     hr = m_pReader->Flush(MF_SOURCE_READER_FIRST_AUDIO_STREAM);
     if (FAILED(hr)) {
-        std::cerr << "SSMF: failed to flush before seek";
+        AUDIODECODER_LOG(WARNING, "SSMF: failed to flush before seek");
     }
+    releaseBlock();
 
     // http://msdn.microsoft.com/en-us/library/dd374668(v=VS.85).aspx
     hr = m_pReader->SetCurrentPosition(GUID_NULL, prop);
     if (FAILED(hr)) {
         // nothing we can do here as we can't fail (no facility to other than
         // crashing mixxx)
-        std::cerr << "SSMF: failed to seek" << (
-            hr == MF_E_INVALIDREQUEST ? "Sample requests still pending" : "");
+        AUDIODECODER_LOG(WARNING, "SSMF: failed to seek%s",
+                         hr == MF_E_INVALIDREQUEST ? ": sample requests still pending" : "");
     } else {
         result = sampleIdx;
     }
@@ -253,221 +639,249 @@ int AudioDecoderMediaFoundation::seek(int sampleIdx)
     // time we get a buffer from MFSourceReader
     m_nextFrame = seekTarget;
     m_seeking = true;
-    m_iCurrentPosition = result;
+    m_iPositionInSamples = result;
+    seekSinks(result);
     return result;
 }
 
 int AudioDecoderMediaFoundation::read(int size, const SAMPLE *destination)
 {
-    assert(size < sizeof(m_destBufferShort));
-    if (sDebug) { std::cout << "read() " << size << std::endl; }
-    //TODO: Change this up if we want to support just short samples again -- Albert
-    SHORT_SAMPLE *destBuffer = m_destBufferShort;
-        size_t framesRequested(size / m_iChannels);
+    AudioDecoderMetrics::Timer timer(m_metrics.readLatency);
+    AUDIODECODER_TRACE_SCOPE("decoder", "read");
+    AUDIODECODER_LOG(DEBUG, "read() %d", size);
+    comReadyOnThisThread();
+    SAMPLE *destBuffer(const_cast<SAMPLE*>(destination));
+    const size_t framesRequested(size / m_iChannels);
     size_t framesNeeded(framesRequested);
 
-    // first, copy frames from leftover buffer IF the leftover buffer is at
-    // the correct frame
-    if (m_leftoverBufferLength > 0 && m_leftoverBufferPosition == m_nextFrame) {
-        copyFrames(destBuffer, &framesNeeded, m_leftoverBuffer,
-            m_leftoverBufferLength);
-        if (m_leftoverBufferLength > 0) {
-            if (framesNeeded != 0) {
-                std::cerr << __FILE__ << __LINE__
-                           << "WARNING: Expected frames needed to be 0. Abandoning this file.";
-                m_dead = true;
+    // Convert straight out of Media Foundation's decoded block into the
+    // caller's buffer. What's left of a block stays locked for the next
+    // read(), so there's no leftover buffer to copy through or grow, and
+    // no limit on the read size.
+    while (!m_dead && framesNeeded > 0) {
+        if (m_blockOffset >= m_blockFrames) {
+            releaseBlock();
+            if (!nextBlock(destBuffer + (framesRequested - framesNeeded) * m_iChannels,
+                           &framesNeeded)) {
+                break;
             }
-            m_leftoverBufferPosition += framesRequested;
+            continue;
         }
-    } else {
-        // leftoverBuffer already empty or in the wrong position, clear it
-        m_leftoverBufferLength = 0;
+        size_t frames = m_blockFrames - m_blockOffset;
+        if (frames > framesNeeded) {
+            frames = framesNeeded;
+        }
+        SAMPLE *dest = destBuffer + (framesRequested - framesNeeded) * m_iChannels;
+        m_pConvert(m_pBlock + m_blockOffset * m_bytesPerFrame, dest, frames, m_iChannels);
+        m_blockOffset += frames;
+        m_nextFrame += frames;
+        framesNeeded -= frames;
+        m_metrics.framesDecoded += frames;
     }
 
-    while (!m_dead && framesNeeded > 0) {
-        HRESULT hr(S_OK);
-        DWORD dwFlags(0);
-        __int64 timestamp(0);
-        IMFSample *pSample(NULL);
-        bool error(false); // set to true to break after releasing
+    long samples_read = size - framesNeeded * m_iChannels;
+    m_iPositionInSamples += samples_read;
+    AUDIODECODER_LOG(DEBUG, "read() %d returning %ld", size, samples_read);
+    notifySinks(destination, samples_read);
+    return samples_read;
+}
 
+/**
+ * Reads the next decoded block from the source reader and locks it. After a
+ * seek, blocks before the seek target are skipped, and if Media Foundation
+ * overshot the target a little, the gap is filled with silence at dest.
+ * readView() has nowhere to put silence and passes NULL for both, so it
+ * takes the overshoot as the new position instead.
+ * Returns false if decoding can't go on (end of stream or an error).
+ */
+bool AudioDecoderMediaFoundation::nextBlock(SAMPLE *dest, size_t *framesNeeded)
+{
+    HRESULT hr(S_OK);
+    DWORD dwFlags(0);
+    __int64 timestamp(0);
+
+    {
+        //One compressed frame's worth (or a few) through the codec.
+        AUDIODECODER_TRACE_SCOPE("codec", "ReadSample");
         hr = m_pReader->ReadSample(
             MF_SOURCE_READER_FIRST_AUDIO_STREAM, // [in] DWORD dwStreamIndex,
             0,                                   // [in] DWORD dwControlFlags,
             NULL,                                // [out] DWORD *pdwActualStreamIndex,
             &dwFlags,                            // [out] DWORD *pdwStreamFlags,
             &timestamp,                          // [out] LONGLONG *pllTimestamp,
-            &pSample);                           // [out] IMFSample **ppSample
-        if (FAILED(hr)) {
-            if (sDebug) { std::cout << "ReadSample failed." << std::endl; }
-            break;
-        }
-
-        if (sDebug) {
-            std::cout << "ReadSample timestamp: " << timestamp
-                     << "frame: " << frameFromMF(timestamp)
-                     << "dwflags: " << dwFlags
-                                         << std::endl;
-        }
-
-        if (dwFlags & MF_SOURCE_READERF_ERROR) {
-            // our source reader is now dead, according to the docs
-            std::cerr << "SSMF: ReadSample set ERROR, SourceReader is now dead";
-            m_dead = true;
-            break;
-        } else if (dwFlags & MF_SOURCE_READERF_ENDOFSTREAM) {
-            std::cout << "SSMF: End of input file." << std::endl;
-            break;
-        } else if (dwFlags & MF_SOURCE_READERF_CURRENTMEDIATYPECHANGED) {
-            std::cerr << "SSMF: Type change";
-            break;
-        } else if (pSample == NULL) {
-            // generally this will happen when dwFlags contains ENDOFSTREAM,
-            // so it'll be caught before now -bkgood
-            std::cerr << "SSMF: No sample";
-            continue;
-        } // we now own a ref to the instance at pSample
-
-        IMFMediaBuffer *pMBuffer(NULL);
-        // I know this does at least a memcopy and maybe a malloc, if we have
-        // xrun issues with this we might want to look into using
-        // IMFSample::GetBufferByIndex (although MS doesn't recommend this)
-        if (FAILED(hr = pSample->ConvertToContiguousBuffer(&pMBuffer))) {
-            error = true;
-            goto releaseSample;
-        }
-        short *buffer(NULL);
-        size_t bufferLength(0);
-        hr = pMBuffer->Lock(reinterpret_cast<unsigned __int8**>(&buffer), NULL,
-            reinterpret_cast<DWORD*>(&bufferLength));
-        if (FAILED(hr)) {
-            error = true;
-            goto releaseMBuffer;
-        }
-        bufferLength /= (m_iBitsPerSample / 8 * m_iChannels); // now in frames
-
-        if (m_seeking) {
-            __int64 bufferPosition(frameFromMF(timestamp));
-            if (sDebug) {
-                std::cout << "While seeking to "
-                         << m_nextFrame << "WMF put us at " << bufferPosition
-                                                 << std::endl;
+            &m_pSample);                         // [out] IMFSample **ppSample
+    }
+    if (FAILED(hr)) {
+        AUDIODECODER_LOG(DEBUG, "ReadSample failed.");
+        return false;
+    }
 
-            }
-            if (m_nextFrame < bufferPosition) {
-                // Uh oh. We are farther forward than our seek target. Emit
-                // silence? We can't seek backwards here.
-                SHORT_SAMPLE* pBufferCurpos = destBuffer +
-                        (size - framesNeeded * m_iChannels);
-                __int64 offshootFrames = bufferPosition - m_nextFrame;
-
-                // If we can correct this immediately, write zeros and adjust
-                // m_nextFrame to pretend it never happened.
-
-                if (offshootFrames <= framesNeeded) {
-                    std::cerr << __FILE__ << __LINE__
-                               << "Working around inaccurate seeking. Writing silence for"
-                               << offshootFrames << "frames";
-                    // Set offshootFrames * m_iChannels samples to zero.
-                    memset(pBufferCurpos, 0,
-                           sizeof(*pBufferCurpos) * offshootFrames *
-                           m_iChannels);
-                    // Now m_nextFrame == bufferPosition
-                    m_nextFrame += offshootFrames;
-                    framesNeeded -= offshootFrames;
-                } else {
-                    // It's more complicated. The buffer we have just decoded is
-                    // more than framesNeeded frames away from us. It's too hard
-                    // for us to handle this correctly currently, so let's just
-                    // try to get on with our lives.
-                    m_seeking = false;
-                    m_nextFrame = bufferPosition;
-                    std::cerr << __FILE__ << __LINE__
-                               << "Seek offshoot is too drastic. Cutting losses and pretending the current decoded audio buffer is the right seek point.";
-                }
-            }
+    AUDIODECODER_LOG(DEBUG, "ReadSample timestamp: %lld frame: %lld dwflags: %lu",
+                     static_cast<long long>(timestamp),
+                     static_cast<long long>(frameFromMF(timestamp)),
+                     static_cast<unsigned long>(dwFlags));
 
-            if (m_nextFrame >= bufferPosition &&
-                m_nextFrame < bufferPosition + bufferLength) {
-                // m_nextFrame is in this buffer.
-                buffer += (m_nextFrame - bufferPosition) * m_iChannels;
-                bufferLength -= m_nextFrame - bufferPosition;
-                m_seeking = false;
+    if (dwFlags & MF_SOURCE_READERF_ERROR) {
+        // our source reader is now dead, according to the docs
+        AUDIODECODER_LOG(ERROR, "SSMF: ReadSample set ERROR, SourceReader is now dead");
+        m_dead = true;
+        return false;
+    } else if (dwFlags & MF_SOURCE_READERF_ENDOFSTREAM) {
+        AUDIODECODER_LOG(DEBUG, "SSMF: End of input file.");
+        return false;
+    } else if (dwFlags & MF_SOURCE_READERF_CURRENTMEDIATYPECHANGED) {
+        AUDIODECODER_LOG(WARNING, "SSMF: Type change");
+        return false;
+    } else if (m_pSample == NULL) {
+        // generally this will happen when dwFlags contains ENDOFSTREAM,
+        // so it'll be caught before now -bkgood
+        AUDIODECODER_LOG(WARNING, "SSMF: No sample");
+        return true;
+    } // we now own a ref to the instance at m_pSample
+
+    // The source reader hands out single-buffer samples, for which this
+    // just returns a reference to that buffer rather than copying.
+    if (FAILED(hr = m_pSample->ConvertToContiguousBuffer(&m_pMBuffer))) {
+        return false;
+    }
+    BYTE *buffer(NULL);
+    DWORD bufferLength(0);
+    hr = m_pMBuffer->Lock(&buffer, NULL, &bufferLength);
+    if (FAILED(hr)) {
+        safeRelease(&m_pMBuffer);
+        return false;
+    }
+    m_pBlock = buffer;
+    m_blockFrames = bufferLength / m_bytesPerFrame;
+    m_blockOffset = 0;
+    m_metrics.bufferBytesHeld = bufferLength;
+
+    if (m_seeking) {
+        __int64 bufferPosition(frameFromMF(timestamp));
+        AUDIODECODER_LOG(DEBUG, "While seeking to %lld WMF put us at %lld",
+                         static_cast<long long>(m_nextFrame),
+                         static_cast<long long>(bufferPosition));
+        if (m_nextFrame < bufferPosition) {
+            // Uh oh. We are farther forward than our seek target. Emit
+            // silence? We can't seek backwards here.
+            __int64 offshootFrames = bufferPosition - m_nextFrame;
+            m_metrics.seekErrorFrames += offshootFrames;
+
+            // If we can correct this immediately, write zeros and adjust
+            // m_nextFrame to pretend it never happened.
+
+            if (framesNeeded && offshootFrames <= *framesNeeded) {
+                AUDIODECODER_LOG(INFO, "Working around inaccurate seeking. Writing silence for %lld frames",
+                                 static_cast<long long>(offshootFrames));
+                // Set offshootFrames * m_iChannels samples to zero.
+                memset(dest, 0, sizeof(*dest) * offshootFrames * m_iChannels);
+                // Now m_nextFrame == bufferPosition
+                m_nextFrame += offshootFrames;
+                *framesNeeded -= offshootFrames;
+                m_metrics.silencePaddedFrames += offshootFrames;
             } else {
-                // we need to keep going forward
-                goto releaseRawBuffer;
+                // It's more complicated. The buffer we have just decoded is
+                // more than framesNeeded frames away from us. It's too hard
+                // for us to handle this correctly currently, so let's just
+                // try to get on with our lives.
+                m_seeking = false;
+                m_nextFrame = bufferPosition;
+                AUDIODECODER_LOG(WARNING, "Seek offshoot is too drastic. Cutting losses and pretending "
+                                 "the current decoded audio buffer is the right seek point.");
             }
         }
 
-        // If the bufferLength is larger than the leftover buffer, re-allocate
-        // it with 2x the space.
-        if (bufferLength * m_iChannels > m_leftoverBufferSize) {
-            int newSize = m_leftoverBufferSize;
-
-            while (newSize < bufferLength * m_iChannels) {
-                newSize *= 2;
-            }
-            SHORT_SAMPLE* newBuffer = new SHORT_SAMPLE[newSize];
-            memcpy(newBuffer, m_leftoverBuffer,
-                   sizeof(m_leftoverBuffer[0]) * m_leftoverBufferSize);
-            delete [] m_leftoverBuffer;
-            m_leftoverBuffer = newBuffer;
-            m_leftoverBufferSize = newSize;
+        if (m_nextFrame >= bufferPosition &&
+            m_nextFrame < bufferPosition + static_cast<__int64>(m_blockFrames)) {
+            // m_nextFrame is in this buffer.
+            m_blockOffset = m_nextFrame - bufferPosition;
+            m_seeking = false;
+        } else {
+            // we need to keep going forward
+            releaseBlock();
         }
-        copyFrames(destBuffer + (size - framesNeeded * m_iChannels),
-            &framesNeeded, buffer, bufferLength);
+    }
+    return true;
+}
 
-releaseRawBuffer:
-        hr = pMBuffer->Unlock();
-        // I'm ignoring this, MSDN for IMFMediaBuffer::Unlock stipulates
+/** Unlocks and lets go of the block read() was working through. */
+void AudioDecoderMediaFoundation::releaseBlock()
+{
+    if (m_pMBuffer) {
+        // I'm ignoring the result, MSDN for IMFMediaBuffer::Unlock stipulates
         // nothing about the state of the instance if this fails so might as
         // well just let it be released.
-        //if (FAILED(hr)) break;
-releaseMBuffer:
-        safeRelease(&pMBuffer);
-releaseSample:
-        safeRelease(&pSample);
-        if (error) break;
-    }
-
-    m_nextFrame += framesRequested - framesNeeded;
-    if (m_leftoverBufferLength > 0) {
-        if (framesNeeded != 0) {
-            std::cerr << __FILE__ << __LINE__
-                                << "WARNING: Expected frames needed to be 0. Abandoning this file." << std::endl;
-            m_dead = true;
-        }
-        m_leftoverBufferPosition = m_nextFrame;
+        m_pMBuffer->Unlock();
+        safeRelease(&m_pMBuffer);
     }
-    long samples_read = size - framesNeeded * m_iChannels;
-    m_iCurrentPosition += samples_read;
-    if (sDebug) { std::cout << "read() " << size << " returning " << samples_read << std::endl; }
-        
-        const int sampleMax = 1 << (m_iBitsPerSample-1);
-        //Convert to float samples
-        if (m_iChannels == 2)
-        {
-                SAMPLE *destBufferFloat(const_cast<SAMPLE*>(destination));
-                for (unsigned long i = 0; i < samples_read; i++)
-                {
-                        destBufferFloat[i] = destBuffer[i] / (float)sampleMax;
-                }
-        }
-        else //Assuming mono, duplicate into stereo frames...
-        {
-                SAMPLE *destBufferFloat(const_cast<SAMPLE*>(destination));
-                for (unsigned long i = 0; i < samples_read; i++)
-                {
-                        destBufferFloat[i] = destBuffer[i] / (float)sampleMax;
-                }
-        }
-    return samples_read;
+    safeRelease(&m_pSample);
+    m_pBlock = NULL;
+    m_blockFrames = 0;
+    m_blockOffset = 0;
+    m_metrics.bufferBytesHeld = 0;
 }
 
-int AudioDecoderMediaFoundation::numSamples() const
+int AudioDecoderMediaFoundation::readView(AudioDecoderView *view)
 {
-    int len(secondsFromMF(m_mfDuration) * m_iSampleRate * m_iChannels);
-    return len % m_iChannels == 0 ? len : len + 1;
+    AudioDecoderMetrics::Timer timer(m_metrics.readLatency);
+    AUDIODECODER_TRACE_SCOPE("decoder", "readView");
+    comReadyOnThisThread();
+    view->data = NULL;
+    view->format = AudioDecoderView::FORMAT_INT16;
+    view->frames = 0;
+    view->channels = m_iChannels;
+    view->position = m_iPositionInSamples;
+    const bool convert = m_sampleFormat != AudioDecoderConvert::FORMAT_S16 &&
+                         m_sampleFormat != AudioDecoderConvert::FORMAT_F32;
+    if (convert && !m_pViewBuffer) {
+        return AUDIODECODER_ERROR;
+    }
+
+    while (!m_dead && m_blockOffset >= m_blockFrames) {
+        releaseBlock();
+        if (!nextBlock(NULL, NULL)) {
+            return 0;
+        }
+    }
+    if (m_dead) {
+        return 0;
+    }
+    // After a seek that overshot, nextBlock() moved m_nextFrame on to where
+    // the audio really starts, so the position follows it.
+    if (m_iPositionInSamples != m_nextFrame * m_iChannels) {
+        m_iPositionInSamples = m_nextFrame * m_iChannels;
+        seekSinks(m_iPositionInSamples);
+    }
+    view->position = m_iPositionInSamples;
+
+    if (convert) {
+        // 8, 24 and 32-bit integer blocks go out as float, through the view
+        // buffer, a piece of the block at a time.
+        size_t frames = m_blockFrames - m_blockOffset;
+        if (frames > m_viewBufferSize / m_iChannels) {
+            frames = m_viewBufferSize / m_iChannels;
+        }
+        m_pConvert(m_pBlock + m_blockOffset * m_bytesPerFrame, m_pViewBuffer, frames, m_iChannels);
+        view->data = m_pViewBuffer;
+        view->format = AudioDecoderView::FORMAT_FLOAT;
+        view->frames = static_cast<int>(frames);
+    } else {
+        // Lend out the rest of the locked block; it's released by the next call.
+        view->data = m_pBlock + m_blockOffset * m_bytesPerFrame;
+        view->format = m_sampleFormat == AudioDecoderConvert::FORMAT_F32 ? AudioDecoderView::FORMAT_FLOAT
+                                                                          : AudioDecoderView::FORMAT_INT16;
+        view->frames = m_blockFrames - m_blockOffset;
+    }
+    m_blockOffset += view->frames;
+    m_nextFrame += view->frames;
+    m_iPositionInSamples += view->size();
+    m_metrics.framesDecoded += view->frames;
+    if (view->format == AudioDecoderView::FORMAT_FLOAT) {
+        notifySinks(view->floats(), view->size());
+    } else {
+        notifySinks(view->shorts(), view->size());
+    }
+    return view->size();
 }
 
 std::vector<std::string> AudioDecoderMediaFoundation::supportedFileExtensions()
@@ -500,18 +914,19 @@ std::vector<std::string> AudioDecoderMediaFoundation::supportedFileExtensions()
     */
 bool AudioDecoderMediaFoundation::configureAudioStream()
 {
+    AUDIODECODER_TRACE_SCOPE("decoder", "configureAudioStream");
     HRESULT hr(S_OK);
 
     // deselect all streams, we only want the first
     hr = m_pReader->SetStreamSelection(MF_SOURCE_READER_ALL_STREAMS, false);
     if (FAILED(hr)) {
-        std::cerr << "SSMF: failed to deselect all streams";
+        AUDIODECODER_LOG(ERROR, "SSMF: failed to deselect all streams");
         return false;
     }
 
     hr = m_pReader->SetStreamSelection(MF_SOURCE_READER_FIRST_AUDIO_STREAM, true);
     if (FAILED(hr)) {
-        std::cerr << "SSMF: failed to select first audio stream";
+        AUDIODECODER_LOG(ERROR, "SSMF: failed to select first audio stream");
         return false;
     }
 
@@ -525,7 +940,7 @@ bool AudioDecoderMediaFoundation::configureAudioStream()
                                                                        0, //Index of the media type to retreive... (what does that even mean?)
                                                                        &m_pAudioType);
     if (FAILED(hr)) {
-        std::cerr << "SSMF: failed to retrieve completed media type";
+        AUDIODECODER_LOG(ERROR, "SSMF: failed to retrieve completed media type");
         return false;
     }
     UINT32 allSamplesIndependent = 0;
@@ -543,14 +958,10 @@ bool AudioDecoderMediaFoundation::configureAudioStream()
     hr = m_pAudioType->GetUINT32(MF_MT_AUDIO_NUM_CHANNELS, &numChannels);
     hr = m_pAudioType->GetUINT32(MF_MT_AUDIO_SAMPLES_PER_SECOND, &samplesPerSecond);
 
-    std::cout << "bitsPerSample: " << bitsPerSample << std::endl;
-    std::cout << "allSamplesIndependent: " << allSamplesIndependent << std::endl;
-    std::cout << "fixedSizeSamples: " << fixedSizeSamples << std::endl;
-    std::cout << "sampleSize: " << sampleSize << std::endl;
-    std::cout << "bitsPerSample: " << bitsPerSample << std::endl;
-    std::cout << "blockAlignment: " << blockAlignment << std::endl;
-    std::cout << "numChannels: " << numChannels << std::endl;
-    std::cout << "samplesPerSecond: " << samplesPerSecond << std::endl;
+    AUDIODECODER_LOG(DEBUG, "bitsPerSample: %u allSamplesIndependent: %u fixedSizeSamples: %u "
+                     "sampleSize: %u blockAlignment: %u numChannels: %u samplesPerSecond: %u",
+                     bitsPerSample, allSamplesIndependent, fixedSizeSamples, sampleSize,
+                     blockAlignment, numChannels, samplesPerSecond);
 
     m_iChannels = numChannels;
     m_iSampleRate = samplesPerSecond;
@@ -564,37 +975,37 @@ bool AudioDecoderMediaFoundation::configureAudioStream()
 
     hr = MFCreateMediaType(&m_pAudioType);
     if (FAILED(hr)) {
-        std::cerr << "SSMF: failed to create media type";
+        AUDIODECODER_LOG(ERROR, "SSMF: failed to create media type");
         return false;
     }
 
     hr = m_pAudioType->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Audio);
     if (FAILED(hr)) {
-        std::cerr << "SSMF: failed to set major type";
+        AUDIODECODER_LOG(ERROR, "SSMF: failed to set major type");
         return false;
     }
 
     hr = m_pAudioType->SetGUID(MF_MT_SUBTYPE, MFAudioFormat_PCM);
     if (FAILED(hr)) {
-        std::cerr << "SSMF: failed to set subtype";
+        AUDIODECODER_LOG(ERROR, "SSMF: failed to set subtype");
         return false;
     }
 /*
     hr = m_pAudioType->SetUINT32(MF_MT_ALL_SAMPLES_INDEPENDENT, true);
     if (FAILED(hr)) {
-        std::cerr << "SSMF: failed to set samples independent";
+        AUDIODECODER_LOG(ERROR, "SSMF: failed to set samples independent");
         return false;
     }
 
     hr = m_pAudioType->SetUINT32(MF_MT_FIXED_SIZE_SAMPLES, true);
     if (FAILED(hr)) {
-        std::cerr << "SSMF: failed to set fixed size samples";
+        AUDIODECODER_LOG(ERROR, "SSMF: failed to set fixed size samples");
         return false;
     }
 
     hr = m_pAudioType->SetUINT32(MF_MT_SAMPLE_SIZE, kLeftoverSize);
     if (FAILED(hr)) {
-        std::cerr << "SSMF: failed to set sample size";
+        AUDIODECODER_LOG(ERROR, "SSMF: failed to set sample size");
         return false;
     }
 
@@ -603,7 +1014,7 @@ bool AudioDecoderMediaFoundation::configureAudioStream()
     // chose to hide this rather useful tidbit here is beyond me -bkgood
     hr = m_pAudioType->SetUINT32(MF_MT_AUDIO_BITS_PER_SAMPLE, kBitsPerSample);
     if (FAILED(hr)) {
-        std::cerr << "SSMF: failed to set bits per sample";
+        AUDIODECODER_LOG(ERROR, "SSMF: failed to set bits per sample");
         return false;
     }
 
@@ -611,7 +1022,7 @@ bool AudioDecoderMediaFoundation::configureAudioStream()
     hr = m_pAudioType->SetUINT32(MF_MT_AUDIO_BLOCK_ALIGNMENT,
         numChannels * (kBitsPerSample / 8));
     if (FAILED(hr)) {
-        std::cerr << "SSMF: failed to set block alignment";
+        AUDIODECODER_LOG(ERROR, "SSMF: failed to set block alignment");
         return false;
     }
         */
@@ -620,7 +1031,7 @@ bool AudioDecoderMediaFoundation::configureAudioStream()
         //MediaFoundation will not convert between mono and stereo without a transform!
     hr = m_pAudioType->SetUINT32(MF_MT_AUDIO_NUM_CHANNELS, kNumChannels);
     if (FAILED(hr)) {
-        std::cerr << "SSMF: failed to set number of channels";
+        AUDIODECODER_LOG(ERROR, "SSMF: failed to set number of channels");
         return false;
     }
 
@@ -628,7 +1039,7 @@ bool AudioDecoderMediaFoundation::configureAudioStream()
         //MediaFoundation will not do samplerate conversion without a transform in the pipeline.
     hr = m_pAudioType->SetUINT32(MF_MT_AUDIO_SAMPLES_PER_SECOND, kSampleRate);
     if (FAILED(hr)) {
-        std::cerr << "SSMF: failed to set sample rate";
+        AUDIODECODER_LOG(ERROR, "SSMF: failed to set sample rate");
         return false;
     }
         */
@@ -644,7 +1055,7 @@ bool AudioDecoderMediaFoundation::configureAudioStream()
     // don't dangle.
     safeRelease(&m_pAudioType);
     if (FAILED(hr)) {
-        std::cerr << "SSMF: failed to set media type";
+        AUDIODECODER_LOG(ERROR, "SSMF: failed to set media type");
         return false;
     }
 
@@ -653,34 +1064,38 @@ bool AudioDecoderMediaFoundation::configureAudioStream()
         MF_SOURCE_READER_FIRST_AUDIO_STREAM,
         &m_pAudioType);
     if (FAILED(hr)) {
-        std::cerr << "SSMF: failed to retrieve completed media type";
+        AUDIODECODER_LOG(ERROR, "SSMF: failed to retrieve completed media type");
         return false;
     }
 
+    // PCM comes out at the file's own depth (we don't ask for 16 bits), so
+    // pick the converter for whatever the reader settled on. Until now
+    // read() took every block for 16-bit, which garbled 8, 24 and 32-bit WAVs.
+    UINT32 outputBits = 0;
+    GUID outputSubtype = GUID_NULL;
+    m_pAudioType->GetUINT32(MF_MT_AUDIO_BITS_PER_SAMPLE, &outputBits);
+    m_pAudioType->GetGUID(MF_MT_SUBTYPE, &outputSubtype);
+    if (outputBits != 0) {
+        m_iBitsPerSample = outputBits;
+    }
+    if (outputSubtype == MFAudioFormat_Float && m_iBitsPerSample == 32) {
+        m_sampleFormat = AudioDecoderConvert::FORMAT_F32;
+    } else if (!AudioDecoderConvert::formatForBits(m_iBitsPerSample, &m_sampleFormat)) {
+        AUDIODECODER_LOG(ERROR, "SSMF: can't convert %u-bit samples", m_iBitsPerSample);
+        return false;
+    }
+    m_pConvert = AudioDecoderConvert::select(m_sampleFormat, m_iChannels);
+    m_bytesPerFrame = AudioDecoderConvert::bytesPerSample(m_sampleFormat) * m_iChannels;
+
     // Ensure the stream is selected.
     hr = m_pReader->SetStreamSelection(
         MF_SOURCE_READER_FIRST_AUDIO_STREAM,
         true);
     if (FAILED(hr)) {
-        std::cerr << "SSMF: failed to select first audio stream (again)";
+        AUDIODECODER_LOG(ERROR, "SSMF: failed to select first audio stream (again)");
         return false;
     }
 
-    // this may not be safe on all platforms as m_leftoverBufferSize is a
-    // size_t and this function is writing a uint32. However, on 32-bit
-    // Windows 7, size_t is defined as uint which is 32-bits, so we're safe
-    // for all supported platforms -bkgood
-    UINT32 leftoverBufferSize = 0;
-    hr = m_pAudioType->GetUINT32(MF_MT_SAMPLE_SIZE, &leftoverBufferSize);
-    if (FAILED(hr)) {
-        std::cerr << "SSMF: failed to get buffer size";
-        leftoverBufferSize = 32;
-       // return false;
-    }
-    m_leftoverBufferSize = static_cast<size_t>(leftoverBufferSize);
-    m_leftoverBufferSize /= 2; // convert size in bytes to size in int16s
-    m_leftoverBuffer = new short[m_leftoverBufferSize];
-
     return true;
 }
 
@@ -693,7 +1108,7 @@ bool AudioDecoderMediaFoundation::readProperties()
     hr = m_pReader->GetPresentationAttribute(MF_SOURCE_READER_MEDIASOURCE,
         MF_PD_DURATION, &prop);
     if (FAILED(hr)) {
-        std::cerr << "SSMF: error getting duration";
+        AUDIODECODER_LOG(ERROR, "SSMF: error getting duration");
         return false;
     }
     // QuadPart isn't available on compilers that don't support _int64. Visual
@@ -701,9 +1116,31 @@ bool AudioDecoderMediaFoundation::readProperties()
     // -bkgood
     m_fDuration = secondsFromMF(prop.hVal.QuadPart);
     m_mfDuration = prop.hVal.QuadPart;
-    std::cout << "SSMF: Duration: " << m_fDuration << std::endl;
+    AUDIODECODER_LOG(DEBUG, "SSMF: Duration: %f", m_fDuration);
     PropVariantClear(&prop);
 
+    // MF's duration is in 100 ns units, which don't fall on samples, and for
+    // a VBR MP3 it's only an estimate. We use it unless the MP3 has a
+    // Xing/Info or VBRI header, which gives the exact number of frames.
+    // Media Foundation doesn't trim the encoder delay and padding, so those
+    // are added back to that count.
+    m_iNumSamples = static_cast<int>(secondsFromMF(m_mfDuration) * m_iSampleRate + 0.5) * m_iChannels;
+    IMFMediaType *pNativeType = NULL;
+    GUID nativeSubtype = GUID_NULL;
+    if (SUCCEEDED(m_pReader->GetNativeMediaType(MF_SOURCE_READER_FIRST_AUDIO_STREAM, 0, &pNativeType))) {
+        pNativeType->GetGUID(MF_MT_SUBTYPE, &nativeSubtype);
+        safeRelease(&pNativeType);
+    }
+    AudioStreamInfo info;
+    if (nativeSubtype == MFAudioFormat_MP3 &&
+        (m_pSource ? AudioDecoderProbe::probe(m_pSource, &info)
+                   : AudioDecoderProbe::probe(m_filename, &info)) == AUDIODECODER_OK &&
+        info.lengthIsExact && info.sampleRate == m_iSampleRate && info.channels == m_iChannels) {
+        m_iNumSamples = info.numSamples + (info.encoderDelay + info.encoderPadding) * m_iChannels;
+        m_fDuration = static_cast<float>(m_iNumSamples / m_iChannels) / m_iSampleRate;
+        AUDIODECODER_LOG(DEBUG, "SSMF: MP3 headers give %d samples", m_iNumSamples);
+    }
+
     // presentation attribute MF_PD_AUDIO_ENCODING_BITRATE only exists for
     // presentation descriptors, one of which MFSourceReader is not.
     // Therefore, we calculate it ourselves.
@@ -713,33 +1150,6 @@ bool AudioDecoderMediaFoundation::readProperties()
     return true;
 }
 
-/**
- * Copies min(destFrames, srcFrames) frames to dest from src. Anything leftover
- * is moved to the beginning of m_leftoverBuffer, so empty it first (possibly
- * with this method). If src and dest overlap, I'll hurt you.
- */
-void AudioDecoderMediaFoundation::copyFrames(
-    short *dest, size_t *destFrames, const short *src, size_t srcFrames)
-{
-    if (srcFrames > *destFrames) {
-        int samplesToCopy(*destFrames * m_iChannels);
-        memcpy(dest, src, samplesToCopy * sizeof(*src));
-        srcFrames -= *destFrames;
-        memmove(m_leftoverBuffer,
-            src + samplesToCopy,
-            srcFrames * m_iChannels * sizeof(*src));
-        *destFrames = 0;
-        m_leftoverBufferLength = srcFrames;
-    } else {
-        int samplesToCopy(srcFrames * m_iChannels);
-        memcpy(dest, src, samplesToCopy * sizeof(*src));
-        *destFrames -= srcFrames;
-        if (src == m_leftoverBuffer) {
-            m_leftoverBufferLength = 0;
-        }
-    }
-}
-
 /**
  * Convert a 100ns Media Foundation value to a number of seconds.
  */
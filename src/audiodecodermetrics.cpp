@@ -0,0 +1,250 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+#include <stdio.h>
+#include <mutex>
+#include <vector>
+#include "audiodecodermetrics.h"
+
+AudioDecoderLatencyHistogram::AudioDecoderLatencyHistogram()
+: m_count(0)
+, m_sum(0)
+{
+    for (int i = 0; i < kBuckets; i++) {
+        m_buckets[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void AudioDecoderLatencyHistogram::record(long long microseconds)
+{
+    int i = 0;
+    for (unsigned long long v = microseconds > 0 ? microseconds : 0; v > 0 && i < kBuckets - 1; v >>= 1) {
+        i++;
+    }
+    m_buckets[i].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(microseconds, std::memory_order_relaxed);
+}
+
+static void copyHistogram(const AudioDecoderLatencyHistogram& from,
+                          AudioDecoderMetricsSnapshot::Histogram *to)
+{
+    for (int i = 0; i < AudioDecoderLatencyHistogram::kBuckets; i++) {
+        to->buckets[i] = from.bucket(i);
+    }
+    to->count = from.count();
+    to->sumMicroseconds = from.sumMicroseconds();
+}
+
+static void addHistogram(const AudioDecoderMetricsSnapshot::Histogram& from,
+                         AudioDecoderMetricsSnapshot::Histogram *to)
+{
+    for (int i = 0; i < AudioDecoderLatencyHistogram::kBuckets; i++) {
+        to->buckets[i] += from.buckets[i];
+    }
+    to->count += from.count;
+    to->sumMicroseconds += from.sumMicroseconds;
+}
+
+long long AudioDecoderMetricsSnapshot::Histogram::percentile(double p) const
+{
+    const long long rank = static_cast<long long>(p * count);
+    long long seen = 0;
+    for (int i = 0; i < AudioDecoderLatencyHistogram::kBuckets; i++) {
+        seen += buckets[i];
+        if (seen > rank) {
+            return AudioDecoderLatencyHistogram::bucketLimit(i);
+        }
+    }
+    return count > 0 ? AudioDecoderLatencyHistogram::bucketLimit(AudioDecoderLatencyHistogram::kBuckets - 1) : 0;
+}
+
+AudioDecoderMetricsSnapshot::AudioDecoderMetricsSnapshot()
+: decoders(0)
+, framesDecoded(0)
+, bytesRead(0)
+, seeks(0)
+, seekErrorFrames(0)
+, silencePaddedFrames(0)
+, bufferBytesHeld(0)
+{
+    Histogram empty = Histogram();
+    openLatency = seekLatency = readLatency = empty;
+}
+
+AudioDecoderMetricsSnapshot& AudioDecoderMetricsSnapshot::operator+=(const AudioDecoderMetricsSnapshot& other)
+{
+    decoders += other.decoders;
+    framesDecoded += other.framesDecoded;
+    bytesRead += other.bytesRead;
+    seeks += other.seeks;
+    seekErrorFrames += other.seekErrorFrames;
+    silencePaddedFrames += other.silencePaddedFrames;
+    bufferBytesHeld += other.bufferBytesHeld;
+    addHistogram(other.openLatency, &openLatency);
+    addHistogram(other.seekLatency, &seekLatency);
+    addHistogram(other.readLatency, &readLatency);
+    return *this;
+}
+
+//-------------------------------------------------------------------
+// The process-wide total: the live decoders, plus what the ones that
+// have gone had counted. Only constructing, destroying and snapshotting
+// take the lock; the decoders themselves never do.
+//-------------------------------------------------------------------
+
+struct MetricsRegistry
+{
+    std::mutex lock;
+    std::vector<const AudioDecoderMetrics*> live;
+    AudioDecoderMetricsSnapshot retired;
+};
+
+static MetricsRegistry& registry()
+{
+    static MetricsRegistry s_registry;
+    return s_registry;
+}
+
+AudioDecoderMetrics::AudioDecoderMetrics()
+: framesDecoded(0)
+, bytesRead(0)
+, seeks(0)
+, seekErrorFrames(0)
+, silencePaddedFrames(0)
+, bufferBytesHeld(0)
+{
+    MetricsRegistry& r = registry();
+    std::lock_guard<std::mutex> locker(r.lock);
+    r.live.push_back(this);
+}
+
+AudioDecoderMetrics::~AudioDecoderMetrics()
+{
+    AudioDecoderMetricsSnapshot last = snapshot();
+    last.decoders = 0;
+    last.bufferBytesHeld = 0;
+    MetricsRegistry& r = registry();
+    std::lock_guard<std::mutex> locker(r.lock);
+    for (size_t i = 0; i < r.live.size(); i++) {
+        if (r.live[i] == this) {
+            r.live[i] = r.live.back();
+            r.live.pop_back();
+            break;
+        }
+    }
+    r.retired += last;
+}
+
+AudioDecoderMetricsSnapshot AudioDecoderMetrics::snapshot() const
+{
+    AudioDecoderMetricsSnapshot s;
+    s.decoders = 1;
+    s.framesDecoded = framesDecoded.load(std::memory_order_relaxed);
+    s.bytesRead = bytesRead.load(std::memory_order_relaxed);
+    s.seeks = seeks.load(std::memory_order_relaxed);
+    s.seekErrorFrames = seekErrorFrames.load(std::memory_order_relaxed);
+    s.silencePaddedFrames = silencePaddedFrames.load(std::memory_order_relaxed);
+    s.bufferBytesHeld = bufferBytesHeld.load(std::memory_order_relaxed);
+    copyHistogram(openLatency, &s.openLatency);
+    copyHistogram(seekLatency, &s.seekLatency);
+    copyHistogram(readLatency, &s.readLatency);
+    return s;
+}
+
+AudioDecoderMetricsSnapshot AudioDecoderMetrics::processSnapshot()
+{
+    MetricsRegistry& r = registry();
+    std::lock_guard<std::mutex> locker(r.lock);
+    AudioDecoderMetricsSnapshot total = r.retired;
+    for (size_t i = 0; i < r.live.size(); i++) {
+        total += r.live[i]->snapshot();
+    }
+    return total;
+}
+
+static void appendMetric(std::string *out, const char *name, const char *type,
+                         const char *help, long long value)
+{
+    char line[256];
+    snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s %s\n%s %lld\n",
+             name, help, name, type, name, value);
+    *out += line;
+}
+
+static void appendHistogram(std::string *out, const char *name, const char *help,
+                            const AudioDecoderMetricsSnapshot::Histogram& h)
+{
+    char line[256];
+    snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s histogram\n", name, help, name);
+    *out += line;
+    long long cumulative = 0;
+    for (int i = 0; i < AudioDecoderLatencyHistogram::kBuckets - 1; i++) {
+        cumulative += h.buckets[i];
+        snprintf(line, sizeof(line), "%s_bucket{le=\"%g\"} %lld\n", name,
+                 AudioDecoderLatencyHistogram::bucketLimit(i) / 1e6, cumulative);
+        *out += line;
+    }
+    snprintf(line, sizeof(line), "%s_bucket{le=\"+Inf\"} %lld\n%s_sum %.6f\n%s_count %lld\n",
+             name, h.count, name, h.sumMicroseconds / 1e6, name, h.count);
+    *out += line;
+}
+
+std::string AudioDecoderMetrics::prometheusText()
+{
+    const AudioDecoderMetricsSnapshot s = processSnapshot();
+    std::string out;
+    appendMetric(&out, "audiodecoder_decoders", "gauge",
+                 "Decoders currently alive.", s.decoders);
+    appendMetric(&out, "audiodecoder_frames_decoded_total", "counter",
+                 "Frames returned by read() and readView().", s.framesDecoded);
+    appendMetric(&out, "audiodecoder_bytes_read_total", "counter",
+                 "Bytes read from AudioDecoderSources.", s.bytesRead);
+    appendMetric(&out, "audiodecoder_seeks_total", "counter",
+                 "Calls to seek().", s.seeks);
+    appendMetric(&out, "audiodecoder_seek_error_frames_total", "counter",
+                 "Frames by which seeks missed their target.", s.seekErrorFrames);
+    appendMetric(&out, "audiodecoder_silence_padded_frames_total", "counter",
+                 "Silent frames inserted after seeks that overshot.", s.silencePaddedFrames);
+    appendMetric(&out, "audiodecoder_buffer_bytes_held", "gauge",
+                 "Decoded audio held by decoders between calls.", s.bufferBytesHeld);
+    appendHistogram(&out, "audiodecoder_open_duration_seconds", "Time spent in open().", s.openLatency);
+    appendHistogram(&out, "audiodecoder_seek_duration_seconds", "Time spent in seek().", s.seekLatency);
+    appendHistogram(&out, "audiodecoder_read_duration_seconds", "Time spent in read() and readView().", s.readLatency);
+    return out;
+}
@@ -0,0 +1,408 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define PEAKS_USE_SSE
+#endif
+#include "audiodecoderpeakpyramid.h"
+
+// File layout (native byte order, flagged by kByteOrderMark):
+//   header     "ADPK", version, byte order mark, channels, sample rate,
+//              number of levels (u32 each), number of frames (u64)
+//   level[n]   frames per bin (u32), reserved (u32), bins (u64), data offset (u64)
+//   data       per level, channels * 3 int16 per bin
+const char kMagic[4] = { 'A', 'D', 'P', 'K' };
+const unsigned int kVersion = 1;
+const unsigned int kByteOrderMark = 0x01020304;
+const int kHeaderSize = 32;
+const int kLevelEntrySize = 24;
+
+/** Min, max and sum of squares of a run of interleaved frames, per channel. */
+static void reduceFrames(const SAMPLE *samples, int frames, int channels,
+                         float *mins, float *maxs, double *sumSquares)
+{
+    int i = 0;
+    const int count = frames * channels;
+#ifdef PEAKS_USE_SSE
+    //With 1, 2 or 4 channels, lane k of every group of four always holds channel k % channels.
+    if (4 % channels == 0 && count >= 4) {
+        __m128 vmin = _mm_set1_ps(FLT_MAX);
+        __m128 vmax = _mm_set1_ps(-FLT_MAX);
+        __m128 vsquares = _mm_setzero_ps();
+        for (; i + 4 <= count; i += 4) {
+            __m128 v = _mm_loadu_ps(samples + i);
+            vmin = _mm_min_ps(vmin, v);
+            vmax = _mm_max_ps(vmax, v);
+            vsquares = _mm_add_ps(vsquares, _mm_mul_ps(v, v));
+        }
+        float lanes[3][4];
+        _mm_storeu_ps(lanes[0], vmin);
+        _mm_storeu_ps(lanes[1], vmax);
+        _mm_storeu_ps(lanes[2], vsquares);
+        for (int lane = 0; lane < 4; lane++) {
+            const int channel = lane % channels;
+            mins[channel] = lanes[0][lane] < mins[channel] ? lanes[0][lane] : mins[channel];
+            maxs[channel] = lanes[1][lane] > maxs[channel] ? lanes[1][lane] : maxs[channel];
+            sumSquares[channel] += lanes[2][lane];
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        const int channel = i % channels;
+        const float v = samples[i];
+        mins[channel] = v < mins[channel] ? v : mins[channel];
+        maxs[channel] = v > maxs[channel] ? v : maxs[channel];
+        sumSquares[channel] += v * v;
+    }
+}
+
+static short quantize(double value)
+{
+    if (value > 1.0) value = 1.0;
+    if (value < -1.0) value = -1.0;
+    return static_cast<short>(floor(value * 32767.0 + 0.5));
+}
+
+AudioDecoderPeakPyramid::AudioDecoderPeakPyramid(const std::vector<int>& framesPerBin)
+: m_iChannels(0)
+, m_iSampleRate(0)
+, m_position(0)
+, m_numFrames(0)
+{
+    std::vector<int> sizes(framesPerBin);
+    bool valid = !sizes.empty();
+    for (size_t i = 0; i < sizes.size(); i++) {
+        if (sizes[i] <= 0 || (i > 0 && sizes[i] % sizes[i - 1] != 0)) {
+            valid = false;
+        }
+    }
+    if (!valid) {
+        sizes.clear();
+        sizes.push_back(64);
+        sizes.push_back(512);
+        sizes.push_back(4096);
+    }
+    m_levels.resize(sizes.size());
+    for (size_t i = 0; i < sizes.size(); i++) {
+        m_levels[i].framesPerBin = sizes[i];
+    }
+}
+
+void AudioDecoderPeakPyramid::begin(int channels, int sampleRate)
+{
+    m_iChannels = channels;
+    m_iSampleRate = sampleRate;
+    m_position = 0;
+    m_numFrames = 0;
+    for (size_t i = 0; i < m_levels.size(); i++) {
+        Level& level = m_levels[i];
+        level.min.assign(channels, 0);
+        level.max.assign(channels, 0);
+        level.sumSquares.assign(channels, 0);
+        level.bins.clear();
+        level.partial.clear();
+        level.binIndex = 0;
+        resetBin(level);
+    }
+}
+
+void AudioDecoderPeakPyramid::resetBin(Level& level)
+{
+    level.framesInBin = 0;
+    level.binIsPartial = false;
+    for (int c = 0; c < m_iChannels; c++) {
+        level.min[c] = FLT_MAX;
+        level.max[c] = -FLT_MAX;
+        level.sumSquares[c] = 0;
+    }
+}
+
+void AudioDecoderPeakPyramid::process(const SAMPLE *buffer, int size)
+{
+    if (m_iChannels <= 0 || m_levels.empty()) {
+        return;
+    }
+    Level& finest = m_levels[0];
+    int frames = size / m_iChannels;
+    while (frames > 0) {
+        const long long binEnd = (finest.binIndex + 1) * finest.framesPerBin;
+        int chunk = static_cast<int>(binEnd - m_position);
+        if (chunk > frames) {
+            chunk = frames;
+        }
+        reduceFrames(buffer, chunk, m_iChannels, &finest.min[0], &finest.max[0],
+                     &finest.sumSquares[0]);
+        finest.framesInBin += chunk;
+        m_position += chunk;
+        buffer += chunk * m_iChannels;
+        frames -= chunk;
+        if (m_position == binEnd) {
+            emitBin(0);
+        }
+    }
+    if (m_position > m_numFrames) {
+        m_numFrames = m_position;
+    }
+}
+
+/** Stores the bin being filled at a level and folds it into the next level up. */
+void AudioDecoderPeakPyramid::emitBin(int levelIndex)
+{
+    Level& level = m_levels[levelIndex];
+    if (level.framesInBin == 0) {
+        return;
+    }
+    const size_t offset = static_cast<size_t>(level.binIndex) * m_iChannels * 3;
+    if (level.bins.size() < offset + m_iChannels * 3) {
+        level.bins.resize(offset + m_iChannels * 3, 0);
+        level.partial.resize(static_cast<size_t>(level.binIndex) + 1, false);
+    }
+    for (int c = 0; c < m_iChannels; c++) {
+        level.bins[offset + c * 3] = quantize(level.min[c]);
+        level.bins[offset + c * 3 + 1] = quantize(level.max[c]);
+        level.bins[offset + c * 3 + 2] = quantize(sqrt(level.sumSquares[c] / level.framesInBin));
+    }
+    level.partial[static_cast<size_t>(level.binIndex)] = level.binIsPartial;
+
+    if (levelIndex + 1 < static_cast<int>(m_levels.size())) {
+        Level& parent = m_levels[levelIndex + 1];
+        for (int c = 0; c < m_iChannels; c++) {
+            parent.min[c] = level.min[c] < parent.min[c] ? level.min[c] : parent.min[c];
+            parent.max[c] = level.max[c] > parent.max[c] ? level.max[c] : parent.max[c];
+            parent.sumSquares[c] += level.sumSquares[c];
+        }
+        parent.framesInBin += level.framesInBin;
+        if (m_position >= (parent.binIndex + 1) * parent.framesPerBin) {
+            emitBin(levelIndex + 1);
+        }
+    }
+
+    //A bin the decode has got to the end of moves us on; one that was cut
+    //short (finish or seek) stays put.
+    if (m_position >= (level.binIndex + 1) * level.framesPerBin) {
+        level.binIndex++;
+    }
+    resetBin(level);
+}
+
+void AudioDecoderPeakPyramid::seeked(int sampleIdx)
+{
+    if (m_iChannels <= 0) {
+        return;
+    }
+    const long long frame = sampleIdx / m_iChannels;
+    if (frame == m_position) {
+        return; // nothing skipped, so the bins carry on as they were
+    }
+    //Finest level first, so a bin that's left behind reaches its parent
+    //before the parent is looked at.
+    for (size_t i = 0; i < m_levels.size(); i++) {
+        Level& level = m_levels[i];
+        const long long bin = frame / level.framesPerBin;
+        if (bin == level.binIndex && frame > m_position) {
+            //Forward within the bin: what it has so far still belongs in it.
+            level.binIsPartial = true;
+            continue;
+        }
+        if (bin == level.binIndex) {
+            //Back within the bin: those frames will come again, so start over.
+            resetBin(level);
+        } else {
+            //Store what the old bin got, and start the new one empty.
+            level.binIsPartial = true;
+            emitBin(static_cast<int>(i));
+            level.binIndex = bin;
+        }
+        level.binIsPartial = frame % level.framesPerBin != 0;
+    }
+    m_position = frame;
+}
+
+void AudioDecoderPeakPyramid::finish()
+{
+    //Flush from the finest level up, so each partial bin reaches its parent.
+    for (size_t i = 0; i < m_levels.size(); i++) {
+        emitBin(static_cast<int>(i));
+    }
+}
+
+long long AudioDecoderPeakPyramid::numBins(int level) const
+{
+    return m_iChannels > 0 ? static_cast<long long>(m_levels[level].bins.size()) / (m_iChannels * 3) : 0;
+}
+
+const short *AudioDecoderPeakPyramid::bins(int level) const
+{
+    return m_levels[level].bins.empty() ? NULL : &m_levels[level].bins[0];
+}
+
+bool AudioDecoderPeakPyramid::isPartial(int level, long long bin) const
+{
+    const std::vector<bool>& partial = m_levels[level].partial;
+    return bin >= 0 && bin < static_cast<long long>(partial.size()) && partial[static_cast<size_t>(bin)];
+}
+
+static void putU32(unsigned char *p, unsigned int value) { memcpy(p, &value, 4); }
+static void putU64(unsigned char *p, unsigned long long value) { memcpy(p, &value, 8); }
+static unsigned int getU32(const unsigned char *p) { unsigned int v; memcpy(&v, p, 4); return v; }
+static unsigned long long getU64(const unsigned char *p) { unsigned long long v; memcpy(&v, p, 8); return v; }
+
+int AudioDecoderPeakPyramid::save(const std::string filename)
+{
+    finish();
+    std::vector<unsigned char> header(kHeaderSize + kLevelEntrySize * m_levels.size());
+    memcpy(&header[0], kMagic, 4);
+    putU32(&header[4], kVersion);
+    putU32(&header[8], kByteOrderMark);
+    putU32(&header[12], m_iChannels);
+    putU32(&header[16], m_iSampleRate);
+    putU32(&header[20], static_cast<unsigned int>(m_levels.size()));
+    putU64(&header[24], m_numFrames);
+    unsigned long long dataOffset = header.size();
+    for (size_t i = 0; i < m_levels.size(); i++) {
+        unsigned char *entry = &header[kHeaderSize + kLevelEntrySize * i];
+        putU32(entry, m_levels[i].framesPerBin);
+        putU32(entry + 4, 0);
+        putU64(entry + 8, numBins(static_cast<int>(i)));
+        putU64(entry + 16, dataOffset);
+        dataOffset += m_levels[i].bins.size() * sizeof(short);
+    }
+
+    FILE *file = fopen(filename.c_str(), "wb");
+    if (!file) {
+        return AUDIODECODER_ERROR;
+    }
+    bool ok = fwrite(&header[0], 1, header.size(), file) == header.size();
+    for (size_t i = 0; ok && i < m_levels.size(); i++) {
+        const std::vector<short>& bins = m_levels[i].bins;
+        ok = bins.empty() || fwrite(&bins[0], sizeof(short), bins.size(), file) == bins.size();
+    }
+    ok = fclose(file) == 0 && ok;
+    return ok ? AUDIODECODER_OK : AUDIODECODER_ERROR;
+}
+
+//-------------------------------------------------------------------
+// AudioDecoderPeakFile
+//-------------------------------------------------------------------
+
+AudioDecoderPeakFile::AudioDecoderPeakFile(const std::string filename)
+: m_source(filename)
+, m_pData(static_cast<const unsigned char*>(m_source.mapView()))
+, m_iChannels(0)
+, m_iSampleRate(0)
+, m_iNumLevels(0)
+, m_numFrames(0)
+{
+    const long long size = m_source.size();
+    if (!m_pData || size < kHeaderSize || memcmp(m_pData, kMagic, 4) != 0 ||
+        getU32(m_pData + 4) != kVersion || getU32(m_pData + 8) != kByteOrderMark) {
+        return;
+    }
+    const int numLevels = static_cast<int>(getU32(m_pData + 20));
+    m_iChannels = static_cast<int>(getU32(m_pData + 12));
+    if (m_iChannels <= 0 || kHeaderSize + static_cast<long long>(kLevelEntrySize) * numLevels > size) {
+        return;
+    }
+    //Make sure every level lies inside the file before we hand out pointers.
+    for (int i = 0; i < numLevels; i++) {
+        const unsigned char *entry = m_pData + kHeaderSize + kLevelEntrySize * i;
+        unsigned long long end = getU64(entry + 16) + getU64(entry + 8) * m_iChannels * 3 * sizeof(short);
+        if (end > static_cast<unsigned long long>(size) || getU64(entry + 16) % sizeof(short) != 0) {
+            return;
+        }
+    }
+    m_iSampleRate = static_cast<int>(getU32(m_pData + 16));
+    m_numFrames = static_cast<long long>(getU64(m_pData + 24));
+    m_iNumLevels = numLevels;
+}
+
+const unsigned char *AudioDecoderPeakFile::levelEntry(int level) const
+{
+    return m_pData + kHeaderSize + kLevelEntrySize * level;
+}
+
+int AudioDecoderPeakFile::framesPerBin(int level) const
+{
+    return static_cast<int>(getU32(levelEntry(level)));
+}
+
+long long AudioDecoderPeakFile::numBins(int level) const
+{
+    return static_cast<long long>(getU64(levelEntry(level) + 8));
+}
+
+int AudioDecoderPeakFile::levelForZoom(double framesPerPixel) const
+{
+    int best = 0;
+    for (int i = 1; i < m_iNumLevels; i++) {
+        if (framesPerBin(i) <= framesPerPixel) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+const short *AudioDecoderPeakFile::bins(int level) const
+{
+    return reinterpret_cast<const short*>(m_pData + getU64(levelEntry(level) + 16));
+}
+
+long long AudioDecoderPeakFile::getBins(int level, long long firstBin, long long count,
+                                        float *min, float *max, float *rms) const
+{
+    if (level < 0 || level >= m_iNumLevels || firstBin < 0) {
+        return 0;
+    }
+    const long long available = numBins(level) - firstBin;
+    if (count > available) {
+        count = available;
+    }
+    const short *bin = bins(level) + firstBin * m_iChannels * 3;
+    const float scale = 1.0f / 32767.0f;
+    for (long long i = 0; i < count * m_iChannels; i++) {
+        min[i] = bin[i * 3] * scale;
+        max[i] = bin[i * 3 + 1] * scale;
+        rms[i] = bin[i * 3 + 2] * scale;
+    }
+    return count > 0 ? count : 0;
+}
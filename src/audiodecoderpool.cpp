@@ -0,0 +1,142 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+
+#include "audiodecoder.h"
+#include "audiodecoderpool.h"
+
+AudioDecoderPool::AudioDecoderPool(int maxIdle)
+: m_iMaxIdle(maxIdle > 0 ? maxIdle : 0)
+{
+    m_idle.reserve(m_iMaxIdle);
+}
+
+AudioDecoderPool::~AudioDecoderPool()
+{
+    clear();
+}
+
+AudioDecoder *AudioDecoderPool::acquire(const std::string filename)
+{
+    AudioDecoder *decoder = takeIdle();
+    if (decoder) {
+        if (decoder->reset(filename) == AUDIODECODER_OK) {
+            return decoder;
+        }
+        //The decoder is fine, it's the file that isn't.
+        decoder->close();
+        putIdle(decoder);
+        return NULL;
+    }
+    decoder = new AudioDecoder(filename);
+    if (decoder->open() != AUDIODECODER_OK) {
+        delete decoder;
+        return NULL;
+    }
+    return decoder;
+}
+
+AudioDecoder *AudioDecoderPool::acquire(AudioDecoderSource *source)
+{
+    AudioDecoder *decoder = takeIdle();
+    if (decoder) {
+        if (decoder->reset(source) == AUDIODECODER_OK) {
+            return decoder;
+        }
+        decoder->close();
+        putIdle(decoder);
+        return NULL;
+    }
+    decoder = new AudioDecoder(source);
+    if (decoder->open() != AUDIODECODER_OK) {
+        delete decoder;
+        return NULL;
+    }
+    return decoder;
+}
+
+void AudioDecoderPool::release(AudioDecoder *decoder)
+{
+    if (!decoder) {
+        return;
+    }
+    //Closed here rather than in acquire(), so an idle decoder doesn't keep its file open.
+    decoder->close();
+    putIdle(decoder);
+}
+
+int AudioDecoderPool::idleCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return static_cast<int>(m_idle.size());
+}
+
+void AudioDecoderPool::clear()
+{
+    std::vector<AudioDecoder*> idle;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        idle.swap(m_idle);
+    }
+    for (size_t i = 0; i < idle.size(); i++) {
+        delete idle[i];
+    }
+}
+
+AudioDecoder *AudioDecoderPool::takeIdle()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_idle.empty()) {
+        return NULL;
+    }
+    AudioDecoder *decoder = m_idle.back(); // the most recently used, so the warmest
+    m_idle.pop_back();
+    return decoder;
+}
+
+void AudioDecoderPool::putIdle(AudioDecoder *decoder)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (static_cast<int>(m_idle.size()) < m_iMaxIdle) {
+            m_idle.push_back(decoder);
+            return;
+        }
+    }
+    delete decoder;
+}
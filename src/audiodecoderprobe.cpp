@@ -0,0 +1,512 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+#include <string.h>
+#include "audiodecoderframescanner.h"
+#include "audiodecoderprobe.h"
+#include "audiodecodersource.h"
+
+/** Exact-length random access to a source. */
+class AudioDecoderProbe::Reader
+{
+    public:
+        Reader(AudioDecoderSource *source)
+        : m_pSource(source)
+        , m_size(source->size())
+        {
+        }
+
+        long long size() const { return m_size; }
+        AudioDecoderSource *source() const { return m_pSource; }
+
+        /** Reads exactly len bytes at offset, or fails. */
+        bool readAt(long long offset, void *buffer, size_t len)
+        {
+            if (offset < 0 || offset + static_cast<long long>(len) > m_size) {
+                return false;
+            }
+            return m_pSource->pread(buffer, len, offset) == static_cast<long long>(len);
+        }
+
+    private:
+        AudioDecoderSource *m_pSource;
+        long long m_size;
+};
+
+static unsigned int rd16le(const unsigned char *p) { return p[0] | (p[1] << 8); }
+static unsigned int rd32le(const unsigned char *p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24); }
+static unsigned int rd16be(const unsigned char *p) { return (p[0] << 8) | p[1]; }
+static unsigned int rd32be(const unsigned char *p) { return ((unsigned int)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3]; }
+static unsigned long long rd64le(const unsigned char *p) { return rd32le(p) | ((unsigned long long)rd32le(p + 4) << 32); }
+static unsigned long long rd64be(const unsigned char *p) { return ((unsigned long long)rd32be(p) << 32) | rd32be(p + 4); }
+
+/** True for the magic numbers of containers we don't parse (FLAC, Ogg,
+    Matroska, CAF...), and for RIFF and FORM files that aren't WAV or AIFF. */
+static bool isOtherContainer(const unsigned char *magic)
+{
+    static const char *kMagic[] = { "fLaC", "OggS", "caff", "wvpk", "MAC ", "RIFF", "FORM",
+                                    "\x1A\x45\xDF\xA3" };
+    for (size_t i = 0; i < sizeof(kMagic) / sizeof(kMagic[0]); i++) {
+        if (memcmp(magic, kMagic[i], 4) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/** Fills in the fields every format derives the same way. */
+static int finish(AudioStreamInfo *info, long long frames, long long audioBytes)
+{
+    if (info->sampleRate <= 0 || info->channels <= 0 || frames < 0) {
+        return AUDIODECODER_ERROR;
+    }
+    info->numSamples = static_cast<int>(frames * info->channels);
+    info->duration = static_cast<float>(frames) / info->sampleRate;
+    info->lengthIsExact = true;
+    if (info->bitrate == 0 && info->duration > 0) {
+        info->bitrate = static_cast<int>(audioBytes * 8 / info->duration);
+    }
+    return AUDIODECODER_OK;
+}
+
+/** The container the first 16 bytes of a file announce; FORMAT_UNKNOWN
+    for anything else, MP3 included, since it has no container. */
+static AudioStreamInfo::Format containerFormat(const unsigned char *magic)
+{
+    static const unsigned char kAsfHeader[16] = { 0x30, 0x26, 0xB2, 0x75, 0x8E, 0x66, 0xCF, 0x11,
+                                                  0xA6, 0xD9, 0x00, 0xAA, 0x00, 0x62, 0xCE, 0x6C };
+    if (memcmp(magic, "RIFF", 4) == 0 && memcmp(magic + 8, "WAVE", 4) == 0) {
+        return AudioStreamInfo::FORMAT_WAV;
+    }
+    if (memcmp(magic, "FORM", 4) == 0 &&
+        (memcmp(magic + 8, "AIFF", 4) == 0 || memcmp(magic + 8, "AIFC", 4) == 0)) {
+        return AudioStreamInfo::FORMAT_AIFF;
+    }
+    if (memcmp(magic + 4, "ftyp", 4) == 0) {
+        return AudioStreamInfo::FORMAT_MP4;
+    }
+    if (memcmp(magic, kAsfHeader, 16) == 0) {
+        return AudioStreamInfo::FORMAT_WMA;
+    }
+    return AudioStreamInfo::FORMAT_UNKNOWN;
+}
+
+int AudioDecoderProbe::probe(const std::string filename, AudioStreamInfo *info, bool countFrames)
+{
+    AudioDecoderFileSource source(filename);
+    if (!source.isOpen()) {
+        memset(info, 0, sizeof(*info));
+        return AUDIODECODER_ERROR;
+    }
+    return probe(&source, info, countFrames);
+}
+
+int AudioDecoderProbe::probe(AudioDecoderSource *source, AudioStreamInfo *info, bool countFrames)
+{
+    memset(info, 0, sizeof(*info));
+    Reader reader(source);
+
+    //Sniff the container from the magic numbers rather than trusting the extension.
+    unsigned char magic[16];
+    if (!reader.readAt(0, magic, sizeof(magic))) {
+        return AUDIODECODER_ERROR;
+    }
+    switch (containerFormat(magic)) {
+        case AudioStreamInfo::FORMAT_WAV:  return probeWav(reader, info);
+        case AudioStreamInfo::FORMAT_AIFF: return probeAiff(reader, info);
+        case AudioStreamInfo::FORMAT_MP4:  return probeMp4(reader, info);
+        case AudioStreamInfo::FORMAT_WMA:  return probeWma(reader, info);
+        default: break;
+    }
+    //MP3 has no container, so it's whatever is left, but a stray sync
+    //word in a container we don't parse mustn't pass for one.
+    if (isOtherContainer(magic)) {
+        return AUDIODECODER_ERROR;
+    }
+    return probeMp3(reader, info, countFrames);
+}
+
+AudioStreamInfo::Format AudioDecoderProbe::sniff(AudioDecoderSource *source)
+{
+    unsigned char magic[16];
+    if (source->pread(magic, sizeof(magic), 0) != static_cast<long long>(sizeof(magic))) {
+        return AudioStreamInfo::FORMAT_UNKNOWN;
+    }
+    AudioStreamInfo::Format format = containerFormat(magic);
+    AudioDecoderFrameHeader header;
+    if (format == AudioStreamInfo::FORMAT_UNKNOWN &&
+        (memcmp(magic, "ID3", 3) == 0 || AudioDecoderFrameScanner::parseMpegHeader(magic, &header))) {
+        format = AudioStreamInfo::FORMAT_MP3;
+    }
+    return format;
+}
+
+int AudioDecoderProbe::probeWav(Reader& reader, AudioStreamInfo *info)
+{
+    info->format = AudioStreamInfo::FORMAT_WAV;
+    unsigned int blockAlign = 0;
+    long long offset = 12;
+    unsigned char chunk[24];
+
+    while (reader.readAt(offset, chunk, 8)) {
+        long long chunkSize = rd32le(chunk + 4);
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            if (chunkSize < 16 || !reader.readAt(offset + 8, chunk + 8, 16)) {
+                return AUDIODECODER_ERROR;
+            }
+            info->channels = rd16le(chunk + 10);
+            info->sampleRate = rd32le(chunk + 12);
+            info->bitrate = rd32le(chunk + 16) * 8;
+            blockAlign = rd16le(chunk + 20);
+            info->bitsPerSample = rd16le(chunk + 22);
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (blockAlign == 0) {
+                return AUDIODECODER_ERROR; // data before fmt, or a broken fmt
+            }
+            //The header of a WAV that is still being written says 0 or 0xFFFFFFFF.
+            long long available = reader.size() - offset - 8;
+            if (chunkSize == 0 || chunkSize > available) {
+                chunkSize = available;
+            }
+            return finish(info, chunkSize / blockAlign, chunkSize);
+        }
+        offset += 8 + chunkSize + (chunkSize & 1); // chunks are word aligned
+    }
+    return AUDIODECODER_ERROR;
+}
+
+/** Converts the 80-bit IEEE 754 extended float used by AIFF for the sample rate. */
+static double fromExtended(const unsigned char *p)
+{
+    int exponent = ((p[0] & 0x7F) << 8) | p[1];
+    unsigned long long mantissa = rd64be(p + 2);
+    if (exponent == 0 && mantissa == 0) {
+        return 0;
+    }
+    double value = static_cast<double>(mantissa);
+    exponent -= 16383 + 63;
+    while (exponent > 0) { value *= 2; exponent--; }
+    while (exponent < 0) { value /= 2; exponent++; }
+    return (p[0] & 0x80) ? -value : value;
+}
+
+int AudioDecoderProbe::probeAiff(Reader& reader, AudioStreamInfo *info)
+{
+    info->format = AudioStreamInfo::FORMAT_AIFF;
+    long long offset = 12;
+    unsigned char chunk[26];
+
+    while (reader.readAt(offset, chunk, 8)) {
+        long long chunkSize = rd32be(chunk + 4);
+        if (memcmp(chunk, "COMM", 4) == 0) {
+            if (chunkSize < 18 || !reader.readAt(offset + 8, chunk + 8, 18)) {
+                return AUDIODECODER_ERROR;
+            }
+            info->channels = rd16be(chunk + 8);
+            long long frames = rd32be(chunk + 10);
+            info->bitsPerSample = rd16be(chunk + 14);
+            info->sampleRate = static_cast<int>(fromExtended(chunk + 16) + 0.5);
+            return finish(info, frames, frames * info->channels * ((info->bitsPerSample + 7) / 8));
+        }
+        offset += 8 + chunkSize + (chunkSize & 1);
+    }
+    return AUDIODECODER_ERROR;
+}
+
+int AudioDecoderProbe::probeMp4(Reader& reader, AudioStreamInfo *info)
+{
+    info->format = AudioStreamInfo::FORMAT_MP4;
+
+    //Walk down moov/trak/mdia until we find the sound track. We only ever
+    //read box headers and the few small boxes we care about; mdat is skipped.
+    //The ends of the boxes we're inside, innermost last. When one runs out
+    //we carry on in its parent, eg. with the next trak after a video track.
+    long long ends[8];
+    int depth = 0;
+    long long offset = 0;
+    long long end = reader.size();
+    long long timescale = 0;
+    long long mediaDuration = 0;
+    bool isSoundTrack = false;
+    unsigned char box[44];
+
+    while (true) {
+        while (offset + 8 > end && depth > 0) {
+            offset = end;
+            end = ends[--depth];
+        }
+        if (offset + 8 > end || !reader.readAt(offset, box, 8)) {
+            break;
+        }
+        long long boxSize = rd32be(box);
+        long long headerSize = 8;
+        if (boxSize == 1) {
+            if (!reader.readAt(offset + 8, box + 8, 8)) {
+                return AUDIODECODER_ERROR;
+            }
+            boxSize = static_cast<long long>(rd64be(box + 8));
+            headerSize = 16;
+        } else if (boxSize == 0) {
+            boxSize = end - offset;
+        }
+        if (boxSize < headerSize || offset + boxSize > end) {
+            return AUDIODECODER_ERROR;
+        }
+
+        const long long payload = offset + headerSize;
+        const bool isTrak = memcmp(box + 4, "trak", 4) == 0;
+        if (isTrak || memcmp(box + 4, "moov", 4) == 0 || memcmp(box + 4, "mdia", 4) == 0 ||
+            memcmp(box + 4, "minf", 4) == 0 || memcmp(box + 4, "stbl", 4) == 0) {
+            //Descend into containers.
+            if (depth == sizeof(ends) / sizeof(ends[0])) {
+                return AUDIODECODER_ERROR;
+            }
+            if (isTrak) {
+                isSoundTrack = false;
+                timescale = 0;
+                mediaDuration = 0;
+            }
+            ends[depth++] = end;
+            end = offset + boxSize;
+            offset = payload;
+            continue;
+        }
+        if (memcmp(box + 4, "mdhd", 4) == 0 && reader.readAt(payload, box, 32)) {
+            if (box[0] == 1) {
+                timescale = rd32be(box + 20);
+                mediaDuration = static_cast<long long>(rd64be(box + 24));
+            } else {
+                timescale = rd32be(box + 12);
+                mediaDuration = rd32be(box + 16);
+            }
+        } else if (memcmp(box + 4, "hdlr", 4) == 0 && reader.readAt(payload, box, 12)) {
+            isSoundTrack = memcmp(box + 8, "soun", 4) == 0;
+        } else if (memcmp(box + 4, "stsd", 4) == 0 && isSoundTrack &&
+                   reader.readAt(payload, box, 44)) {
+            //fullbox header, entry count, then the first AudioSampleEntry.
+            info->channels = rd16be(box + 8 + 24);
+            info->bitsPerSample = 0;
+            info->sampleRate = rd32be(box + 8 + 32) >> 16;
+            if (info->sampleRate == 0) {
+                info->sampleRate = static_cast<int>(timescale); // 16.16 overflows above 64 kHz
+            }
+            if (timescale <= 0) {
+                return AUDIODECODER_ERROR;
+            }
+            long long frames = mediaDuration * info->sampleRate / timescale;
+            return finish(info, frames, reader.size());
+        }
+        offset += boxSize;
+    }
+    return AUDIODECODER_ERROR;
+}
+
+int AudioDecoderProbe::probeWma(Reader& reader, AudioStreamInfo *info)
+{
+    static const unsigned char kFileProperties[16] = { 0xA1, 0xDC, 0xAB, 0x8C, 0x47, 0xA9, 0xCF, 0x11,
+                                                       0x8E, 0xE4, 0x00, 0xC0, 0x0C, 0x20, 0x53, 0x65 };
+    static const unsigned char kStreamProperties[16] = { 0x91, 0x07, 0xDC, 0xB7, 0xB7, 0xA9, 0xCF, 0x11,
+                                                         0x8E, 0xE6, 0x00, 0xC0, 0x0C, 0x20, 0x53, 0x65 };
+    static const unsigned char kAudioMedia[16] = { 0x40, 0x9E, 0x69, 0xF8, 0x4D, 0x5B, 0xCF, 0x11,
+                                                   0xA8, 0xFD, 0x00, 0x80, 0x5F, 0x5C, 0x44, 0x2B };
+    info->format = AudioStreamInfo::FORMAT_WMA;
+
+    unsigned char header[30];
+    if (!reader.readAt(0, header, sizeof(header))) {
+        return AUDIODECODER_ERROR;
+    }
+    const long long headerEnd = static_cast<long long>(rd64le(header + 16));
+    long long offset = 30;
+    double seconds = -1;
+    unsigned char object[104]; // a File Properties object, the largest we read
+    const long long kStreamPropertiesSize = 96; // up to the end of its WAVEFORMATEX
+
+    while (offset + 24 <= headerEnd && reader.readAt(offset, object, 24)) {
+        long long objectSize = static_cast<long long>(rd64le(object + 16));
+        if (objectSize < 24) {
+            return AUDIODECODER_ERROR;
+        }
+        if (memcmp(object, kFileProperties, 16) == 0 && objectSize >= static_cast<long long>(sizeof(object)) &&
+            reader.readAt(offset, object, sizeof(object))) {
+            //Play duration is in 100ns units and includes the preroll (in ms).
+            unsigned long long playDuration = rd64le(object + 64);
+            unsigned long long preroll = rd64le(object + 80);
+            seconds = playDuration / 1e7 - preroll / 1e3;
+        } else if (memcmp(object, kStreamProperties, 16) == 0 && objectSize >= kStreamPropertiesSize &&
+                   reader.readAt(offset, object, kStreamPropertiesSize) &&
+                   memcmp(object + 24, kAudioMedia, 16) == 0) {
+            //The type-specific data is a WAVEFORMATEX.
+            const unsigned char *waveFormat = object + 78;
+            info->channels = rd16le(waveFormat + 2);
+            info->sampleRate = rd32le(waveFormat + 4);
+            info->bitrate = rd32le(waveFormat + 8) * 8;
+            info->bitsPerSample = 0;
+        }
+        offset += objectSize;
+    }
+    if (seconds < 0) {
+        return AUDIODECODER_ERROR;
+    }
+    return finish(info, static_cast<long long>(seconds * info->sampleRate + 0.5), reader.size());
+}
+
+int AudioDecoderProbe::probeMp3(Reader& reader, AudioStreamInfo *info, bool countFrames)
+{
+    info->format = AudioStreamInfo::FORMAT_MP3;
+
+    //Skip an ID3v2 tag. Its size is a 28-bit "synchsafe" integer.
+    long long audioStart = 0;
+    unsigned char id3[10];
+    if (reader.readAt(0, id3, sizeof(id3)) && memcmp(id3, "ID3", 3) == 0) {
+        audioStart = 10 + (((id3[6] & 0x7F) << 21) | ((id3[7] & 0x7F) << 14) |
+                           ((id3[8] & 0x7F) << 7) | (id3[9] & 0x7F));
+        if (id3[5] & 0x10) {
+            audioStart += 10; // footer
+        }
+    }
+    unsigned char magic[4];
+    if (audioStart > 0 && reader.readAt(audioStart, magic, sizeof(magic)) && isOtherContainer(magic)) {
+        return AUDIODECODER_ERROR; // eg. a FLAC file with an ID3 tag
+    }
+    long long audioEnd = reader.size();
+    unsigned char tag[3];
+    if (reader.readAt(audioEnd - 128, tag, 3) && memcmp(tag, "TAG", 3) == 0) {
+        audioEnd -= 128; // ID3v1
+    }
+
+    //Find the first frame: a valid header that's followed by another one.
+    const int kSearchSize = 64 * 1024;
+    unsigned char buffer[kSearchSize + 4];
+    size_t available = static_cast<size_t>(audioEnd - audioStart < kSearchSize ?
+                                           audioEnd - audioStart : kSearchSize);
+    if (!reader.readAt(audioStart, buffer, available)) {
+        return AUDIODECODER_ERROR;
+    }
+    AudioDecoderFrameHeader header;
+    long long firstFrame = -1;
+    for (size_t i = 0; i + 4 <= available; i++) {
+        AudioDecoderFrameHeader next;
+        unsigned char nextBytes[4];
+        if (AudioDecoderFrameScanner::parseMpegHeader(buffer + i, &header) &&
+            reader.readAt(audioStart + i + header.frameLength, nextBytes, 4) &&
+            AudioDecoderFrameScanner::parseMpegHeader(nextBytes, &next) &&
+            next.sampleRate == header.sampleRate) {
+            firstFrame = audioStart + i;
+            break;
+        }
+    }
+    if (firstFrame < 0) {
+        return AUDIODECODER_ERROR;
+    }
+    info->sampleRate = header.sampleRate;
+    info->channels = header.channels;
+    info->bitsPerSample = 0;
+
+    //A VBR file announces its frame count in a Xing/Info or VBRI header
+    //inside the first frame. The side info size decides where Xing lives.
+    //That frame is silent and isn't counted.
+    unsigned char frame[4 + 32 + 120 + 36];
+    memset(frame, 0, sizeof(frame));
+    long long frames = -1;
+    long long audioBytes = audioEnd - firstFrame;
+    const size_t frameBytes = static_cast<size_t>(audioBytes < static_cast<long long>(sizeof(frame)) ?
+                                                  audioBytes : sizeof(frame));
+    if (reader.readAt(firstFrame, frame, frameBytes)) {
+        int sideInfo = header.version == 1 ? (header.channels == 1 ? 17 : 32)
+                                           : (header.channels == 1 ? 9 : 17);
+        const unsigned char *xing = frame + 4 + sideInfo;
+        const unsigned char *vbri = frame + 4 + 32;
+        if (memcmp(xing, "Xing", 4) == 0 || memcmp(xing, "Info", 4) == 0) {
+            unsigned int flags = rd32be(xing + 4);
+            if (flags & 0x1) {
+                frames = rd32be(xing + 8);
+            }
+            if ((flags & 0x3) == 0x3) {
+                audioBytes = rd32be(xing + 12);
+            }
+            //The LAME tag follows whichever of frames, bytes, TOC and quality
+            //are there. FFmpeg writes one too, as "Lavf" or "Lavc".
+            const unsigned char *lame = xing + 8 + ((flags & 0x1) ? 4 : 0) + ((flags & 0x2) ? 4 : 0) +
+                                        ((flags & 0x4) ? 100 : 0) + ((flags & 0x8) ? 4 : 0);
+            if (memcmp(lame, "LAME", 4) == 0 || memcmp(lame, "Lavf", 4) == 0 ||
+                memcmp(lame, "Lavc", 4) == 0) {
+                info->encoderDelay = (lame[21] << 4) | (lame[22] >> 4);
+                info->encoderPadding = ((lame[22] & 0x0F) << 8) | lame[23];
+            }
+        } else if (memcmp(vbri, "VBRI", 4) == 0) {
+            info->encoderDelay = rd16be(vbri + 6);
+            audioBytes = rd32be(vbri + 10);
+            frames = rd32be(vbri + 14);
+        }
+    }
+    bool estimated = false;
+    if (frames < 0 && !countFrames) {
+        //No header to ask. Assume CBR: the average frame, padding included,
+        //is samplesPerFrame at the first frame's bitrate. That only needs
+        //what we've read already, so opening doesn't slow down with the
+        //size of the file (or download all of it over HTTP).
+        audioBytes = audioEnd - firstFrame;
+        info->bitrate = header.bitrate;
+        const double averageFrame = header.samplesPerFrame / 8.0 * header.bitrate / header.sampleRate;
+        frames = static_cast<long long>(audioBytes / averageFrame + 0.5);
+        estimated = true;
+    } else if (frames < 0) {
+        //Count the frames, which needs only their headers. Dividing the
+        //size by a frame length would be off for VBR.
+        AudioDecoderFrameIndex index;
+        if (AudioDecoderFrameScanner::scan(reader.source(), firstFrame, audioEnd,
+                                           AudioDecoderFrameScanner::FORMAT_MPEG,
+                                           &index, false) != AUDIODECODER_OK) {
+            return AUDIODECODER_ERROR;
+        }
+        frames = index.frames;
+        if (index.constantBitrate) {
+            info->bitrate = index.first.bitrate;
+        }
+        audioBytes = audioEnd - firstFrame;
+    }
+    long long samples = frames * header.samplesPerFrame - info->encoderDelay - info->encoderPadding;
+    if (samples < 0) {
+        //A tag that doesn't fit the file; trust the frame count alone.
+        info->encoderDelay = info->encoderPadding = 0;
+        samples = frames * header.samplesPerFrame;
+    }
+    const int result = finish(info, samples, audioBytes);
+    info->lengthIsExact = !estimated;
+    return result;
+}
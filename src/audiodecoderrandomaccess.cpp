@@ -0,0 +1,185 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+
+#include "audiodecoder.h"
+#include "audiodecoderrandomaccess.h"
+#include "audiodecodersource.h"
+
+AudioDecoderRandomAccess::AudioDecoderRandomAccess(const std::string filename, int maxCursors)
+: m_filename(filename)
+, m_pSource(NULL)
+, m_pOwnedSource(NULL)
+, m_iMaxCursors(maxCursors > 0 ? maxCursors : 1)
+, m_iNumSamples(0)
+, m_iChannels(0)
+, m_iSampleRate(0)
+, m_fDuration(0)
+, m_iCursors(0)
+{
+}
+
+AudioDecoderRandomAccess::AudioDecoderRandomAccess(AudioDecoderSource *source, int maxCursors)
+: m_pSource(source)
+, m_pOwnedSource(NULL)
+, m_iMaxCursors(maxCursors > 0 ? maxCursors : 1)
+, m_iNumSamples(0)
+, m_iChannels(0)
+, m_iSampleRate(0)
+, m_fDuration(0)
+, m_iCursors(0)
+{
+}
+
+AudioDecoderRandomAccess::~AudioDecoderRandomAccess()
+{
+    //Every cursor must be back by now; readAt() doesn't outlive us.
+    for (size_t i = 0; i < m_idle.size(); i++) {
+        delete m_idle[i];
+    }
+    delete m_pOwnedSource;
+}
+
+int AudioDecoderRandomAccess::open()
+{
+    if (m_iCursors > 0) {
+        return AUDIODECODER_OK;
+    }
+    if (!m_pSource) {
+        //One handle for every cursor, read with positional reads.
+        AudioDecoderFileSource *file = new AudioDecoderFileSource(m_filename);
+        if (!file->isOpen()) {
+            delete file;
+            return AUDIODECODER_ERROR;
+        }
+        m_pSource = m_pOwnedSource = file;
+    }
+
+    AudioDecoder *cursor = clone();
+    if (!cursor) {
+        return AUDIODECODER_ERROR;
+    }
+    m_iNumSamples = cursor->numSamples();
+    m_iChannels = cursor->channels();
+    m_iSampleRate = cursor->sampleRate();
+    m_fDuration = cursor->duration();
+    m_iCursors = 1;
+    m_idle.push_back(cursor);
+    return AUDIODECODER_OK;
+}
+
+int AudioDecoderRandomAccess::readAt(int sampleIdx, int size, SAMPLE *buffer)
+{
+    if (!m_pSource || sampleIdx < 0 || size < 0) {
+        return AUDIODECODER_ERROR;
+    }
+    AudioDecoder *cursor = takeCursor(sampleIdx);
+    if (!cursor) {
+        return AUDIODECODER_ERROR;
+    }
+    if (cursor->positionInSamples() != sampleIdx) {
+        cursor->seek(sampleIdx);
+    }
+    const int samplesRead = cursor->read(size, buffer);
+    putCursor(cursor);
+    return samplesRead;
+}
+
+AudioDecoder *AudioDecoderRandomAccess::clone()
+{
+    if (!m_pSource) {
+        return NULL;
+    }
+    AudioDecoder *decoder = new AudioDecoder(m_pSource);
+    if (decoder->open() != AUDIODECODER_OK) {
+        delete decoder;
+        return NULL;
+    }
+    return decoder;
+}
+
+int AudioDecoderRandomAccess::cursorCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_iCursors;
+}
+
+/** An idle cursor, the one already at sampleIdx if there is one; a new one
+    if they're all busy and there's room for another; otherwise waits. */
+AudioDecoder *AudioDecoderRandomAccess::takeCursor(int sampleIdx)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        if (!m_idle.empty()) {
+            size_t pick = m_idle.size() - 1; // the most recently used, so the warmest
+            for (size_t i = 0; i < m_idle.size(); i++) {
+                if (m_idle[i]->positionInSamples() == sampleIdx) {
+                    pick = i;
+                    break;
+                }
+            }
+            AudioDecoder *cursor = m_idle[pick];
+            m_idle.erase(m_idle.begin() + pick);
+            return cursor;
+        }
+        if (m_iCursors < m_iMaxCursors) {
+            break;
+        }
+        m_cursorReturned.wait(lock);
+    }
+
+    //Open the new cursor outside the lock, so readers with a cursor aren't held up.
+    m_iCursors++;
+    lock.unlock();
+    AudioDecoder *cursor = clone();
+    if (!cursor) {
+        lock.lock();
+        m_iCursors--;
+        m_cursorReturned.notify_one();
+    }
+    return cursor;
+}
+
+void AudioDecoderRandomAccess::putCursor(AudioDecoder *cursor)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_idle.push_back(cursor);
+    }
+    m_cursorReturned.notify_one();
+}
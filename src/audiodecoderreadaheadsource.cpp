@@ -0,0 +1,454 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+#include "audiodecoderreadaheadsource.h"
+#include "audiodecodertrace.h"
+
+const int kAlignment = 4096; // good for O_DIRECT and for the page cache
+
+static char *alignedAlloc(int size)
+{
+#ifdef _WIN32
+    return static_cast<char*>(_aligned_malloc(size, kAlignment));
+#else
+    void *data = NULL;
+    return posix_memalign(&data, kAlignment, size) == 0 ? static_cast<char*>(data) : NULL;
+#endif
+}
+
+static void alignedFree(char *data)
+{
+#ifdef _WIN32
+    _aligned_free(data);
+#else
+    free(data);
+#endif
+}
+
+#ifdef __linux__
+/** A bare-bones io_uring: one submission per slot, completions carry the slot
+    index in user_data. We talk to the kernel directly instead of depending on
+    liburing, since we need so little of it. */
+struct AudioDecoderReadAheadSource::Ring
+{
+    int fd;
+    unsigned *sqHead, *sqTail, *sqMask, *sqArray;
+    unsigned *cqHead, *cqTail, *cqMask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sqRing;
+    size_t sqRingSize;
+    void *cqRing;
+    size_t cqRingSize;
+    size_t sqesSize;
+    struct iovec *iovecs;
+
+    static Ring *create(unsigned entries)
+    {
+        struct io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (fd < 0) {
+            return NULL;
+        }
+
+        Ring *ring = new Ring(); // value-initialized, so every pointer starts out NULL
+        ring->fd = fd;
+        ring->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        ring->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP) {
+            if (ring->cqRingSize > ring->sqRingSize) {
+                ring->sqRingSize = ring->cqRingSize;
+            }
+            ring->cqRingSize = ring->sqRingSize;
+        }
+        ring->sqRing = mmap(NULL, ring->sqRingSize, PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (ring->sqRing == MAP_FAILED) {
+            ring->sqRing = NULL;
+            delete ring;
+            return NULL;
+        }
+        if (params.features & IORING_FEAT_SINGLE_MMAP) {
+            ring->cqRing = ring->sqRing;
+        } else {
+            ring->cqRing = mmap(NULL, ring->cqRingSize, PROT_READ | PROT_WRITE,
+                                MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+            if (ring->cqRing == MAP_FAILED) {
+                ring->cqRing = NULL;
+                delete ring;
+                return NULL;
+            }
+        }
+        ring->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+        void *sqes = mmap(NULL, ring->sqesSize, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) {
+            delete ring;
+            return NULL;
+        }
+        ring->sqes = static_cast<struct io_uring_sqe*>(sqes);
+
+        char *sq = static_cast<char*>(ring->sqRing);
+        char *cq = static_cast<char*>(ring->cqRing);
+        ring->sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        ring->sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        ring->sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        ring->sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        ring->cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        ring->cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        ring->cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        ring->cqes = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+        ring->iovecs = new struct iovec[entries];
+        return ring;
+    }
+
+    ~Ring()
+    {
+        if (sqes) {
+            munmap(sqes, sqesSize);
+        }
+        if (cqRing && cqRing != sqRing) {
+            munmap(cqRing, cqRingSize);
+        }
+        if (sqRing) {
+            munmap(sqRing, sqRingSize);
+        }
+        delete [] iovecs;
+        close(fd);
+    }
+
+    /** Queues a read and hands it to the kernel. Returns false, with the
+        queue as it was, if the kernel didn't take it. */
+    bool submitRead(int fileFd, int slotIndex, char *data, int size, long long offset)
+    {
+        unsigned tail = *sqTail;
+        unsigned index = tail & *sqMask;
+        struct io_uring_sqe *sqe = &sqes[index];
+        memset(sqe, 0, sizeof(*sqe));
+        iovecs[slotIndex].iov_base = data;
+        iovecs[slotIndex].iov_len = size;
+        //READV rather than READ: it's been around since the first io_uring kernels.
+        sqe->opcode = IORING_OP_READV;
+        sqe->fd = fileFd;
+        sqe->addr = reinterpret_cast<unsigned long long>(&iovecs[slotIndex]);
+        sqe->len = 1;
+        sqe->off = offset;
+        sqe->user_data = slotIndex;
+        sqArray[index] = index;
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+        long submitted;
+        do {
+            submitted = syscall(__NR_io_uring_enter, fd, 1, 0, 0, NULL, 0);
+        } while (submitted < 0 && errno == EINTR);
+        if (submitted == 1 || __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) == tail + 1) {
+            return true;
+        }
+        //Not consumed (EAGAIN, EBUSY...). The kernel only looks at the queue
+        //inside io_uring_enter(), which only we call, so the entry can be
+        //taken back; otherwise a later call would submit it into a buffer
+        //that has been reused by then.
+        __atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+        return false;
+    }
+
+    /** Pops one completion, waiting for it if wait is set. Returns false if there's none. */
+    bool reap(bool wait, int *slotIndex, int *result)
+    {
+        unsigned head = *cqHead;
+        while (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+            if (!wait) {
+                return false;
+            }
+            if (syscall(__NR_io_uring_enter, fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0 &&
+                errno != EINTR) {
+                return false;
+            }
+        }
+        struct io_uring_cqe *cqe = &cqes[head & *cqMask];
+        *slotIndex = static_cast<int>(cqe->user_data);
+        *result = cqe->res;
+        __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+};
+#else
+struct AudioDecoderReadAheadSource::Ring {};
+#endif
+
+AudioDecoderReadAheadSource::AudioDecoderReadAheadSource(const std::string filename,
+                                                         int queueDepth, int blockSize,
+                                                         IoMode ioMode)
+: AudioDecoderFileSource(filename)
+, m_iQueueDepth(queueDepth < 1 ? 1 : queueDepth)
+, m_iBlockSize((blockSize + kAlignment - 1) / kAlignment * kAlignment)
+, m_slots(NULL)
+, m_nextOffset(0)
+, m_pRing(NULL)
+, m_ioMode(ioMode)
+{
+    if (m_iBlockSize <= 0) {
+        m_iBlockSize = kAlignment;
+    }
+    if (m_ioMode == IO_DIRECT) {
+        //Every read we issue is a whole, aligned block into an aligned buffer,
+        //which is what O_DIRECT asks for.
+        bool direct = false;
+#if defined(__linux__)
+        int flags = isOpen() ? fcntl(m_fd, F_GETFL) : -1;
+        direct = flags != -1 && fcntl(m_fd, F_SETFL, flags | O_DIRECT) == 0;
+#elif defined(__APPLE__)
+        direct = isOpen() && fcntl(m_fd, F_NOCACHE, 1) == 0;
+#endif
+        if (!direct) {
+            m_ioMode = IO_SCAN;
+        }
+    }
+#if defined(__APPLE__)
+    //There's no POSIX_FADV_DONTNEED here; not caching at all is the closest thing.
+    if (m_ioMode == IO_SCAN && isOpen()) {
+        fcntl(m_fd, F_NOCACHE, 1);
+    }
+#endif
+    m_slots = new Slot[m_iQueueDepth];
+    for (int i = 0; i < m_iQueueDepth; i++) {
+        m_slots[i].data = alignedAlloc(m_iBlockSize);
+        m_slots[i].offset = 0;
+        m_slots[i].bytes = 0;
+        m_slots[i].state = SLOT_EMPTY;
+    }
+#ifdef __linux__
+    if (isOpen()) {
+        m_pRing = Ring::create(m_iQueueDepth);
+    }
+#endif
+}
+
+AudioDecoderReadAheadSource::~AudioDecoderReadAheadSource()
+{
+    //The kernel may still be writing into our buffers.
+    drain();
+    //Don't leave the read-ahead we never got to behind in the cache either.
+    for (int i = 0; i < m_iQueueDepth; i++) {
+        if (m_slots[i].state != SLOT_EMPTY) {
+            dropFromCache(m_slots[i].offset, m_iBlockSize);
+        }
+    }
+    delete m_pRing;
+    for (int i = 0; i < m_iQueueDepth; i++) {
+        alignedFree(m_slots[i].data);
+    }
+    delete [] m_slots;
+}
+
+long long AudioDecoderReadAheadSource::pread(void *buffer, long long size, long long offset)
+{
+    if (!isOpen() || offset < 0 || size < 0) {
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    long long total = 0;
+    while (total < size && offset + total < m_size) {
+        const long long position = offset + total;
+        Slot *slot = findSlot(position);
+        if (!slot) {
+            //A seek, or the very first read. Start a new window here.
+            restartAt(position);
+            continue;
+        }
+        if (slot->state == SLOT_PENDING) {
+            waitFor(slot);
+        }
+        if (slot->bytes < 0) {
+            return total > 0 ? total : -1;
+        }
+        long long available = slot->offset + slot->bytes - position;
+        if (available <= 0) {
+            break; // short read at the end of the file
+        }
+        long long chunk = size - total < available ? size - total : available;
+        memcpy(static_cast<char*>(buffer) + total, slot->data + (position - slot->offset),
+               static_cast<size_t>(chunk));
+        total += chunk;
+        refill(offset + total);
+    }
+    return total;
+}
+
+AudioDecoderReadAheadSource::Slot *AudioDecoderReadAheadSource::findSlot(long long offset)
+{
+    for (int i = 0; i < m_iQueueDepth; i++) {
+        Slot *slot = &m_slots[i];
+        if (slot->state != SLOT_EMPTY && offset >= slot->offset &&
+            offset < slot->offset + m_iBlockSize) {
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+void AudioDecoderReadAheadSource::restartAt(long long offset)
+{
+    drain();
+    for (int i = 0; i < m_iQueueDepth; i++) {
+        m_slots[i].state = SLOT_EMPTY;
+    }
+    m_nextOffset = offset / m_iBlockSize * m_iBlockSize;
+    refill(offset);
+}
+
+void AudioDecoderReadAheadSource::refill(long long offset)
+{
+#ifdef __linux__
+    //Collect whatever has landed in the meantime, without blocking.
+    int slotIndex = 0;
+    int result = 0;
+    while (m_pRing && m_pRing->reap(false, &slotIndex, &result)) {
+        m_slots[slotIndex].bytes = result;
+        m_slots[slotIndex].state = SLOT_READY;
+    }
+#endif
+    //Recycle every finished block that lies wholly behind the reader, and
+    //point it at the next block of the file.
+    for (int i = 0; i < m_iQueueDepth && m_nextOffset < m_size; i++) {
+        Slot *slot = &m_slots[i];
+        if (slot->state == SLOT_EMPTY ||
+            (slot->state == SLOT_READY && slot->offset + m_iBlockSize <= offset)) {
+            if (slot->state == SLOT_READY) {
+                dropFromCache(slot->offset, m_iBlockSize);
+            }
+            submit(slot, m_nextOffset);
+            m_nextOffset += m_iBlockSize;
+        }
+    }
+}
+
+void AudioDecoderReadAheadSource::submit(Slot *slot, long long offset)
+{
+    AUDIODECODER_TRACE_SCOPE_ARG("io", "ReadAhead::submit", "offset", offset);
+    slot->offset = offset;
+    slot->bytes = 0;
+#ifdef __linux__
+    if (m_pRing && m_pRing->submitRead(m_fd, static_cast<int>(slot - m_slots),
+                                       slot->data, m_iBlockSize, offset)) {
+        slot->state = SLOT_PENDING;
+        return;
+    }
+    if (m_pRing) {
+        //Submission failed (eg. a seccomp filter); carry on without the ring.
+        //This slot isn't in the kernel's hands, so drain() mustn't wait for it.
+        slot->state = SLOT_EMPTY;
+        drain();
+        delete m_pRing;
+        m_pRing = NULL;
+    }
+#endif
+    //With no ring, a pending slot is read by waitFor() when it's needed.
+    slot->state = SLOT_PENDING;
+    //Let the kernel start reading while we decode what we already have.
+#if defined(__APPLE__)
+    struct radvisory advice;
+    advice.ra_offset = offset;
+    advice.ra_count = m_iBlockSize;
+    fcntl(m_fd, F_RDADVISE, &advice);
+#elif !defined(_WIN32)
+    posix_fadvise(m_fd, offset, m_iBlockSize, POSIX_FADV_WILLNEED);
+#endif
+}
+
+void AudioDecoderReadAheadSource::waitFor(Slot *slot)
+{
+    //A stall: the reader got ahead of the disk.
+    AUDIODECODER_TRACE_SCOPE_ARG("io", "ReadAhead::waitFor", "offset", slot->offset);
+#ifdef __linux__
+    while (m_pRing && slot->state == SLOT_PENDING) {
+        int slotIndex = 0;
+        int result = 0;
+        if (!m_pRing->reap(true, &slotIndex, &result)) {
+            break;
+        }
+        Slot *completed = &m_slots[slotIndex];
+        completed->bytes = result;
+        completed->state = SLOT_READY;
+    }
+#endif
+    if (slot->state == SLOT_PENDING) {
+        //The fallback path: the read happens now, hopefully from the page cache.
+#ifdef _WIN32
+        slot->bytes = AudioDecoderFileSource::pread(slot->data, m_iBlockSize, slot->offset);
+#else
+        //Always a whole block, even past the end of the file, to keep O_DIRECT happy.
+        slot->bytes = ::pread(m_fd, slot->data, m_iBlockSize, slot->offset);
+#endif
+        slot->state = SLOT_READY;
+    }
+}
+
+void AudioDecoderReadAheadSource::dropFromCache(long long offset, long long size)
+{
+#if !defined(_WIN32) && !defined(__APPLE__)
+    if (m_ioMode == IO_SCAN) {
+        posix_fadvise(m_fd, offset, size, POSIX_FADV_DONTNEED);
+    }
+#endif
+}
+
+void AudioDecoderReadAheadSource::drain()
+{
+    for (int i = 0; i < m_iQueueDepth; i++) {
+        if (m_pRing && m_slots[i].state == SLOT_PENDING) {
+            waitFor(&m_slots[i]);
+        }
+    }
+}
@@ -0,0 +1,380 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+
+#include <string.h>
+#include <chrono>
+#include "audiodecoder.h"
+#include "audiodecoderscheduler.h"
+#include "audiodecodertrace.h"
+
+//How long an idle worker sleeps before it looks again. The audio thread
+//never wakes the workers up, as that would mean taking a lock.
+const int kPollIntervalMs = 2;
+
+AudioDecoderScheduler::AudioDecoderScheduler(int numThreads, int blockFrames)
+: m_iBlockFrames(blockFrames > 0 ? blockFrames : 1024)
+, m_iNextBackground(0)
+, m_totalMisses(0)
+, m_quit(false)
+{
+    for (int i = 0; i < kMaxStreams; i++) {
+        m_streams[i] = NULL;
+    }
+    if (numThreads <= 0) {
+        numThreads = 1;
+    }
+    for (int i = 0; i < numThreads; i++) {
+        m_workers.push_back(std::thread(&AudioDecoderScheduler::workerLoop, this));
+    }
+}
+
+AudioDecoderScheduler::~AudioDecoderScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_wake.notify_all();
+    for (size_t i = 0; i < m_workers.size(); i++) {
+        m_workers[i].join();
+    }
+    for (int i = 0; i < kMaxStreams; i++) {
+        delete m_streams[i];
+    }
+}
+
+int AudioDecoderScheduler::addStream(AudioDecoder *decoder, int bufferFrames)
+{
+    return addStream(decoder, bufferFrames, false);
+}
+
+int AudioDecoderScheduler::addBackground(AudioDecoder *decoder)
+{
+    return addStream(decoder, 0, true);
+}
+
+int AudioDecoderScheduler::addStream(AudioDecoder *decoder, int bufferFrames, bool background)
+{
+    Stream *stream = new Stream();
+    stream->decoder = decoder;
+    stream->background = background;
+    stream->channels = decoder->channels() > 0 ? decoder->channels() : 2;
+    stream->sampleRate = decoder->sampleRate() > 0 ? decoder->sampleRate() : 44100;
+    if (!background) {
+        //At least two blocks, so there's always one to read while the next is decoded.
+        if (bufferFrames < 2 * m_iBlockFrames) {
+            bufferFrames = 2 * m_iBlockFrames;
+        }
+        stream->capacity = static_cast<long long>(bufferFrames) * stream->channels;
+        stream->ring.resize(static_cast<size_t>(stream->capacity));
+    } else {
+        stream->capacity = 0;
+    }
+    const long long position = decoder->positionInSamples();
+    stream->readPos.store(position);
+    stream->writePos.store(position);
+    stream->seekTarget.store(position);
+    stream->seekSerial.store(0);
+    stream->filledSerial.store(0);
+    stream->eof.store(false);
+    stream->rate.store(1.0);
+    stream->misses.store(0);
+    stream->busy = false;
+    stream->removing = false;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (int id = 0; id < kMaxStreams; id++) {
+        if (!m_streams[id]) {
+            m_streams[id] = stream;
+            m_wake.notify_all();
+            return id;
+        }
+    }
+    delete stream;
+    return AUDIODECODER_ERROR;
+}
+
+void AudioDecoderScheduler::removeStream(int id)
+{
+    if (id < 0 || id >= kMaxStreams) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(m_mutex);
+    Stream *stream = m_streams[id];
+    if (!stream) {
+        return;
+    }
+    stream->removing = true;
+    while (stream->busy) {
+        m_idle.wait(lock);
+    }
+    m_streams[id] = NULL;
+    delete stream;
+}
+
+void AudioDecoderScheduler::setRate(int id, double rate)
+{
+    m_streams[id]->rate.store(rate, std::memory_order_relaxed);
+}
+
+int AudioDecoderScheduler::available(const Stream *stream) const
+{
+    if (stream->filledSerial.load(std::memory_order_acquire) !=
+        stream->seekSerial.load(std::memory_order_relaxed)) {
+        return 0; // a seek hasn't been served yet
+    }
+    return static_cast<int>(stream->writePos.load(std::memory_order_acquire) -
+                            stream->readPos.load(std::memory_order_relaxed));
+}
+
+/** Copies size samples out of the ring, which must have them. */
+void AudioDecoderScheduler::consume(Stream *stream, int size, SAMPLE *buffer)
+{
+    const long long readPos = stream->readPos.load(std::memory_order_relaxed);
+    const long long start = readPos % stream->capacity;
+    const long long first = size < stream->capacity - start ? size : stream->capacity - start;
+    memcpy(buffer, &stream->ring[static_cast<size_t>(start)], first * sizeof(SAMPLE));
+    memcpy(buffer + first, &stream->ring[0], (size - first) * sizeof(SAMPLE));
+    stream->readPos.store(readPos + size, std::memory_order_release);
+}
+
+int AudioDecoderScheduler::read(int id, int size, const SAMPLE *buffer)
+{
+    Stream *stream = m_streams[id];
+    int count = available(stream);
+    if (count > size) {
+        count = size;
+    }
+    count -= count % stream->channels;
+    consume(stream, count, const_cast<SAMPLE*>(buffer));
+    if (count < size && !isFinished(id)) {
+        stream->misses.fetch_add(1, std::memory_order_relaxed);
+        m_totalMisses.fetch_add(1, std::memory_order_relaxed);
+    }
+    return count;
+}
+
+int AudioDecoderScheduler::readSynchronized(const int *ids, int count, int frames,
+                                            SAMPLE *const *buffers)
+{
+    int ready = frames;
+    for (int i = 0; i < count; i++) {
+        const Stream *stream = m_streams[ids[i]];
+        const int streamFrames = available(stream) / stream->channels;
+        if (streamFrames < ready) {
+            ready = streamFrames;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        Stream *stream = m_streams[ids[i]];
+        if (ready < frames && available(stream) < frames * stream->channels && !isFinished(ids[i])) {
+            stream->misses.fetch_add(1, std::memory_order_relaxed);
+            m_totalMisses.fetch_add(1, std::memory_order_relaxed);
+        }
+        consume(stream, ready * stream->channels, buffers[i]);
+    }
+    return ready;
+}
+
+int AudioDecoderScheduler::seek(int id, int sampleIdx)
+{
+    Stream *stream = m_streams[id];
+    if (sampleIdx < 0) {
+        sampleIdx = 0;
+    }
+    sampleIdx -= sampleIdx % stream->channels;
+    //The worker reads the target after it sees the new serial.
+    stream->readPos.store(sampleIdx, std::memory_order_relaxed);
+    stream->seekTarget.store(sampleIdx, std::memory_order_relaxed);
+    stream->seekSerial.store(stream->seekSerial.load(std::memory_order_relaxed) + 1,
+                             std::memory_order_release);
+    return sampleIdx;
+}
+
+bool AudioDecoderScheduler::isFinished(int id) const
+{
+    const Stream *stream = m_streams[id];
+    if (stream->background) {
+        return stream->eof.load(std::memory_order_acquire);
+    }
+    if (stream->filledSerial.load(std::memory_order_acquire) !=
+        stream->seekSerial.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    //eof first: once it's set, writePos has stopped moving and is up to date.
+    return stream->eof.load(std::memory_order_acquire) && available(stream) == 0;
+}
+
+int AudioDecoderScheduler::bufferedSamples(int id) const
+{
+    return available(m_streams[id]);
+}
+
+long long AudioDecoderScheduler::deadlineMisses(int id) const
+{
+    return m_streams[id]->misses.load(std::memory_order_relaxed);
+}
+
+long long AudioDecoderScheduler::totalDeadlineMisses() const
+{
+    return m_totalMisses.load(std::memory_order_relaxed);
+}
+
+void AudioDecoderScheduler::workerLoop()
+{
+    std::vector<SAMPLE> scratch;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_quit) {
+        Stream *stream = pickStream();
+        if (!stream) {
+            m_wake.wait_for(lock, std::chrono::milliseconds(kPollIntervalMs));
+            continue;
+        }
+        stream->busy = true;
+        lock.unlock();
+        decodeBlock(stream, &scratch);
+        lock.lock();
+        stream->busy = false;
+        if (stream->removing) {
+            m_idle.notify_all();
+        }
+    }
+}
+
+/** Earliest deadline first: the playing stream whose ring will run dry
+    soonest, and a stream waiting on a seek before anything. Paused streams
+    and then background jobs only get what's left. Called with m_mutex held. */
+AudioDecoderScheduler::Stream *AudioDecoderScheduler::pickStream()
+{
+    Stream *urgent = NULL;
+    double urgentDeadline = 0;
+    Stream *paused = NULL;
+    for (int id = 0; id < kMaxStreams; id++) {
+        Stream *stream = m_streams[id];
+        if (!stream || stream->busy || stream->removing || stream->background) {
+            continue;
+        }
+        double deadline; // seconds until the ring is empty
+        if (stream->seekSerial.load(std::memory_order_acquire) !=
+            stream->filledSerial.load(std::memory_order_relaxed)) {
+            deadline = -1;
+        } else {
+            if (stream->eof.load(std::memory_order_relaxed)) {
+                continue;
+            }
+            const long long buffered = stream->writePos.load(std::memory_order_relaxed) -
+                                       stream->readPos.load(std::memory_order_acquire);
+            if (stream->capacity - buffered < static_cast<long long>(m_iBlockFrames) * stream->channels) {
+                continue; // full
+            }
+            const double rate = stream->rate.load(std::memory_order_relaxed);
+            if (rate <= 0) {
+                if (!paused) {
+                    paused = stream;
+                }
+                continue;
+            }
+            deadline = buffered / (static_cast<double>(stream->channels) * stream->sampleRate * rate);
+        }
+        if (!urgent || deadline < urgentDeadline) {
+            urgent = stream;
+            urgentDeadline = deadline;
+        }
+    }
+    if (urgent) {
+        return urgent;
+    }
+    if (paused) {
+        return paused;
+    }
+    for (int i = 0; i < kMaxStreams; i++) {
+        const int id = (m_iNextBackground + i) % kMaxStreams;
+        Stream *stream = m_streams[id];
+        if (stream && stream->background && !stream->busy && !stream->removing &&
+            !stream->eof.load(std::memory_order_relaxed)) {
+            m_iNextBackground = id + 1;
+            return stream;
+        }
+    }
+    return NULL;
+}
+
+/** One block of one stream, without the lock. Only one worker at a time
+    decodes a given stream. */
+void AudioDecoderScheduler::decodeBlock(Stream *stream, std::vector<SAMPLE> *scratch)
+{
+    AUDIODECODER_TRACE_SCOPE("scheduler", "decodeBlock");
+    const int blockSamples = m_iBlockFrames * stream->channels;
+    if (scratch->size() < static_cast<size_t>(blockSamples)) {
+        scratch->resize(blockSamples);
+    }
+
+    if (stream->background) {
+        if (stream->decoder->read(blockSamples, &(*scratch)[0]) < blockSamples) {
+            stream->eof.store(true, std::memory_order_release);
+        }
+        return;
+    }
+
+    const int serial = stream->seekSerial.load(std::memory_order_acquire);
+    if (serial != stream->filledSerial.load(std::memory_order_relaxed)) {
+        const long long target = stream->seekTarget.load(std::memory_order_relaxed);
+        stream->decoder->seek(static_cast<int>(target));
+        stream->eof.store(false, std::memory_order_relaxed);
+        stream->writePos.store(target, std::memory_order_relaxed);
+        stream->filledSerial.store(serial, std::memory_order_release);
+        return; // with nothing buffered it's the most urgent, so it'll be right back
+    }
+
+    const long long writePos = stream->writePos.load(std::memory_order_relaxed);
+    const long long buffered = writePos - stream->readPos.load(std::memory_order_acquire);
+    if (stream->capacity - buffered < blockSamples) {
+        return;
+    }
+    const int samplesRead = stream->decoder->read(blockSamples, &(*scratch)[0]);
+    const long long start = writePos % stream->capacity;
+    const long long first = samplesRead < stream->capacity - start ? samplesRead : stream->capacity - start;
+    memcpy(&stream->ring[static_cast<size_t>(start)], &(*scratch)[0], first * sizeof(SAMPLE));
+    memcpy(&stream->ring[0], &(*scratch)[static_cast<size_t>(first)], (samplesRead - first) * sizeof(SAMPLE));
+    //writePos before eof, so whoever sees eof also sees the last block.
+    stream->writePos.store(writePos + samplesRead, std::memory_order_release);
+    if (samplesRead < blockSamples) {
+        stream->eof.store(true, std::memory_order_release);
+    }
+}
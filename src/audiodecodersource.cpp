@@ -0,0 +1,245 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "audiodecodersource.h"
+
+#ifdef _WIN32
+/** Opens a UTF-8 path for reading with the wide-char API. */
+static HANDLE openForReading(const std::string& filename, DWORD flags)
+{
+    wchar_t wcFilename[248 + 260];
+    if (MultiByteToWideChar(CP_UTF8, 0, filename.c_str(), -1, wcFilename,
+                            sizeof(wcFilename) / sizeof(wcFilename[0])) == 0) {
+        return INVALID_HANDLE_VALUE;
+    }
+    return CreateFileW(wcFilename, GENERIC_READ, FILE_SHARE_READ, NULL,
+                       OPEN_EXISTING, flags, NULL);
+}
+#endif
+
+long long AudioDecoderSource::read(void *buffer, long long size)
+{
+    long long bytesRead = pread(buffer, size, m_position);
+    if (bytesRead > 0) {
+        m_position += bytesRead;
+    }
+    return bytesRead;
+}
+
+int AudioDecoderSource::seek(long long position)
+{
+    if (position < 0) {
+        return AUDIODECODER_ERROR;
+    }
+    m_position = position;
+    return AUDIODECODER_OK;
+}
+
+//-------------------------------------------------------------------
+// AudioDecoderFileSource
+//-------------------------------------------------------------------
+
+AudioDecoderFileSource::AudioDecoderFileSource(const std::string filename)
+: m_size(-1)
+{
+#ifdef _WIN32
+    m_hFile = openForReading(filename, FILE_ATTRIBUTE_NORMAL);
+    LARGE_INTEGER fileSize;
+    if (m_hFile != INVALID_HANDLE_VALUE && GetFileSizeEx(m_hFile, &fileSize)) {
+        m_size = fileSize.QuadPart;
+    }
+#else
+    m_fd = ::open(filename.c_str(), O_RDONLY);
+    struct stat st;
+    if (m_fd >= 0 && fstat(m_fd, &st) == 0) {
+        m_size = st.st_size;
+    }
+#endif
+}
+
+AudioDecoderFileSource::~AudioDecoderFileSource()
+{
+#ifdef _WIN32
+    if (m_hFile != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_hFile);
+    }
+#else
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+#endif
+}
+
+long long AudioDecoderFileSource::pread(void *buffer, long long size, long long offset)
+{
+    if (m_size < 0 || offset < 0 || size < 0) {
+        return -1;
+    }
+    if (offset >= m_size) {
+        return 0;
+    }
+    if (size > m_size - offset) {
+        size = m_size - offset;
+    }
+    long long total = 0;
+    while (total < size) {
+#ifdef _WIN32
+        //An OVERLAPPED offset on a synchronous handle is Windows' pread.
+        OVERLAPPED overlapped;
+        memset(&overlapped, 0, sizeof(overlapped));
+        overlapped.Offset = static_cast<DWORD>((offset + total) & 0xFFFFFFFF);
+        overlapped.OffsetHigh = static_cast<DWORD>((offset + total) >> 32);
+        DWORD chunk = static_cast<DWORD>(size - total > 0x40000000 ? 0x40000000 : size - total);
+        DWORD bytesRead = 0;
+        if (!ReadFile(m_hFile, static_cast<char*>(buffer) + total, chunk, &bytesRead, &overlapped)) {
+            return total > 0 ? total : -1;
+        }
+#else
+        ssize_t bytesRead = ::pread(m_fd, static_cast<char*>(buffer) + total,
+                                    static_cast<size_t>(size - total), offset + total);
+        if (bytesRead < 0) {
+            return total > 0 ? total : -1;
+        }
+#endif
+        if (bytesRead == 0) {
+            break;
+        }
+        total += bytesRead;
+    }
+    return total;
+}
+
+//-------------------------------------------------------------------
+// AudioDecoderMmapSource
+//-------------------------------------------------------------------
+
+AudioDecoderMmapSource::AudioDecoderMmapSource(const std::string filename)
+: m_pData(NULL)
+, m_size(-1)
+{
+#ifdef _WIN32
+    m_hMapping = NULL;
+    HANDLE hFile = openForReading(filename, FILE_ATTRIBUTE_NORMAL);
+    LARGE_INTEGER fileSize;
+    if (hFile == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    if (GetFileSizeEx(hFile, &fileSize) && fileSize.QuadPart > 0) {
+        m_hMapping = CreateFileMappingW(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (m_hMapping) {
+            m_pData = static_cast<const unsigned char*>(
+                MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0));
+        }
+        if (m_pData) {
+            m_size = fileSize.QuadPart;
+        }
+    }
+    //The mapping keeps the file open.
+    CloseHandle(hFile);
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0) {
+        return;
+    }
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void *data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (data != MAP_FAILED) {
+            m_pData = static_cast<const unsigned char*>(data);
+            m_size = st.st_size;
+        }
+    }
+    ::close(fd);
+#endif
+}
+
+AudioDecoderMmapSource::~AudioDecoderMmapSource()
+{
+#ifdef _WIN32
+    if (m_pData) {
+        UnmapViewOfFile(m_pData);
+    }
+    if (m_hMapping) {
+        CloseHandle(m_hMapping);
+    }
+#else
+    if (m_pData) {
+        munmap(const_cast<unsigned char*>(m_pData), m_size);
+    }
+#endif
+}
+
+/** memcpy out of a span, shared by the mmap and memory sources. */
+static long long copyFromSpan(const unsigned char *data, long long dataSize,
+                              void *buffer, long long size, long long offset)
+{
+    if (!data || offset < 0 || size < 0) {
+        return -1;
+    }
+    if (offset >= dataSize) {
+        return 0;
+    }
+    if (size > dataSize - offset) {
+        size = dataSize - offset;
+    }
+    memcpy(buffer, data + offset, static_cast<size_t>(size));
+    return size;
+}
+
+long long AudioDecoderMmapSource::pread(void *buffer, long long size, long long offset)
+{
+    return copyFromSpan(m_pData, m_size, buffer, size, offset);
+}
+
+//-------------------------------------------------------------------
+// AudioDecoderMemorySource
+//-------------------------------------------------------------------
+
+long long AudioDecoderMemorySource::pread(void *buffer, long long size, long long offset)
+{
+    return copyFromSpan(m_pData, m_size, buffer, size, offset);
+}
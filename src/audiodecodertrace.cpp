@@ -0,0 +1,269 @@
+/*
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * libaudiodecoder API Header File
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+#include "audiodecodertrace.h"
+
+namespace {
+
+struct TraceEvent
+{
+    const char *category;
+    const char *name;
+    const char *argName; // NULL when there's no argument
+    long long arg;
+    long long begin; // ns since the trace epoch
+    long long duration; // ns
+};
+
+/** One thread's events. Only its thread writes events and m_written; readers
+    take a consistent copy by checking m_written again afterwards. */
+struct ThreadBuffer
+{
+    TraceEvent events[AudioDecoderTrace::kEventsPerThread];
+    std::atomic<unsigned long long> written;
+    std::atomic<unsigned long long> cleared; // events before this are forgotten
+    int tid;
+    std::string name; // guarded by the registry's mutex
+};
+
+struct Registry
+{
+    std::mutex mutex;
+    std::vector<ThreadBuffer*> buffers; // never freed: a thread's spans outlive it
+    std::atomic<bool> recording;
+    std::chrono::steady_clock::time_point epoch;
+
+    Registry() : recording(false), epoch(std::chrono::steady_clock::now()) {}
+};
+
+Registry& registry()
+{
+    static Registry *s_registry = new Registry(); // leaked, so it outlives every thread
+    return *s_registry;
+}
+
+thread_local ThreadBuffer *t_buffer = NULL;
+
+ThreadBuffer *threadBuffer()
+{
+    if (!t_buffer) {
+        //The only allocation, and the only lock, a thread ever takes to record.
+        ThreadBuffer *buffer = new ThreadBuffer();
+        buffer->written.store(0, std::memory_order_relaxed);
+        buffer->cleared.store(0, std::memory_order_relaxed);
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        buffer->tid = static_cast<int>(reg.buffers.size()) + 1;
+        reg.buffers.push_back(buffer);
+        t_buffer = buffer;
+    }
+    return t_buffer;
+}
+
+long long now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - registry().epoch).count();
+}
+
+/** Appends s as a JSON string, quotes included. */
+void appendQuoted(std::string *out, const std::string& s)
+{
+    out->push_back('"');
+    for (size_t i = 0; i < s.size(); i++) {
+        const unsigned char c = s[i];
+        if (c == '"' || c == '\\') {
+            out->push_back('\\');
+            out->push_back(c);
+        } else if (c < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out->append(escaped);
+        } else {
+            out->push_back(c);
+        }
+    }
+    out->push_back('"');
+}
+
+} // namespace
+
+void AudioDecoderTrace::start()
+{
+    registry().recording.store(true, std::memory_order_relaxed);
+}
+
+void AudioDecoderTrace::stop()
+{
+    registry().recording.store(false, std::memory_order_relaxed);
+}
+
+bool AudioDecoderTrace::isRecording()
+{
+    return registry().recording.load(std::memory_order_relaxed);
+}
+
+void AudioDecoderTrace::clear()
+{
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (size_t i = 0; i < reg.buffers.size(); i++) {
+        ThreadBuffer *buffer = reg.buffers[i];
+        buffer->cleared.store(buffer->written.load(std::memory_order_acquire),
+                              std::memory_order_relaxed);
+    }
+}
+
+void AudioDecoderTrace::setThreadName(const char *name)
+{
+    ThreadBuffer *buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    buffer->name = name ? name : "";
+}
+
+std::string AudioDecoderTrace::toJson()
+{
+#ifdef _WIN32
+    const int pid = _getpid();
+#else
+    const int pid = getpid();
+#endif
+    const unsigned long long kCapacity = kEventsPerThread;
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    std::string json = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    std::vector<TraceEvent> events;
+    char line[160];
+    for (size_t i = 0; i < reg.buffers.size(); i++) {
+        ThreadBuffer *buffer = reg.buffers[i];
+        if (!buffer->name.empty()) {
+            snprintf(line, sizeof(line),
+                     "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":",
+                     first ? "" : ",", pid, buffer->tid);
+            json += line;
+            appendQuoted(&json, buffer->name);
+            json += "}}";
+            first = false;
+        }
+
+        //Copy what's there, then throw away anything the thread may have
+        //overwritten while we were copying: it can be one event past what it
+        //has published.
+        const unsigned long long cleared = buffer->cleared.load(std::memory_order_relaxed);
+        const unsigned long long written = buffer->written.load(std::memory_order_acquire);
+        unsigned long long from = written > kCapacity ? written - kCapacity : 0;
+        if (from < cleared) {
+            from = cleared;
+        }
+        events.clear();
+        for (unsigned long long n = from; n < written; n++) {
+            events.push_back(buffer->events[n % kCapacity]);
+        }
+        const unsigned long long after = buffer->written.load(std::memory_order_acquire);
+        const unsigned long long stale = after + 1 > kCapacity ? after + 1 - kCapacity : 0;
+        size_t skip = stale > from ? static_cast<size_t>(stale - from) : 0;
+
+        for (size_t e = skip; e < events.size(); e++) {
+            const TraceEvent& event = events[e];
+            snprintf(line, sizeof(line),
+                     "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%d",
+                     first ? "" : ",", event.name, event.category,
+                     event.begin / 1000.0, event.duration / 1000.0, pid, buffer->tid);
+            json += line;
+            if (event.argName) {
+                snprintf(line, sizeof(line), ",\"args\":{\"%s\":%lld}", event.argName, event.arg);
+                json += line;
+            }
+            json += "}";
+            first = false;
+        }
+    }
+    json += "]}\n";
+    return json;
+}
+
+int AudioDecoderTrace::save(const std::string& path)
+{
+    FILE *file = fopen(path.c_str(), "wb");
+    if (!file) {
+        return AUDIODECODER_ERROR;
+    }
+    const std::string json = toJson();
+    const bool ok = fwrite(json.data(), 1, json.size(), file) == json.size();
+    return fclose(file) == 0 && ok ? AUDIODECODER_OK : AUDIODECODER_ERROR;
+}
+
+AudioDecoderTraceScope::AudioDecoderTraceScope(const char *category, const char *name,
+                                               const char *argName, long long arg)
+: m_category(category)
+, m_name(name)
+, m_argName(argName)
+, m_arg(arg)
+, m_begin(AudioDecoderTrace::isRecording() ? now() : -1)
+{
+}
+
+AudioDecoderTraceScope::~AudioDecoderTraceScope()
+{
+    if (m_begin < 0) {
+        return;
+    }
+    ThreadBuffer *buffer = threadBuffer();
+    const unsigned long long n = buffer->written.load(std::memory_order_relaxed);
+    TraceEvent& event = buffer->events[n % AudioDecoderTrace::kEventsPerThread];
+    event.category = m_category;
+    event.name = m_name;
+    event.argName = m_argName;
+    event.arg = m_arg;
+    event.begin = m_begin;
+    event.duration = now() - m_begin;
+    buffer->written.store(n + 1, std::memory_order_release);
+}
@@ -0,0 +1,85 @@
+/*
+ * test_allocator - The read path makes no allocations of its own once warm.
+ *
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+/*
+ * Only allocations through the decoder's allocator are counted; see
+ * audiodecoderallocator.h for what that leaves out.
+ */
+
+#include "audiodecoder.h"
+#include "audiodecoderallocator.h"
+#include "testing.h"
+
+int main()
+{
+    const int kSampleRate = 44100;
+    const int kFrames = kSampleRate * 5;
+    const std::string path = writeTestFile("test_allocator.wav", makeWav(kFrames, 2, kSampleRate));
+    CHECK(!path.empty());
+
+    AudioDecoderCountingAllocator counter;
+    AudioDecoder decoder(path);
+    decoder.setAllocator(&counter);
+    CHECK_EQ(decoder.open(), AUDIODECODER_OK);
+    const long long opened = counter.allocations();
+    counter.setForbidden(true);
+
+    //From the first call on: every read size, seeks and views, to the end of the file.
+    static SAMPLE buffer[65536];
+    AudioDecoderView view;
+    const int kSizes[] = { 1, 2, 100, 4096, 10000, 65536 };
+    const int kSeeks[] = { kFrames, 0, kFrames / 2, 2 * kFrames - 2, 12345 * 2 };
+    for (int s = 0; s < 5; s++) {
+        decoder.seek(kSeeks[s]);
+        for (int i = 0; i < 200; i++) {
+            decoder.read(kSizes[i % 6], buffer);
+            decoder.readView(&view);
+        }
+    }
+    decoder.seek(0);
+    while (decoder.read(65536, buffer) > 0) {
+    }
+    while (decoder.readView(&view) > 0) {
+    }
+
+    CHECK(decoder.positionInSamples() > 0);
+    CHECK_EQ(counter.allocations(), opened);
+    CHECK_EQ(counter.violations(), 0);
+    return testResult();
+}
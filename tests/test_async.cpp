@@ -0,0 +1,175 @@
+/*
+ * test_async - AudioDecoderAsync callbacks and coroutines against a blocking decode.
+ *
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+/*
+ * The coroutine half only builds where the compiler has C++20 coroutines;
+ * CMake builds this test as C++20 when it can.
+ */
+
+#include <future>
+#include "audiodecoder.h"
+#include "audiodecoderasync.h"
+#include "testing.h"
+
+static const int kFrames = 30000;
+static const int kReadSize = 1000;
+
+static std::vector<SAMPLE> decodeAll(const std::string& path)
+{
+    AudioDecoder decoder(path);
+    std::vector<SAMPLE> samples;
+    if (decoder.open() != AUDIODECODER_OK) {
+        return samples;
+    }
+    SAMPLE buffer[kReadSize];
+    int got;
+    while ((got = decoder.read(kReadSize, buffer)) > 0) {
+        samples.insert(samples.end(), buffer, buffer + got);
+    }
+    return samples;
+}
+
+/** Blocks until a callback has been called, and gives what it was called with. */
+class Waiter
+{
+    public:
+        AudioDecoderAsync::Callback callback()
+        {
+            std::promise<int> *promise = &m_promise;
+            return [promise](int result) { promise->set_value(result); };
+        }
+        int wait() { return m_promise.get_future().get(); }
+
+    private:
+        std::promise<int> m_promise;
+};
+
+static void testCallbacks(const std::string& path, const std::vector<SAMPLE>& reference)
+{
+    AudioDecoderThreadPoolExecutor executor(4);
+    AudioDecoder decoder(path);
+    AudioDecoderAsync async(&decoder, &executor);
+    Waiter opened;
+    async.openAsync(opened.callback());
+    CHECK_EQ(opened.wait(), AUDIODECODER_OK);
+
+    //Many reads at once, on four threads: they still run in order.
+    const int kReads = 2 * kFrames / kReadSize + 1;
+    std::vector<SAMPLE> samples(kReads * kReadSize);
+    std::vector<int> results(kReads, -1);
+    Waiter last;
+    for (int i = 0; i < kReads; i++) {
+        int *result = &results[i];
+        async.readAsync(kReadSize, &samples[i * kReadSize], [result](int got) { *result = got; });
+    }
+    async.seekAsync(0, last.callback());
+    CHECK_EQ(last.wait(), 0);
+    int total = 0;
+    for (int i = 0; i < kReads; i++) {
+        CHECK(results[i] >= 0);
+        total += results[i];
+    }
+    CHECK_EQ(total, static_cast<int>(reference.size()));
+    samples.resize(total);
+    CHECK(samples == reference);
+}
+
+#ifdef AUDIODECODER_HAS_COROUTINES
+/** Runs from the start, and nobody waits on it. */
+struct Detached
+{
+    struct promise_type
+    {
+        Detached get_return_object() { return Detached(); }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+static Detached decodeWithCoroutine(AudioDecoderAsync *async, std::vector<SAMPLE> *samples,
+                                    std::promise<void> *done)
+{
+    if (co_await async->openAsync() == AUDIODECODER_OK &&
+        co_await async->seekAsync(0) == 0) {
+        SAMPLE buffer[kReadSize];
+        int got;
+        while ((got = co_await async->readAsync(kReadSize, buffer)) > 0) {
+            samples->insert(samples->end(), buffer, buffer + got);
+        }
+    }
+    done->set_value();
+}
+
+static void testCoroutines(const std::string& path, const std::vector<SAMPLE>& reference)
+{
+    //Several at once, so callbacks often resume a coroutine before the
+    //await that suspended it has returned.
+    const int kDecoders = 8;
+    AudioDecoderThreadPoolExecutor executor(4);
+    std::vector<AudioDecoder*> decoders;
+    std::vector<AudioDecoderAsync*> asyncs;
+    std::vector<std::vector<SAMPLE> > samples(kDecoders);
+    std::vector<std::promise<void> > done(kDecoders);
+    for (int i = 0; i < kDecoders; i++) {
+        decoders.push_back(new AudioDecoder(path));
+        asyncs.push_back(new AudioDecoderAsync(decoders[i], &executor));
+        decodeWithCoroutine(asyncs[i], &samples[i], &done[i]);
+    }
+    for (int i = 0; i < kDecoders; i++) {
+        done[i].get_future().wait();
+        CHECK(samples[i] == reference);
+        delete asyncs[i];
+        delete decoders[i];
+    }
+}
+#endif
+
+int main()
+{
+    const std::string path = writeTestFile("test_async.wav", makeWav(kFrames, 2, 44100));
+    const std::vector<SAMPLE> reference = decodeAll(path);
+    CHECK_EQ(reference.size(), 2 * kFrames);
+    testCallbacks(path, reference);
+#ifdef AUDIODECODER_HAS_COROUTINES
+    testCoroutines(path, reference);
+#endif
+    return testResult();
+}
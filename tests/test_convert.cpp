@@ -0,0 +1,161 @@
+/*
+ * test_convert - The specialized PCM converters against a generic conversion.
+ *
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+#include <stdint.h>
+#include "audiodecoderconvert.h"
+#include "testing.h"
+
+/** One sample at a time, deciding the format every time: slow and obvious. */
+static SAMPLE genericSample(const unsigned char *src, size_t i, AudioDecoderConvert::Format format)
+{
+    switch (format) {
+        case AudioDecoderConvert::FORMAT_U8:
+            return (static_cast<int>(src[i]) - 128) / 128.0f;
+        case AudioDecoderConvert::FORMAT_S16: {
+            int16_t v;
+            memcpy(&v, src + i * 2, 2);
+            return v / 32768.0f;
+        }
+        case AudioDecoderConvert::FORMAT_S24: {
+            int32_t v = src[i * 3] | (src[i * 3 + 1] << 8) | (src[i * 3 + 2] << 16);
+            if (v & 0x800000) {
+                v -= 0x1000000;
+            }
+            return v / 8388608.0f;
+        }
+        case AudioDecoderConvert::FORMAT_S32: {
+            int32_t v;
+            memcpy(&v, src + i * 4, 4);
+            return static_cast<float>(v) / 2147483648.0f;
+        }
+        case AudioDecoderConvert::FORMAT_F32:
+        default: {
+            float v;
+            memcpy(&v, src + i * 4, 4);
+            return v;
+        }
+    }
+}
+
+static void testAgainstGeneric()
+{
+    const AudioDecoderConvert::Format kFormats[] = {
+        AudioDecoderConvert::FORMAT_U8, AudioDecoderConvert::FORMAT_S16, AudioDecoderConvert::FORMAT_S24,
+        AudioDecoderConvert::FORMAT_S32, AudioDecoderConvert::FORMAT_F32
+    };
+    const int kChannels[] = { 1, 2, 3, 6 };
+    std::vector<unsigned char> src(67 * 6 * 4);
+    unsigned int state = 7;
+    for (size_t i = 0; i < src.size(); i++) {
+        state = state * 1103515245 + 12345;
+        src[i] = static_cast<unsigned char>(state >> 16);
+    }
+
+    for (int f = 0; f < 5; f++) {
+        if (kFormats[f] == AudioDecoderConvert::FORMAT_F32) {
+            //Random bytes would make NaNs, which never compare equal.
+            for (size_t i = 0; i + 4 <= src.size(); i += 4) {
+                float v = (static_cast<int>(i % 2001) - 1000) / 1000.0f;
+                memcpy(&src[i], &v, 4);
+            }
+        }
+        for (int c = 0; c < 4; c++) {
+            const int channels = kChannels[c];
+            AudioDecoderConvertFn convert = AudioDecoderConvert::select(kFormats[f], channels);
+            CHECK(convert != NULL);
+            //Every length up to a few vectors, to cover the tails.
+            for (size_t frames = 0; frames <= 67; frames++) {
+                std::vector<SAMPLE> dest(frames * channels + 1, -99.0f);
+                convert(&src[0], &dest[0], frames, channels);
+                bool same = dest[frames * channels] == -99.0f; // nothing written past the end
+                for (size_t i = 0; i < frames * channels; i++) {
+                    same = same && dest[i] == genericSample(&src[0], i, kFormats[f]);
+                }
+                if (!same) {
+                    fprintf(stderr, "format %d, %d channels, %d frames: differs from the generic path\n",
+                            static_cast<int>(kFormats[f]), channels, static_cast<int>(frames));
+                    g_testFailures++;
+                }
+            }
+        }
+    }
+}
+
+static void testFullScale()
+{
+    SAMPLE out[2];
+    const unsigned char u8[2] = { 0, 128 };
+    AudioDecoderConvert::select(AudioDecoderConvert::FORMAT_U8, 2)(u8, out, 1, 2);
+    CHECK(out[0] == -1.0f && out[1] == 0.0f);
+
+    const int16_t s16[2] = { -32768, 16384 };
+    AudioDecoderConvert::select(AudioDecoderConvert::FORMAT_S16, 2)(s16, out, 1, 2);
+    CHECK(out[0] == -1.0f && out[1] == 0.5f);
+
+    const unsigned char s24[6] = { 0x00, 0x00, 0x80, 0x00, 0x00, 0x40 };
+    AudioDecoderConvert::select(AudioDecoderConvert::FORMAT_S24, 2)(s24, out, 1, 2);
+    CHECK(out[0] == -1.0f && out[1] == 0.5f);
+
+    const int32_t s32[2] = { INT32_MIN, 1 << 30 };
+    AudioDecoderConvert::select(AudioDecoderConvert::FORMAT_S32, 2)(s32, out, 1, 2);
+    CHECK(out[0] == -1.0f && out[1] == 0.5f);
+}
+
+static void testFormats()
+{
+    AudioDecoderConvert::Format format;
+    CHECK(AudioDecoderConvert::formatForBits(8, &format) && format == AudioDecoderConvert::FORMAT_U8);
+    CHECK(AudioDecoderConvert::formatForBits(16, &format) && format == AudioDecoderConvert::FORMAT_S16);
+    CHECK(AudioDecoderConvert::formatForBits(24, &format) && format == AudioDecoderConvert::FORMAT_S24);
+    CHECK(AudioDecoderConvert::formatForBits(32, &format) && format == AudioDecoderConvert::FORMAT_S32);
+    CHECK(!AudioDecoderConvert::formatForBits(12, &format));
+    CHECK_EQ(AudioDecoderConvert::bytesPerSample(AudioDecoderConvert::FORMAT_U8), 1);
+    CHECK_EQ(AudioDecoderConvert::bytesPerSample(AudioDecoderConvert::FORMAT_S16), 2);
+    CHECK_EQ(AudioDecoderConvert::bytesPerSample(AudioDecoderConvert::FORMAT_S24), 3);
+    CHECK_EQ(AudioDecoderConvert::bytesPerSample(AudioDecoderConvert::FORMAT_S32), 4);
+    CHECK_EQ(AudioDecoderConvert::bytesPerSample(AudioDecoderConvert::FORMAT_F32), 4);
+}
+
+int main()
+{
+    testAgainstGeneric();
+    testFullScale();
+    testFormats();
+    return testResult();
+}
@@ -0,0 +1,148 @@
+/*
+ * test_fanout - AudioDecoderFanOut cursors against a plain decode.
+ *
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+#include <thread>
+#include "audiodecoder.h"
+#include "audiodecoderfanout.h"
+#include "testing.h"
+
+static const int kFrames = 44100;
+
+/** The whole file through a decoder of its own, for comparison. */
+static std::vector<SAMPLE> decodeAll(const std::string& path)
+{
+    AudioDecoder decoder(path);
+    std::vector<SAMPLE> samples;
+    if (decoder.open() != AUDIODECODER_OK) {
+        return samples;
+    }
+    SAMPLE buffer[4096];
+    int got;
+    while ((got = decoder.read(4096, buffer)) > 0) {
+        samples.insert(samples.end(), buffer, buffer + got);
+    }
+    return samples;
+}
+
+/** Reads a cursor to the end, readSize samples at a time. */
+static std::vector<SAMPLE> readAll(AudioDecoderFanOutCursor *cursor, int readSize)
+{
+    std::vector<SAMPLE> samples;
+    std::vector<SAMPLE> buffer(readSize);
+    int got;
+    while ((got = cursor->read(readSize, &buffer[0])) > 0) {
+        samples.insert(samples.end(), buffer.begin(), buffer.begin() + got);
+    }
+    return samples;
+}
+
+static void testCursorsOnThreads(const std::string& path, const std::vector<SAMPLE>& reference)
+{
+    AudioDecoder decoder(path);
+    CHECK_EQ(decoder.open(), AUDIODECODER_OK);
+    //A small ring, so it wraps many times and the cursors hold each other up.
+    AudioDecoderFanOut fanOut(&decoder, 4, 256, AudioDecoderFanOut::BACKPRESSURE_BLOCK);
+    const int kReadSizes[] = { 1, 300, 1024, 5000 };
+    AudioDecoderFanOutCursor *cursors[4];
+    std::vector<SAMPLE> results[4];
+    std::thread threads[4];
+    for (int i = 0; i < 4; i++) {
+        cursors[i] = fanOut.createCursor();
+    }
+    for (int i = 0; i < 4; i++) {
+        threads[i] = std::thread([&, i] { results[i] = readAll(cursors[i], kReadSizes[i]); });
+    }
+    for (int i = 0; i < 4; i++) {
+        threads[i].join();
+        CHECK(results[i] == reference);
+        delete cursors[i];
+    }
+}
+
+static void testSeekAndDetach(const std::string& path, const std::vector<SAMPLE>& reference)
+{
+    AudioDecoder decoder(path);
+    CHECK_EQ(decoder.open(), AUDIODECODER_OK);
+    AudioDecoderFanOut fanOut(&decoder, 4, 256, AudioDecoderFanOut::BACKPRESSURE_DETACH);
+    AudioDecoderFanOutCursor *fast = fanOut.createCursor();
+    AudioDecoderFanOutCursor *slow = fanOut.createCursor();
+    SAMPLE buffer[1000];
+
+    //Seeking back inside the ring is served from it.
+    CHECK_EQ(fast->read(1000, buffer), 1000);
+    CHECK_EQ(fast->seek(500), 500);
+    CHECK_EQ(fast->read(100, buffer), 100);
+    CHECK(memcmp(buffer, &reference[500], 100 * sizeof(SAMPLE)) == 0);
+
+    //The fast cursor runs four rings ahead, so the idle one gets dropped.
+    for (int i = 0; i < 4 * 4 * 256 * 2 / 1000 + 1; i++) {
+        fast->read(1000, buffer);
+    }
+    CHECK(slow->isDetached());
+    CHECK(!fast->isDetached());
+    CHECK_EQ(slow->read(100, buffer), 0);
+
+    //A seek re-attaches it, and it reads the right audio from there.
+    int first = 0;
+    int end = 0;
+    fanOut.bufferedRange(&first, &end);
+    CHECK_EQ(slow->seek(first), first);
+    CHECK(!slow->isDetached());
+    CHECK_EQ(slow->read(100, buffer), 100);
+    CHECK(memcmp(buffer, &reference[first], 100 * sizeof(SAMPLE)) == 0);
+
+    //A seek outside the ring moves the decoder and detaches whoever is left behind.
+    CHECK_EQ(fast->seek(static_cast<int>(reference.size()) - 1000), static_cast<int>(reference.size()) - 1000);
+    CHECK_EQ(fast->read(1000, buffer), 1000);
+    CHECK(memcmp(buffer, &reference[reference.size() - 1000], 1000 * sizeof(SAMPLE)) == 0);
+    CHECK(slow->isDetached());
+    CHECK_EQ(fast->read(1000, buffer), 0);
+    delete fast;
+    delete slow;
+}
+
+int main()
+{
+    const std::string path = writeTestFile("test_fanout.wav", makeWav(kFrames, 2, 44100));
+    const std::vector<SAMPLE> reference = decodeAll(path);
+    CHECK_EQ(reference.size(), kFrames * 2);
+    testCursorsOnThreads(path, reference);
+    testSeekAndDetach(path, reference);
+    return testResult();
+}
@@ -0,0 +1,283 @@
+/*
+ * test_framescanner - AudioDecoderFrameScanner headers, sync search and frame offsets.
+ *
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+#include <stdlib.h>
+#include "audiodecoderframescanner.h"
+#include "audiodecodersource.h"
+#include "testing.h"
+
+/** A memory source without a mapping, so scan() reads it a chunk at a time. */
+class UnmappedSource : public AudioDecoderSource
+{
+    public:
+        explicit UnmappedSource(const TestBytes& file) : m_source(file.data(), file.size()) {}
+        virtual long long pread(void *buffer, long long size, long long offset) {
+            return m_source.pread(buffer, size, offset);
+        }
+        virtual long long size() const { return m_source.size(); }
+    private:
+        AudioDecoderMemorySource m_source;
+};
+
+/** An MPEG frame: the 4 header bytes, then zeros up to length. */
+static TestBytes mpegFrame(unsigned int b1, unsigned int b2, int length)
+{
+    TestBytes frame;
+    frame.u8(0xFF).u8(b1).u8(b2).u8(0x00).fill(0, length - 4);
+    return frame;
+}
+
+/** An ADTS frame, AAC LC, 44.1 kHz, stereo, no CRC. */
+static TestBytes adtsFrame(int length)
+{
+    TestBytes frame;
+    frame.u8(0xFF).u8(0xF1).u8(0x50).u8(0x80 | ((length >> 11) & 3))
+         .u8(length >> 3).u8(((length & 7) << 5) | 0x1F).u8(0xFC);
+    frame.fill(0, length - 7);
+    return frame;
+}
+
+/** Bytes that aren't audio, with a lone header in them that doesn't chain. */
+static TestBytes junk(size_t size)
+{
+    TestBytes bytes;
+    bytes.fill(0x20, size / 2).u8(0xFF).u8(0xFB).u8(0x90).u8(0x00).fill(0x20, size - size / 2 - 4);
+    return bytes;
+}
+
+static void testParseMpeg()
+{
+    AudioDecoderFrameHeader header;
+    const unsigned char l3[4] = { 0xFF, 0xFB, 0x90, 0x00 };
+    CHECK(AudioDecoderFrameScanner::parseMpegHeader(l3, &header));
+    CHECK_EQ(header.version, 1);
+    CHECK_EQ(header.layer, 3);
+    CHECK_EQ(header.bitrate, 128000);
+    CHECK_EQ(header.sampleRate, 44100);
+    CHECK_EQ(header.channels, 2);
+    CHECK_EQ(header.samplesPerFrame, 1152);
+    CHECK_EQ(header.frameLength, 417);
+    const unsigned char l3Padded[4] = { 0xFF, 0xFB, 0x92, 0xC0 };
+    CHECK(AudioDecoderFrameScanner::parseMpegHeader(l3Padded, &header));
+    CHECK_EQ(header.frameLength, 418);
+    CHECK_EQ(header.channels, 1);
+
+    //MPEG-2 layer III has half the samples per frame.
+    const unsigned char mpeg2[4] = { 0xFF, 0xF3, 0x80, 0x00 };
+    CHECK(AudioDecoderFrameScanner::parseMpegHeader(mpeg2, &header));
+    CHECK_EQ(header.version, 2);
+    CHECK_EQ(header.bitrate, 64000);
+    CHECK_EQ(header.sampleRate, 22050);
+    CHECK_EQ(header.samplesPerFrame, 576);
+    CHECK_EQ(header.frameLength, 208);
+
+    //Layer I counts 4-byte slots: 12 * 32000 / 44100 is 8 slots, not 8.7.
+    const unsigned char l1[4] = { 0xFF, 0xFF, 0x10, 0x00 };
+    CHECK(AudioDecoderFrameScanner::parseMpegHeader(l1, &header));
+    CHECK_EQ(header.layer, 1);
+    CHECK_EQ(header.samplesPerFrame, 384);
+    CHECK_EQ(header.frameLength, 32);
+    const unsigned char l1Padded[4] = { 0xFF, 0xFF, 0x12, 0x00 };
+    CHECK(AudioDecoderFrameScanner::parseMpegHeader(l1Padded, &header));
+    CHECK_EQ(header.frameLength, 36);
+    const unsigned char l1Fast[4] = { 0xFF, 0xFF, 0xE4, 0x00 }; // 448 kbps, 48 kHz
+    CHECK(AudioDecoderFrameScanner::parseMpegHeader(l1Fast, &header));
+    CHECK_EQ(header.frameLength, 448);
+
+    const unsigned char reservedVersion[4] = { 0xFF, 0xEB, 0x90, 0x00 };
+    const unsigned char reservedLayer[4] = { 0xFF, 0xF9, 0x90, 0x00 };
+    const unsigned char freeFormat[4] = { 0xFF, 0xFB, 0x00, 0x00 };
+    const unsigned char badBitrate[4] = { 0xFF, 0xFB, 0xF0, 0x00 };
+    const unsigned char badRate[4] = { 0xFF, 0xFB, 0x9C, 0x00 };
+    const unsigned char noSync[4] = { 0xFF, 0x1B, 0x90, 0x00 };
+    CHECK(!AudioDecoderFrameScanner::parseMpegHeader(reservedVersion, &header));
+    CHECK(!AudioDecoderFrameScanner::parseMpegHeader(reservedLayer, &header));
+    CHECK(!AudioDecoderFrameScanner::parseMpegHeader(freeFormat, &header));
+    CHECK(!AudioDecoderFrameScanner::parseMpegHeader(badBitrate, &header));
+    CHECK(!AudioDecoderFrameScanner::parseMpegHeader(badRate, &header));
+    CHECK(!AudioDecoderFrameScanner::parseMpegHeader(noSync, &header));
+}
+
+static void testParseAdts()
+{
+    AudioDecoderFrameHeader header;
+    TestBytes frame = adtsFrame(371);
+    CHECK(AudioDecoderFrameScanner::parseAdtsHeader(frame.data(), &header));
+    CHECK_EQ(header.version, 4);
+    CHECK_EQ(header.sampleRate, 44100);
+    CHECK_EQ(header.channels, 2);
+    CHECK_EQ(header.samplesPerFrame, 1024);
+    CHECK_EQ(header.frameLength, 371);
+
+    TestBytes tooShort = adtsFrame(7);
+    CHECK(!AudioDecoderFrameScanner::parseAdtsHeader(tooShort.data(), &header));
+    frame.bytes[2] = 0x50 | (13 << 2); // reserved sample rate
+    CHECK(!AudioDecoderFrameScanner::parseAdtsHeader(frame.data(), &header));
+}
+
+static void testFindSync()
+{
+    //Random bytes, heavy in 0xFF, against the plain byte-by-byte search, at
+    //every alignment and size around the 32-byte blocks.
+    srand(1);
+    unsigned char data[256];
+    for (int round = 0; round < 200; round++) {
+        for (size_t i = 0; i < sizeof(data); i++) {
+            data[i] = (rand() % 8) ? static_cast<unsigned char>(rand() % 0xE0) : 0xFF;
+        }
+        const int format = round % 2;
+        const unsigned char mask = format ? 0xF0 : 0xE0;
+        for (size_t start = 0; start < 40; start++) {
+            const size_t size = (start * 7 + round) % (sizeof(data) - start);
+            size_t expected = size;
+            for (size_t i = 0; i + 1 < size; i++) {
+                if (data[start + i] == 0xFF && (data[start + i + 1] & mask) == mask) {
+                    expected = i;
+                    break;
+                }
+            }
+            CHECK_EQ(AudioDecoderFrameScanner::findSync(data + start, size,
+                         format ? AudioDecoderFrameScanner::FORMAT_ADTS : AudioDecoderFrameScanner::FORMAT_MPEG),
+                     expected);
+        }
+    }
+}
+
+static void testScanMpeg()
+{
+    //Junk, 10 frames, more junk, 10 padded frames.
+    TestBytes stream = junk(100);
+    std::vector<long long> expected;
+    for (int i = 0; i < 10; i++) {
+        expected.push_back(stream.size());
+        stream.append(mpegFrame(0xFB, 0x90, 417));
+    }
+    stream.append(junk(57));
+    for (int i = 0; i < 10; i++) {
+        expected.push_back(stream.size());
+        stream.append(mpegFrame(0xFB, 0x92, 418));
+    }
+    AudioDecoderMemorySource source(stream.data(), stream.size());
+    AudioDecoderFrameIndex index;
+    CHECK_EQ(AudioDecoderFrameScanner::scan(&source, 0, stream.size(), AudioDecoderFrameScanner::FORMAT_MPEG,
+                                            &index), AUDIODECODER_OK);
+    CHECK_EQ(index.frames, 20);
+    CHECK_EQ(index.samples, 20 * 1152);
+    CHECK_EQ(index.bytes, 10 * 417 + 10 * 418);
+    CHECK(index.constantBitrate);
+    CHECK_EQ(index.first.frameLength, 417);
+    CHECK(index.offsets == expected);
+
+    //Without the offsets, the counts are the same.
+    CHECK_EQ(AudioDecoderFrameScanner::scan(&source, 0, stream.size(), AudioDecoderFrameScanner::FORMAT_MPEG,
+                                            &index, false), AUDIODECODER_OK);
+    CHECK_EQ(index.frames, 20);
+    CHECK(index.offsets.empty());
+
+    //A frame cut off by the end of the range isn't counted.
+    CHECK_EQ(AudioDecoderFrameScanner::scan(&source, 0, stream.size() - 1, AudioDecoderFrameScanner::FORMAT_MPEG,
+                                            &index), AUDIODECODER_OK);
+    CHECK_EQ(index.frames, 19);
+
+    //Layer I frames chain at their true length.
+    TestBytes layer1;
+    for (int i = 0; i < 10; i++) {
+        layer1.append(mpegFrame(0xFF, 0x10, 32));
+    }
+    AudioDecoderMemorySource layer1Source(layer1.data(), layer1.size());
+    CHECK_EQ(AudioDecoderFrameScanner::scan(&layer1Source, 0, layer1.size(), AudioDecoderFrameScanner::FORMAT_MPEG,
+                                            &index), AUDIODECODER_OK);
+    CHECK_EQ(index.frames, 10);
+    CHECK_EQ(index.samples, 10 * 384);
+
+    TestBytes nothing = junk(4096);
+    AudioDecoderMemorySource nothingSource(nothing.data(), nothing.size());
+    CHECK_EQ(AudioDecoderFrameScanner::scan(&nothingSource, 0, nothing.size(), AudioDecoderFrameScanner::FORMAT_MPEG,
+                                            &index), AUDIODECODER_ERROR);
+    CHECK_EQ(index.frames, 0);
+}
+
+static void testScanChunked()
+{
+    //Over a megabyte, read in chunks, so frames and junk straddle them.
+    TestBytes stream;
+    std::vector<long long> expected;
+    for (int i = 0; i < 3000; i++) {
+        if (i % 700 == 699) {
+            stream.append(junk(1000 + i));
+        }
+        expected.push_back(stream.size());
+        stream.append(i % 3 ? mpegFrame(0xFB, 0x90, 417) : mpegFrame(0xFB, 0xE0, 1044));
+    }
+    UnmappedSource source(stream);
+    AudioDecoderFrameIndex index;
+    CHECK_EQ(AudioDecoderFrameScanner::scan(&source, 0, stream.size(), AudioDecoderFrameScanner::FORMAT_MPEG,
+                                            &index), AUDIODECODER_OK);
+    CHECK_EQ(index.frames, 3000);
+    CHECK(!index.constantBitrate);
+    CHECK(index.offsets == expected);
+}
+
+static void testScanAdts()
+{
+    TestBytes stream = junk(33);
+    std::vector<long long> expected;
+    for (int i = 0; i < 12; i++) {
+        expected.push_back(stream.size());
+        stream.append(adtsFrame(200 + i * 10));
+    }
+    AudioDecoderMemorySource source(stream.data(), stream.size());
+    AudioDecoderFrameIndex index;
+    CHECK_EQ(AudioDecoderFrameScanner::scan(&source, 0, stream.size(), AudioDecoderFrameScanner::FORMAT_ADTS,
+                                            &index), AUDIODECODER_OK);
+    CHECK_EQ(index.frames, 12);
+    CHECK_EQ(index.samples, 12 * 1024);
+    CHECK(index.offsets == expected);
+}
+
+int main()
+{
+    testParseMpeg();
+    testParseAdts();
+    testFindSync();
+    testScanMpeg();
+    testScanChunked();
+    testScanAdts();
+    return testResult();
+}
@@ -0,0 +1,293 @@
+/*
+ * test_httpsource - AudioDecoderHttpSource against the loopback server.
+ *
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+#include <stdlib.h>
+#include <thread>
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET TestSocket;
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define closesocket close
+typedef int TestSocket;
+#endif
+#include "audiodecoderhttpsource.h"
+#include "testing.h"
+
+static std::vector<char> makeData(size_t size)
+{
+    std::vector<char> data(size);
+    unsigned int state = 12345;
+    for (size_t i = 0; i < size; i++) {
+        state = state * 1103515245 + 12345;
+        data[i] = static_cast<char>(state >> 16);
+    }
+    return data;
+}
+
+/** Reads every range and compares it with the data. */
+static bool readsMatch(AudioDecoderHttpSource& source, const std::vector<char>& data,
+                       const long long ranges[][2], int count)
+{
+    for (int i = 0; i < count; i++) {
+        std::vector<char> buffer(static_cast<size_t>(ranges[i][1]));
+        if (source.pread(&buffer[0], ranges[i][1], ranges[i][0]) != ranges[i][1] ||
+            memcmp(&buffer[0], &data[static_cast<size_t>(ranges[i][0])], buffer.size()) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Sends one request with the given Range header (on a connection of its
+    own; the server sets up sockets) and returns the whole response. */
+static std::string rawRequest(int port, const char *range)
+{
+    std::string response;
+    TestSocket s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<unsigned short>(port));
+    if (connect(s, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) == 0) {
+        std::string request = std::string("GET /audio HTTP/1.1\r\nHost: 127.0.0.1\r\nRange: ") +
+                              range + "\r\nConnection: close\r\n\r\n";
+        send(s, request.data(), static_cast<int>(request.size()), 0);
+        char chunk[4096];
+        int received;
+        while ((received = recv(s, chunk, sizeof(chunk), 0)) > 0) {
+            response.append(chunk, received);
+        }
+    }
+    closesocket(s);
+    return response;
+}
+
+static const long long kRanges[][2] = {
+    { 0, 100 }, { 100, 5000 }, { 5100, 70000 }, { 900000, 1000 }, { 12345, 1 },
+    { 300000, 200000 }, { 1000000 - 4096, 4096 }
+};
+static const int kNumRanges = sizeof(kRanges) / sizeof(kRanges[0]);
+
+static void testRangedReads()
+{
+    std::vector<char> data = makeData(1000000);
+    AudioDecoderLoopbackHttpServer server(&data[0], data.size());
+    CHECK_EQ(server.start(), AUDIODECODER_OK);
+    AudioDecoderHttpSource source(server.url(), 4096, 16, 8);
+    CHECK(source.isOpen());
+    CHECK_EQ(source.size(), 1000000);
+    CHECK(readsMatch(source, data, kRanges, kNumRanges));
+    //Only what was asked for (plus read-ahead) came over, on one connection.
+    CHECK(source.bytesFetched() < 1000000);
+    CHECK_EQ(server.connectionCount(), 1);
+}
+
+static void testServerWithoutRanges()
+{
+    std::vector<char> data = makeData(300000);
+    AudioDecoderLoopbackHttpServer server(&data[0], data.size());
+    server.setRangesSupported(false);
+    CHECK_EQ(server.start(), AUDIODECODER_OK);
+    AudioDecoderHttpSource source(server.url(), 4096);
+    CHECK(source.isOpen());
+    CHECK_EQ(source.size(), 300000);
+    const long long ranges[][2] = { { 0, 4096 }, { 250000, 50000 }, { 7, 3 } };
+    CHECK(readsMatch(source, data, ranges, 3));
+}
+
+static void testReconnect()
+{
+    std::vector<char> data = makeData(1000000);
+    AudioDecoderLoopbackHttpServer server(&data[0], data.size());
+    server.setMaxRequestsPerConnection(1);
+    CHECK_EQ(server.start(), AUDIODECODER_OK);
+    AudioDecoderHttpSource source(server.url(), 4096, 16, 8);
+    CHECK(readsMatch(source, data, kRanges, kNumRanges));
+    CHECK(server.connectionCount() > 1);
+    CHECK_EQ(server.connectionCount(), source.requestCount());
+}
+
+static void testEndOfFile()
+{
+    std::vector<char> data = makeData(10000);
+    AudioDecoderLoopbackHttpServer server(&data[0], data.size());
+    CHECK_EQ(server.start(), AUDIODECODER_OK);
+    AudioDecoderHttpSource source(server.url(), 4096);
+    char buffer[8192];
+    CHECK_EQ(source.pread(buffer, sizeof(buffer), 6000), 4000);
+    CHECK(memcmp(buffer, &data[6000], 4000) == 0);
+    CHECK_EQ(source.pread(buffer, sizeof(buffer), 10000), 0);
+    CHECK_EQ(source.pread(buffer, sizeof(buffer), 20000), 0);
+    CHECK_EQ(source.pread(buffer, 10, -1), -1);
+    source.seek(9995);
+    CHECK_EQ(source.read(buffer, 100), 5);
+    CHECK_EQ(source.read(buffer, 100), 0);
+}
+
+static void testSuffixRanges()
+{
+    std::vector<char> data = makeData(1000);
+    AudioDecoderLoopbackHttpServer server(&data[0], data.size());
+    CHECK_EQ(server.start(), AUDIODECODER_OK);
+
+    std::string response = rawRequest(server.port(), "bytes=-100");
+    CHECK(response.find("206 Partial Content") != std::string::npos);
+    CHECK(response.find("Content-Range: bytes 900-999/1000") != std::string::npos);
+    CHECK(response.size() >= 100 && memcmp(response.data() + response.size() - 100, &data[900], 100) == 0);
+
+    response = rawRequest(server.port(), "bytes=-5000");
+    CHECK(response.find("Content-Range: bytes 0-999/1000") != std::string::npos);
+    response = rawRequest(server.port(), "bytes=-0");
+    CHECK(response.find("416") != std::string::npos);
+    response = rawRequest(server.port(), "bytes=2000-");
+    CHECK(response.find("416") != std::string::npos);
+    response = rawRequest(server.port(), "bytes=500-100");
+    CHECK(response.find("200 OK") != std::string::npos);
+}
+
+static void testTimeout()
+{
+    std::vector<char> data = makeData(10000);
+    AudioDecoderLoopbackHttpServer server(&data[0], data.size());
+    server.setStalled(true);
+    CHECK_EQ(server.start(), AUDIODECODER_OK);
+    AudioDecoderHttpSource source(server.url(), 4096, 64, 16, 200);
+    CHECK(!source.isOpen());
+    char buffer[16];
+    CHECK_EQ(source.pread(buffer, sizeof(buffer), 0), -1);
+}
+
+static void testShiftedRanges()
+{
+    std::vector<char> data = makeData(1000000);
+    //A server that starts ranges early is fine; the extra bytes are skipped.
+    {
+        AudioDecoderLoopbackHttpServer server(&data[0], data.size());
+        server.setRangeShift(-1000);
+        CHECK_EQ(server.start(), AUDIODECODER_OK);
+        AudioDecoderHttpSource source(server.url(), 4096, 16, 8);
+        CHECK(source.isOpen());
+        CHECK(readsMatch(source, data, kRanges, kNumRanges));
+    }
+    //One that starts them late would put bytes at the wrong offsets.
+    {
+        AudioDecoderLoopbackHttpServer server(&data[0], data.size());
+        server.setRangeShift(100);
+        CHECK_EQ(server.start(), AUDIODECODER_OK);
+        AudioDecoderHttpSource source(server.url(), 4096, 16, 8);
+        CHECK(!source.isOpen());
+        char buffer[16];
+        CHECK_EQ(source.pread(buffer, sizeof(buffer), 5000), -1);
+    }
+}
+
+/** Returns the Host header the source sends to http://[::1]:port/, or an
+    empty string if there's no IPv6 loopback to listen on. */
+static std::string ipv6HostHeader(int *port)
+{
+    TestSocket listener = socket(AF_INET6, SOCK_STREAM, IPPROTO_TCP);
+    struct sockaddr_in6 address;
+    memset(&address, 0, sizeof(address));
+    address.sin6_family = AF_INET6;
+    address.sin6_addr = in6addr_loopback;
+    socklen_t length = sizeof(address);
+    if (bind(listener, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listener, 4) != 0 ||
+        getsockname(listener, reinterpret_cast<struct sockaddr*>(&address), &length) != 0) {
+        closesocket(listener);
+        return std::string();
+    }
+    *port = ntohs(address.sin6_port);
+
+    //Take the first request and hang up without answering it.
+    std::string headers;
+    std::thread server([&]() {
+        TestSocket s = accept(listener, NULL, NULL);
+        char chunk[1024];
+        int received;
+        while (headers.find("\r\n\r\n") == std::string::npos &&
+               (received = recv(s, chunk, sizeof(chunk), 0)) > 0) {
+            headers.append(chunk, received);
+        }
+        closesocket(s);
+    });
+    char url[64];
+    snprintf(url, sizeof(url), "http://[::1]:%d/audio", *port);
+    {
+        AudioDecoderHttpSource source(url, 4096, 64, 16, 200);
+    }
+    server.join();
+    closesocket(listener);
+
+    const size_t start = headers.find("Host: ");
+    if (start == std::string::npos) {
+        return "missing";
+    }
+    return headers.substr(start, headers.find("\r\n", start) - start);
+}
+
+static void testIpv6Host()
+{
+    int port = 0;
+    std::string host = ipv6HostHeader(&port);
+    if (!host.empty()) {
+        char expected[64];
+        snprintf(expected, sizeof(expected), "Host: [::1]:%d", port);
+        CHECK(host == expected);
+    }
+}
+
+int main()
+{
+    testRangedReads();
+    testServerWithoutRanges();
+    testReconnect();
+    testEndOfFile();
+    testSuffixRanges();
+    testTimeout();
+    testShiftedRanges();
+    testIpv6Host();
+    return testResult();
+}
@@ -0,0 +1,213 @@
+/*
+ * test_peakpyramid - AudioDecoderPeakPyramid bins after seeks against a linear build.
+ *
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include "audiodecoderpeakpyramid.h"
+#include "testing.h"
+
+const int kChannels = 2;
+const int kFrames = 20000;
+
+static std::vector<SAMPLE> makeSignal()
+{
+    std::vector<SAMPLE> signal(kFrames * kChannels);
+    for (int f = 0; f < kFrames; f++) {
+        signal[f * 2] = static_cast<SAMPLE>(sin(f * 0.01) * 0.8);
+        signal[f * 2 + 1] = static_cast<SAMPLE>(((f * 37) % 200 - 100) / 150.0);
+    }
+    return signal;
+}
+
+/** Feeds frames [first, last) in reads of an awkward size. */
+static void feed(AudioDecoderPeakPyramid& pyramid, const std::vector<SAMPLE>& signal, int first, int last)
+{
+    const int kReadFrames = 333;
+    for (int f = first; f < last; f += kReadFrames) {
+        const int frames = last - f < kReadFrames ? last - f : kReadFrames;
+        pyramid.process(&signal[f * kChannels], frames * kChannels);
+    }
+}
+
+static void checkSameBins(const AudioDecoderPeakPyramid& a, const AudioDecoderPeakPyramid& b)
+{
+    CHECK_EQ(a.numLevels(), b.numLevels());
+    for (int level = 0; level < a.numLevels(); level++) {
+        CHECK_EQ(a.numBins(level), b.numBins(level));
+        bool same = a.numBins(level) == b.numBins(level);
+        for (long long i = 0; same && i < a.numBins(level) * kChannels * 3; i++) {
+            same = a.bins(level)[i] == b.bins(level)[i];
+        }
+        CHECK(same);
+        for (long long bin = 0; bin < a.numBins(level); bin++) {
+            CHECK(!a.isPartial(level, bin));
+            CHECK(!b.isPartial(level, bin));
+        }
+    }
+}
+
+/** Every stored bin against min, max and RMS worked out from the frames of
+    it that were decoded, frames [0, seekFrom) and [seekTo, kFrames). */
+static void checkBins(const AudioDecoderPeakPyramid& pyramid, const std::vector<SAMPLE>& signal,
+                      int seekFrom, int seekTo)
+{
+    for (int level = 0; level < pyramid.numLevels(); level++) {
+        const int binSize = pyramid.framesPerBin(level);
+        for (long long bin = 0; bin < pyramid.numBins(level); bin++) {
+            const int begin = static_cast<int>(bin * binSize);
+            const int end = begin + binSize < kFrames ? begin + binSize : kFrames;
+            int decoded = 0;
+            for (int c = 0; c < kChannels; c++) {
+                float lo = 1, hi = -1;
+                double squares = 0;
+                decoded = 0;
+                for (int f = begin; f < end; f++) {
+                    if (f >= seekFrom && f < seekTo) {
+                        continue;
+                    }
+                    const float v = signal[f * kChannels + c];
+                    lo = v < lo ? v : lo;
+                    hi = v > hi ? v : hi;
+                    squares += v * v;
+                    decoded++;
+                }
+                if (decoded == 0) {
+                    break; // never filled
+                }
+                const short *values = pyramid.bins(level) + (bin * kChannels + c) * 3;
+                CHECK_EQ(values[0], floor(lo * 32767.0 + 0.5));
+                CHECK_EQ(values[1], floor(hi * 32767.0 + 0.5));
+                CHECK(abs(values[2] - static_cast<int>(floor(sqrt(squares / decoded) * 32767.0 + 0.5))) <= 2);
+            }
+            CHECK_EQ(pyramid.isPartial(level, bin), decoded > 0 && decoded < end - begin);
+        }
+    }
+}
+
+static void testNoOpSeek()
+{
+    //A constant signal with a seek to where the decode already is.
+    std::vector<SAMPLE> constant(kFrames * kChannels, 0.5f);
+    AudioDecoderPeakPyramid linear;
+    linear.begin(kChannels, 44100);
+    feed(linear, constant, 0, kFrames);
+    linear.finish();
+
+    AudioDecoderPeakPyramid seeked;
+    seeked.begin(kChannels, 44100);
+    feed(seeked, constant, 0, 100);
+    seeked.seeked(100 * kChannels);
+    feed(seeked, constant, 100, kFrames);
+    seeked.finish();
+    checkSameBins(seeked, linear);
+    for (int level = 0; level < seeked.numLevels(); level++) {
+        const short *bin = seeked.bins(level) + (100 / seeked.framesPerBin(level)) * kChannels * 3;
+        CHECK_EQ(bin[0], 16384);
+        CHECK_EQ(bin[1], 16384);
+        CHECK_EQ(bin[2], 16384);
+    }
+}
+
+static void testSeekBack()
+{
+    //Back to the start and all the way through: the same as never seeking.
+    const std::vector<SAMPLE> signal = makeSignal();
+    AudioDecoderPeakPyramid linear;
+    linear.begin(kChannels, 44100);
+    feed(linear, signal, 0, kFrames);
+    linear.finish();
+    checkBins(linear, signal, kFrames, kFrames);
+
+    AudioDecoderPeakPyramid seeked;
+    seeked.begin(kChannels, 44100);
+    feed(seeked, signal, 0, 3000);
+    seeked.seeked(0);
+    feed(seeked, signal, 0, kFrames);
+    seeked.finish();
+    checkSameBins(seeked, linear);
+
+    //Back within the bin being filled starts that bin over.
+    AudioDecoderPeakPyramid within;
+    within.begin(kChannels, 44100);
+    feed(within, signal, 0, 4000);
+    within.seeked(3900 * kChannels);
+    feed(within, signal, 3900, kFrames);
+    within.finish();
+    CHECK_EQ(within.numBins(2), linear.numBins(2));
+    for (long long i = 3 * kChannels; i < linear.numBins(2) * kChannels * 3; i++) {
+        CHECK_EQ(within.bins(2)[i], linear.bins(2)[i]); // from bin 1 on
+    }
+}
+
+static void testSeekForward()
+{
+    //Frames 1000 to 5000 are skipped: the bins around the gap only have
+    //what was decoded and are flagged, the rest match a linear build.
+    const std::vector<SAMPLE> signal = makeSignal();
+    AudioDecoderPeakPyramid pyramid;
+    pyramid.begin(kChannels, 44100);
+    feed(pyramid, signal, 0, 1000);
+    pyramid.seeked(5000 * kChannels);
+    feed(pyramid, signal, 5000, kFrames);
+    pyramid.finish();
+    checkBins(pyramid, signal, 1000, 5000);
+    CHECK(pyramid.isPartial(0, 15));
+    CHECK(pyramid.isPartial(0, 78));
+    CHECK(!pyramid.isPartial(0, 79));
+    CHECK(pyramid.isPartial(2, 0));
+    CHECK(pyramid.isPartial(2, 1));
+    CHECK(!pyramid.isPartial(2, 2));
+
+    //Forward within the bin being filled keeps what it has.
+    AudioDecoderPeakPyramid within;
+    within.begin(kChannels, 44100);
+    feed(within, signal, 0, 1000);
+    within.seeked(1010 * kChannels);
+    feed(within, signal, 1010, kFrames);
+    within.finish();
+    checkBins(within, signal, 1000, 1010);
+}
+
+int main()
+{
+    testNoOpSeek();
+    testSeekBack();
+    testSeekForward();
+    return testResult();
+}
@@ -0,0 +1,373 @@
+/*
+ * test_probe - AudioDecoderProbe against fixtures for each container.
+ *
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+#include "audiodecoderprobe.h"
+#include "audiodecodersource.h"
+#include "testing.h"
+
+static int probe(const TestBytes& file, AudioStreamInfo *info, bool countFrames = false)
+{
+    AudioDecoderMemorySource source(file.data(), file.size());
+    return AudioDecoderProbe::probe(&source, info, countFrames);
+}
+
+/** Counts the bytes the probe reads. */
+class CountingSource : public AudioDecoderSource
+{
+    public:
+        explicit CountingSource(const TestBytes& file) : m_source(file.data(), file.size()), m_bytesRead(0) {}
+        virtual long long pread(void *buffer, long long size, long long offset) {
+            long long read = m_source.pread(buffer, size, offset);
+            m_bytesRead += read > 0 ? read : 0;
+            return read;
+        }
+        virtual long long size() const { return m_source.size(); }
+        long long bytesRead() const { return m_bytesRead; }
+    private:
+        AudioDecoderMemorySource m_source;
+        long long m_bytesRead;
+};
+
+/** An MPEG-1 layer III frame, 128 kbps, 44.1 kHz, stereo: 417 bytes with
+    no padding. The body is zeros unless a tag is written into it. */
+static TestBytes mp3Frame(const TestBytes& body = TestBytes())
+{
+    TestBytes frame;
+    frame.u8(0xFF).u8(0xFB).u8(0x90).u8(0x00);
+    frame.append(body);
+    frame.fill(0, 417 - frame.size());
+    return frame;
+}
+
+static TestBytes mp3Frames(int count)
+{
+    TestBytes frames;
+    for (int i = 0; i < count; i++) {
+        frames.append(mp3Frame());
+    }
+    return frames;
+}
+
+/** 128 kbps CBR as an encoder writes it: padded frames keep the average
+    at 417.96 bytes. */
+static TestBytes mp3CbrFrames(int count)
+{
+    TestBytes frames;
+    for (long long i = 0; i < count; i++) {
+        const bool padded = (i + 1) * 18432000 / 44100 - i * 18432000 / 44100 == 418;
+        frames.u8(0xFF).u8(0xFB).u8(padded ? 0x92 : 0x90).u8(0x00).fill(0, padded ? 414 : 413);
+    }
+    return frames;
+}
+
+/** The same at 320 kbps: 1044 bytes. */
+static TestBytes mp3Frames320(int count)
+{
+    TestBytes frames;
+    for (int i = 0; i < count; i++) {
+        frames.u8(0xFF).u8(0xFB).u8(0xE0).u8(0x00).fill(0, 1044 - 4);
+    }
+    return frames;
+}
+
+/** An MP4 box around a payload. */
+static TestBytes box(const char *type, const TestBytes& payload)
+{
+    TestBytes b;
+    b.be32(static_cast<unsigned int>(8 + payload.size())).str(type).append(payload);
+    return b;
+}
+
+static TestBytes mp4Track(const char *handler, unsigned int timescale, unsigned int duration)
+{
+    TestBytes mdhd;
+    mdhd.be32(0).be32(0).be32(0).be32(timescale).be32(duration).be32(0);
+    TestBytes hdlr;
+    hdlr.be32(0).be32(0).str(handler).fill(0, 13);
+    TestBytes entry; // an AudioSampleEntry, or near enough for a video track
+    entry.be32(36).str(strcmp(handler, "soun") == 0 ? "mp4a" : "avc1").fill(0, 6).be16(1)
+         .fill(0, 8).be16(2).be16(16).be16(0).be16(0).be32(timescale << 16);
+    TestBytes stsd;
+    stsd.be32(0).be32(1).append(entry);
+    TestBytes tkhd;
+    tkhd.fill(0, 84);
+    return box("trak", TestBytes().append(box("tkhd", tkhd)).append(
+        box("mdia", TestBytes().append(box("mdhd", mdhd)).append(box("hdlr", hdlr)).append(
+            box("minf", box("stbl", box("stsd", stsd)))))));
+}
+
+static void testWav()
+{
+    AudioStreamInfo info;
+    CHECK_EQ(probe(makeWav(1000, 2, 44100), &info), AUDIODECODER_OK);
+    CHECK_EQ(info.format, AudioStreamInfo::FORMAT_WAV);
+    CHECK_EQ(info.sampleRate, 44100);
+    CHECK_EQ(info.channels, 2);
+    CHECK_EQ(info.bitsPerSample, 16);
+    CHECK_EQ(info.numSamples, 2000);
+
+    //An odd-sized chunk before the data is padded to a word boundary.
+    TestBytes wav;
+    wav.str("RIFF").le32(0).str("WAVE");
+    wav.str("fmt ").le32(16).le16(1).le16(1).le32(8000).le32(16000).le16(2).le16(16);
+    wav.str("LIST").le32(3).str("abc").u8(0);
+    wav.str("data").le32(200).fill(0, 200);
+    CHECK_EQ(probe(wav, &info), AUDIODECODER_OK);
+    CHECK_EQ(info.numSamples, 100);
+    CHECK_EQ(info.sampleRate, 8000);
+}
+
+static void testAiff()
+{
+    TestBytes aiff;
+    aiff.str("FORM").be32(0).str("AIFF");
+    aiff.str("COMM").be32(18).be16(2).be32(500).be16(16)
+        .u8(0x40).u8(0x0E).u8(0xAC).u8(0x44).fill(0, 6); // 44100 as an 80-bit float
+    aiff.str("SSND").be32(8 + 2000).fill(0, 8 + 2000);
+    AudioStreamInfo info;
+    CHECK_EQ(probe(aiff, &info), AUDIODECODER_OK);
+    CHECK_EQ(info.format, AudioStreamInfo::FORMAT_AIFF);
+    CHECK_EQ(info.sampleRate, 44100);
+    CHECK_EQ(info.channels, 2);
+    CHECK_EQ(info.numSamples, 1000);
+}
+
+static void testMp3()
+{
+    AudioStreamInfo info;
+    //No header to say how long it is, so it's estimated from the bitrate.
+    CHECK_EQ(probe(mp3Frames(20), &info), AUDIODECODER_OK);
+    CHECK_EQ(info.format, AudioStreamInfo::FORMAT_MP3);
+    CHECK_EQ(info.sampleRate, 44100);
+    CHECK_EQ(info.channels, 2);
+    CHECK_EQ(info.bitrate, 128000);
+    CHECK_EQ(info.numSamples, 20 * 1152 * 2);
+    CHECK(!info.lengthIsExact);
+
+    //ID3v2 in front and ID3v1 at the end are skipped.
+    TestBytes tagged;
+    tagged.str("ID3").u8(3).u8(0).u8(0).u8(0).u8(0).u8(1).u8(0).fill(0, 128); // 128 bytes of tag
+    tagged.append(mp3Frames(20));
+    tagged.str("TAG").fill(' ', 125);
+    CHECK_EQ(probe(tagged, &info), AUDIODECODER_OK);
+    CHECK_EQ(info.numSamples, 20 * 1152 * 2);
+
+    //A Xing header gives the frame count; its own frame isn't audio.
+    TestBytes xing;
+    xing.fill(0, 32).str("Xing").be32(0x3).be32(100).be32(100 * 417);
+    TestBytes vbr = mp3Frame(xing);
+    vbr.append(mp3Frames(10));
+    CHECK_EQ(probe(vbr, &info), AUDIODECODER_OK);
+    CHECK_EQ(info.numSamples, 100 * 1152 * 2);
+    CHECK(info.lengthIsExact);
+
+    //So does a VBRI header, always 32 bytes after the frame header.
+    TestBytes vbri;
+    vbri.fill(0, 32).str("VBRI").be16(1).be16(0).be16(75).be32(90 * 417).be32(90);
+    TestBytes fhg = mp3Frame(vbri);
+    fhg.append(mp3Frames(10));
+    CHECK_EQ(probe(fhg, &info), AUDIODECODER_OK);
+    CHECK_EQ(info.numSamples, 90 * 1152 * 2);
+    CHECK(info.lengthIsExact);
+}
+
+static void testLame()
+{
+    //A LAME tag after the Xing fields: 576 frames of delay, 1000 of
+    //padding, packed into 12 bits each at offsets 21-23.
+    TestBytes xing;
+    xing.fill(0, 32).str("Xing").be32(0x3).be32(100).be32(100 * 417)
+        .str("LAME3.100").fill(0, 12).u8(576 >> 4).u8(((576 & 0x0F) << 4) | (1000 >> 8)).u8(1000 & 0xFF);
+    TestBytes file = mp3Frame(xing);
+    file.append(mp3Frames(10));
+    AudioStreamInfo info;
+    CHECK_EQ(probe(file, &info), AUDIODECODER_OK);
+    CHECK_EQ(info.encoderDelay, 576);
+    CHECK_EQ(info.encoderPadding, 1000);
+    CHECK_EQ(info.numSamples, (100 * 1152 - 576 - 1000) * 2);
+
+    //Delay and padding longer than the file are ignored.
+    TestBytes bogus;
+    bogus.fill(0, 32).str("Xing").be32(0x1).be32(1)
+         .str("LAME3.100").fill(0, 12).u8(0xFF).u8(0xFF).u8(0xFF);
+    file = mp3Frame(bogus);
+    file.append(mp3Frames(10));
+    CHECK_EQ(probe(file, &info), AUDIODECODER_OK);
+    CHECK_EQ(info.encoderDelay, 0);
+    CHECK_EQ(info.encoderPadding, 0);
+    CHECK_EQ(info.numSamples, 1152 * 2);
+}
+
+static void testCountFrames()
+{
+    //VBR with no header: the estimate goes by the first frame's bitrate,
+    //so it's wrong, and counting the frames fixes it.
+    TestBytes vbr = mp3Frames(10);
+    vbr.append(mp3Frames320(10));
+    AudioStreamInfo info;
+    CHECK_EQ(probe(vbr, &info), AUDIODECODER_OK);
+    CHECK(!info.lengthIsExact);
+    CHECK(info.numSamples != 20 * 1152 * 2);
+    CHECK_EQ(probe(vbr, &info, true), AUDIODECODER_OK);
+    CHECK(info.lengthIsExact);
+    CHECK_EQ(info.numSamples, 20 * 1152 * 2);
+
+    //A damaged stream fails the count rather than coming out short.
+    TestBytes damaged = mp3Frames(2);
+    damaged.fill(0x55, 64);
+    CHECK_EQ(probe(damaged, &info, true), AUDIODECODER_ERROR);
+
+    //Without countFrames, only the headers are read, however long the file.
+    TestBytes cbr = mp3CbrFrames(2000);
+    CountingSource source(cbr);
+    CHECK_EQ(AudioDecoderProbe::probe(&source, &info), AUDIODECODER_OK);
+    CHECK_EQ(info.numSamples, 2000 * 1152 * 2);
+    CHECK(source.bytesRead() < 128 * 1024);
+}
+
+static void testSniff()
+{
+    TestBytes wavFile = makeWav(16, 2, 44100);
+    AudioDecoderMemorySource wav(wavFile.data(), wavFile.size());
+    CHECK_EQ(AudioDecoderProbe::sniff(&wav), AudioStreamInfo::FORMAT_WAV);
+    TestBytes frames = mp3Frames(4);
+    AudioDecoderMemorySource mp3(frames.data(), frames.size());
+    CHECK_EQ(AudioDecoderProbe::sniff(&mp3), AudioStreamInfo::FORMAT_MP3);
+    TestBytes flac = TestBytes().str("fLaC").fill(0, 12).append(mp3Frames(4));
+    AudioDecoderMemorySource other(flac.data(), flac.size());
+    CHECK_EQ(AudioDecoderProbe::sniff(&other), AudioStreamInfo::FORMAT_UNKNOWN);
+}
+
+static void testMp4()
+{
+    TestBytes ftyp;
+    ftyp.str("M4A ").be32(0).str("M4A isom");
+    TestBytes mvhd;
+    mvhd.fill(0, 100);
+
+    //A video track first: the audio track after it must still be found.
+    TestBytes moov;
+    moov.append(box("mvhd", mvhd)).append(mp4Track("vide", 90000, 900000))
+        .append(mp4Track("soun", 44100, 441000));
+    TestBytes mp4;
+    mp4.append(box("ftyp", ftyp)).append(box("moov", moov)).append(box("mdat", TestBytes().fill(0, 64)));
+
+    AudioStreamInfo info;
+    CHECK_EQ(probe(mp4, &info), AUDIODECODER_OK);
+    CHECK_EQ(info.format, AudioStreamInfo::FORMAT_MP4);
+    CHECK_EQ(info.sampleRate, 44100);
+    CHECK_EQ(info.channels, 2);
+    CHECK_EQ(info.numSamples, 441000 * 2);
+
+    //No sound track at all.
+    TestBytes silentMoov;
+    silentMoov.append(mp4Track("vide", 90000, 900000)).append(mp4Track("text", 1000, 10000));
+    TestBytes video;
+    video.append(box("ftyp", ftyp)).append(box("moov", silentMoov));
+    CHECK_EQ(probe(video, &info), AUDIODECODER_ERROR);
+}
+
+static TestBytes asf(unsigned int filePropertiesSize)
+{
+    static const unsigned char kHeader[16] = { 0x30, 0x26, 0xB2, 0x75, 0x8E, 0x66, 0xCF, 0x11,
+                                               0xA6, 0xD9, 0x00, 0xAA, 0x00, 0x62, 0xCE, 0x6C };
+    static const unsigned char kFileProperties[16] = { 0xA1, 0xDC, 0xAB, 0x8C, 0x47, 0xA9, 0xCF, 0x11,
+                                                       0x8E, 0xE4, 0x00, 0xC0, 0x0C, 0x20, 0x53, 0x65 };
+    static const unsigned char kStreamProperties[16] = { 0x91, 0x07, 0xDC, 0xB7, 0xB7, 0xA9, 0xCF, 0x11,
+                                                         0x8E, 0xE6, 0x00, 0xC0, 0x0C, 0x20, 0x53, 0x65 };
+    static const unsigned char kAudioMedia[16] = { 0x40, 0x9E, 0x69, 0xF8, 0x4D, 0x5B, 0xCF, 0x11,
+                                                   0xA8, 0xFD, 0x00, 0x80, 0x5F, 0x5C, 0x44, 0x2B };
+    TestBytes fileProperties;
+    fileProperties.raw(kFileProperties, 16).le64(filePropertiesSize).fill(0, 40)
+                  .le64(130000000ULL)  // play duration: 10 s plus the preroll, in 100 ns
+                  .le64(0).le64(3000); // send duration, preroll in ms
+    fileProperties.bytes.resize(filePropertiesSize);
+    TestBytes streamProperties;
+    streamProperties.raw(kStreamProperties, 16).le64(96).raw(kAudioMedia, 16).fill(0, 16)
+                    .le64(0).le32(18).le32(0).le16(1).le32(0);
+    streamProperties.le16(0x161).le16(2).le32(44100).le32(16000).le16(4096).le16(16).le16(0);
+
+    TestBytes header;
+    header.raw(kHeader, 16).le64(30 + fileProperties.size() + streamProperties.size())
+          .le32(2).u8(1).u8(2);
+    return header.append(fileProperties).append(streamProperties);
+}
+
+static void testWma()
+{
+    AudioStreamInfo info;
+    CHECK_EQ(probe(asf(104), &info), AUDIODECODER_OK);
+    CHECK_EQ(info.format, AudioStreamInfo::FORMAT_WMA);
+    CHECK_EQ(info.sampleRate, 44100);
+    CHECK_EQ(info.channels, 2);
+    CHECK_EQ(info.bitrate, 128000);
+    CHECK_EQ(info.numSamples, 441000 * 2);
+
+    //A File Properties object too short to hold a duration.
+    CHECK_EQ(probe(asf(64), &info), AUDIODECODER_ERROR);
+}
+
+static void testRejects()
+{
+    AudioStreamInfo info;
+    //Containers we don't parse aren't taken for MP3, even with frames inside.
+    CHECK_EQ(probe(TestBytes().str("fLaC").fill(0, 12).append(mp3Frames(4)), &info), AUDIODECODER_ERROR);
+    CHECK_EQ(probe(TestBytes().str("OggS").fill(0, 12).append(mp3Frames(4)), &info), AUDIODECODER_ERROR);
+    TestBytes id3Flac;
+    id3Flac.str("ID3").u8(3).u8(0).u8(0).u8(0).u8(0).u8(0).u8(16).fill(0, 16)
+           .str("fLaC").fill(0, 12).append(mp3Frames(4));
+    CHECK_EQ(probe(id3Flac, &info), AUDIODECODER_ERROR);
+
+    CHECK_EQ(probe(TestBytes().fill(0, 4096), &info), AUDIODECODER_ERROR);
+    CHECK_EQ(probe(TestBytes().str("RIFF"), &info), AUDIODECODER_ERROR);
+}
+
+int main()
+{
+    testWav();
+    testAiff();
+    testMp3();
+    testLame();
+    testCountFrames();
+    testSniff();
+    testMp4();
+    testWma();
+    testRejects();
+    return testResult();
+}
@@ -0,0 +1,171 @@
+/*
+ * test_scheduler - AudioDecoderScheduler streams, seeks and synchronized reads.
+ *
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+#include <chrono>
+#include <thread>
+#include "audiodecoder.h"
+#include "audiodecoderscheduler.h"
+#include "testing.h"
+
+//Short enough that every sample of the ramp in makeWav() is different, so
+//audio from the wrong position can't pass for the right one.
+static const int kFrames = 30000;
+
+static std::vector<SAMPLE> decodeAll(const std::string& path)
+{
+    AudioDecoder decoder(path);
+    std::vector<SAMPLE> samples;
+    if (decoder.open() != AUDIODECODER_OK) {
+        return samples;
+    }
+    SAMPLE buffer[4096];
+    int got;
+    while ((got = decoder.read(4096, buffer)) > 0) {
+        samples.insert(samples.end(), buffer, buffer + got);
+    }
+    return samples;
+}
+
+/** Reads until the stream has something, as the audio thread would keep
+    asking, and returns how much it got. */
+static int readWhenReady(AudioDecoderScheduler& scheduler, int id, int size, SAMPLE *buffer)
+{
+    for (int attempt = 0; attempt < 5000; attempt++) {
+        const int got = scheduler.read(id, size, buffer);
+        if (got > 0 || scheduler.isFinished(id)) {
+            return got;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return 0;
+}
+
+static void testWholeStream(const std::string& path, const std::vector<SAMPLE>& reference)
+{
+    AudioDecoder decoder(path);
+    CHECK_EQ(decoder.open(), AUDIODECODER_OK);
+    AudioDecoderScheduler scheduler(2, 256);
+    const int id = scheduler.addStream(&decoder, 2048);
+    CHECK(id >= 0);
+    std::vector<SAMPLE> samples;
+    SAMPLE buffer[1000];
+    int got;
+    while ((got = readWhenReady(scheduler, id, 1000, buffer)) > 0) {
+        samples.insert(samples.end(), buffer, buffer + got);
+    }
+    CHECK(samples == reference);
+    CHECK(scheduler.isFinished(id));
+    scheduler.removeStream(id);
+}
+
+/** After every seek, however many came before it unserved, the first audio
+    read must come from the last target, never from an earlier position. */
+static void testSeekSerials(const std::string& path, const std::vector<SAMPLE>& reference)
+{
+    AudioDecoder decoder(path);
+    CHECK_EQ(decoder.open(), AUDIODECODER_OK);
+    AudioDecoderScheduler scheduler(2, 256);
+    const int id = scheduler.addStream(&decoder, 4096);
+    SAMPLE buffer[512];
+    unsigned int state = 1;
+    for (int i = 0; i < 200; i++) {
+        int target = 0;
+        const int seeks = 1 + i % 3;
+        for (int s = 0; s < seeks; s++) {
+            state = state * 1103515245 + 12345;
+            target = static_cast<int>((state >> 8) % (kFrames - 1000)) * 2;
+            CHECK_EQ(scheduler.seek(id, target), target);
+        }
+        const int got = readWhenReady(scheduler, id, 512, buffer);
+        CHECK(got > 0);
+        if (got <= 0 || memcmp(buffer, &reference[target], got * sizeof(SAMPLE)) != 0) {
+            fprintf(stderr, "wrong audio after seek %d to %d\n", i, target);
+            g_testFailures++;
+            break;
+        }
+    }
+    //An odd target is rounded down to a whole frame.
+    CHECK_EQ(scheduler.seek(id, 1001), 1000);
+    CHECK(readWhenReady(scheduler, id, 2, buffer) == 2 && buffer[0] == reference[1000]);
+    scheduler.removeStream(id);
+}
+
+static void testSynchronized(const std::string& path, const std::vector<SAMPLE>& reference)
+{
+    AudioDecoder first(path);
+    AudioDecoder second(path);
+    CHECK_EQ(first.open(), AUDIODECODER_OK);
+    CHECK_EQ(second.open(), AUDIODECODER_OK);
+    AudioDecoderScheduler scheduler(2, 256);
+    const int ids[2] = { scheduler.addStream(&first, 2048), scheduler.addStream(&second, 8192) };
+    scheduler.seek(ids[1], 0);
+    std::vector<SAMPLE> a(800);
+    std::vector<SAMPLE> b(800);
+    SAMPLE *const buffers[2] = { &a[0], &b[0] };
+    long long frames = 0;
+    while (frames < kFrames) {
+        const int got = scheduler.readSynchronized(ids, 2, 400, buffers);
+        if (got == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        //Both streams advance together, and both from the right place.
+        if (memcmp(&a[0], &reference[frames * 2], got * 2 * sizeof(SAMPLE)) != 0 ||
+            memcmp(&b[0], &a[0], got * 2 * sizeof(SAMPLE)) != 0) {
+            fprintf(stderr, "streams out of step at frame %lld\n", frames);
+            g_testFailures++;
+            break;
+        }
+        frames += got;
+    }
+    CHECK_EQ(frames, kFrames);
+    scheduler.removeStream(ids[0]);
+    scheduler.removeStream(ids[1]);
+}
+
+int main()
+{
+    const std::string path = writeTestFile("test_scheduler.wav", makeWav(kFrames, 2, 44100));
+    const std::vector<SAMPLE> reference = decodeAll(path);
+    CHECK_EQ(reference.size(), kFrames * 2);
+    testWholeStream(path, reference);
+    testSeekSerials(path, reference);
+    testSynchronized(path, reference);
+    return testResult();
+}
@@ -0,0 +1,146 @@
+/*
+ * testing.h - The few helpers the libaudiodecoder tests share.
+ *
+ * libaudiodecoder - Native Portable Audio Decoder Library
+ * Latest version available at: http://www.oscillicious.com/libaudiodecoder
+ *
+ * Copyright (c) 2010-2024 Albert Santoni, Bill Good, RJ Ryan
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire libaudiodecoder license; however,
+ * the Oscillicious community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+/*
+ * Each test is a plain executable that ctest runs. CHECK() and CHECK_EQ()
+ * print the failures and carry on; main() returns testResult(), which is
+ * non-zero if anything failed. Fixtures are built in memory byte by byte,
+ * so no media files ship with the tests.
+ */
+
+#ifndef AUDIODECODER_TESTING_H
+#define AUDIODECODER_TESTING_H
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+static int g_testFailures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            g_testFailures++; \
+        } \
+    } while (0)
+
+#define CHECK_EQ(actual, expected) \
+    do { \
+        const long long a_ = static_cast<long long>(actual); \
+        const long long e_ = static_cast<long long>(expected); \
+        if (a_ != e_) { \
+            fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", \
+                    __FILE__, __LINE__, #actual, #expected, a_, e_); \
+            g_testFailures++; \
+        } \
+    } while (0)
+
+inline int testResult()
+{
+    if (g_testFailures) {
+        fprintf(stderr, "%d check(s) failed\n", g_testFailures);
+        return 1;
+    }
+    return 0;
+}
+
+/** A file being built up in memory. */
+class TestBytes
+{
+    public:
+        TestBytes& str(const char *s) { return raw(s, strlen(s)); }
+        TestBytes& raw(const void *data, size_t size)
+        {
+            const unsigned char *p = static_cast<const unsigned char*>(data);
+            bytes.insert(bytes.end(), p, p + size);
+            return *this;
+        }
+        TestBytes& fill(unsigned char value, size_t count) { bytes.insert(bytes.end(), count, value); return *this; }
+        TestBytes& u8(unsigned int v) { bytes.push_back(static_cast<unsigned char>(v)); return *this; }
+        TestBytes& le16(unsigned int v) { return u8(v).u8(v >> 8); }
+        TestBytes& le32(unsigned int v) { return le16(v).le16(v >> 16); }
+        TestBytes& le64(unsigned long long v) { return le32(static_cast<unsigned int>(v)).le32(static_cast<unsigned int>(v >> 32)); }
+        TestBytes& be16(unsigned int v) { return u8(v >> 8).u8(v); }
+        TestBytes& be32(unsigned int v) { return be16(v >> 16).be16(v); }
+        TestBytes& append(const TestBytes& other) { return raw(other.data(), other.size()); }
+
+        /** Overwrites 4 bytes already written, eg. a size once it's known. */
+        void patchBe32(size_t offset, unsigned int v)
+        {
+            for (int i = 0; i < 4; i++) {
+                bytes[offset + i] = static_cast<unsigned char>(v >> (24 - 8 * i));
+            }
+        }
+
+        const unsigned char *data() const { return bytes.empty() ? NULL : &bytes[0]; }
+        size_t size() const { return bytes.size(); }
+
+        std::vector<unsigned char> bytes;
+};
+
+/** A 16-bit PCM WAV file holding a ramp, so every sample is different. */
+inline TestBytes makeWav(int frames, int channels, int sampleRate)
+{
+    TestBytes wav;
+    const unsigned int dataSize = static_cast<unsigned int>(frames * channels * 2);
+    wav.str("RIFF").le32(36 + dataSize).str("WAVE");
+    wav.str("fmt ").le32(16).le16(1).le16(channels).le32(sampleRate)
+       .le32(sampleRate * channels * 2).le16(channels * 2).le16(16);
+    wav.str("data").le32(dataSize);
+    for (int i = 0; i < frames * channels; i++) {
+        wav.le16(static_cast<unsigned int>((i * 7) % 65536 - 32768));
+    }
+    return wav;
+}
+
+/** Writes bytes to a file in the current directory and returns its name. */
+inline std::string writeTestFile(const std::string& name, const TestBytes& contents)
+{
+    FILE *f = fopen(name.c_str(), "wb");
+    if (!f) {
+        return std::string();
+    }
+    fwrite(contents.data(), 1, contents.size(), f);
+    fclose(f);
+    return name;
+}
+
+#endif // AUDIODECODER_TESTING_H